@@ -61,6 +61,15 @@
 #include "wled_integration.h"
 #include "audio_manager.h"
 #include "lidar_sensor.h"
+#include "live_stream.h"
+#include "race_log.h"
+#include "run_log.h"
+#include "leaderboard.h"
+#include "profiler.h"
+#include "heap_track.h"
+#include "soak_test.h"
+#include "storage.h"
+#include "boot_timing.h"
 #include "web_server.h"
 
 // ============================================================================
@@ -87,6 +96,13 @@ static bool bootBtnDebounced = false;     // True after 50ms stable LOW reading
 static unsigned long bootBtnFirstLow = 0; // When we first saw LOW (for debounce)
 static unsigned long lastWiFiRetry = 0;
 
+// Boot-time association runs in the background while setup() carries on;
+// wifiBootLoop() moves to the fallback SSID, then the fallback AP, on timeout
+enum WiFiBootStage : uint8_t { WIFI_BOOT_CONFIGURED, WIFI_BOOT_FALLBACK, WIFI_BOOT_DONE };
+static WiFiBootStage wifiBootStage = WIFI_BOOT_DONE;
+static unsigned long wifiAttemptStart = 0;
+static const char* wifiAttemptSsid = "";
+
 // Global log output — defaults to Serial, switched to serialTee in setup()
 Print* logOutput = &Serial;
 
@@ -96,58 +112,60 @@ Print* logOutput = &Serial;
 // ============================================================================
 // WiFi CONNECTION - Mirrors the proven original BULLETPROOF pattern
 // ============================================================================
-static bool connectWiFi(const char* ssid, const char* pass, const char* hostname) {
+static void startWiFi(const char* ssid, const char* pass, const char* hostname) {
   // This is the EXACT pattern from HotWheels_FinishGate_BULLETPROOF.ino
   // that reliably connects every time:
-  //   WiFi.mode(WIFI_STA) -> setHostname -> begin -> busy-wait
+  //   WiFi.mode(WIFI_STA) -> setHostname -> begin -> wait
   //
   // NO disconnect(), NO persistent(), NO mode toggling, NO retry loops.
-  // The original never needed any of that. Keep it simple.
-
+  // The original busy-waited here; now the wait is polled from loop() so
+  // ESP-NOW, the sensors and the web server come up during association.
   WiFi.mode(WIFI_STA);
   WiFi.setHostname(hostname);
   WiFi.begin(ssid, pass);
+  wifiAttemptStart = millis();
+  wifiAttemptSsid = ssid;
+  LOG.printf("[WIFI] Connecting to '%s' (background)\n", ssid);
+}
 
-  LOG.printf("[WIFI] Connecting to '%s'", ssid);
-
-  // LED feedback while connecting
-  pinMode(cfg.led_pin > 0 ? cfg.led_pin : 2, OUTPUT);
+// STA just associated — at boot, after a BOOT-button re-enable or an
+// auto-reconnect
+static void onWiFiConnected() {
+  wifiConnected = true;
+  wifiBootStage = WIFI_BOOT_DONE;
+  memset(wifiFailReason, 0, sizeof(wifiFailReason));
+
+  // NOW switch to AP_STA so ESP-NOW can work alongside WiFi.
+  // Do this AFTER successful connection to avoid confusing the driver.
+  // Pin AP to the same channel as the STA connection to prevent channel-hopping.
+  WiFi.mode(WIFI_AP_STA);
+  delay(10);  // Let mode switch settle before reading channel
+  uint8_t chan = WiFi.channel();
+  if (chan == 0) chan = 1;  // Fallback if STA channel not yet assigned
+  WiFi.softAP(cfg.hostname, NULL, chan);
+  WiFi.setSleep(false);  // Disable modem sleep — all nodes are wall-powered
   uint8_t ledPin = cfg.led_pin > 0 ? cfg.led_pin : 2;
-
-  // Wait up to 20 seconds (original had no timeout, but we add a safety net)
-  unsigned long start = millis();
-  while (WiFi.status() != WL_CONNECTED && millis() - start < 20000) {
-    delay(200);
-    digitalWrite(ledPin, !digitalRead(ledPin));
-    LOG.print(".");
-  }
-  LOG.println();
-
-  if (WiFi.status() == WL_CONNECTED) {
-    digitalWrite(ledPin, HIGH);
-    LOG.printf("[WIFI] Connected! IP: %s, RSSI: %d dBm\n",
-               WiFi.localIP().toString().c_str(), WiFi.RSSI());
-
-    // NOW switch to AP_STA so ESP-NOW can work alongside WiFi.
-    // Do this AFTER successful connection to avoid confusing the driver.
-    // Pin AP to the same channel as the STA connection to prevent channel-hopping.
-    WiFi.mode(WIFI_AP_STA);
-    WiFi.softAP(hostname, NULL, WiFi.channel());
-    WiFi.setSleep(false);  // Disable modem sleep — all nodes are wall-powered
-    delay(100);
-    LOG.println("[WIFI] Modem sleep DISABLED (low-latency mode)");
-
-    wifiConnected = true;
-    memset(wifiFailReason, 0, sizeof(wifiFailReason));
-
-    // Kick off NTP time sync (non-blocking, best-effort)
-    // Uses POSIX TZ string from config for local time display in logs
-    serialTee.syncNTP(cfg.timezone);
-    LOG.printf("[NTP] Time sync requested (pool.ntp.org, TZ=%s)\n", cfg.timezone);
-
-    return true;
+  pinMode(ledPin, OUTPUT);
+  digitalWrite(ledPin, HIGH);
+  LOG.printf("[WIFI] Connected! IP: %s, Ch: %d, RSSI: %d dBm (modem sleep off)\n",
+             WiFi.localIP().toString().c_str(), chan, WiFi.RSSI());
+
+  // Kick off NTP time sync (non-blocking, best-effort)
+  // Uses POSIX TZ string from config for local time display in logs
+  serialTee.syncNTP(cfg.timezone);
+  LOG.printf("[NTP] Time sync requested (pool.ntp.org, TZ=%s)\n", cfg.timezone);
+
+  if (bootPhaseMs(BOOT_WIFI_UP) == 0) {
+    bootMark(BOOT_WIFI_UP);
+    bootTimingLog();
+    // Set initial WLED state (finish gate only controls WLED) — needs the LAN
+    if (strcmp(cfg.role, "finish") == 0) {
+      setWLEDState("idle");
+    }
   }
+}
 
+static void recordWiFiFailure(const char* ssid) {
   // Translate WiFi status code to human-readable reason
   wifiConnected = false;
   int status = (int)WiFi.status();
@@ -162,7 +180,35 @@ static bool connectWiFi(const char* ssid, const char* pass, const char* hostname
   }
   snprintf(wifiFailReason, sizeof(wifiFailReason), "%s (status=%d)", reason, status);
   LOG.printf("[WIFI] Failed to connect to '%s': %s\n", ssid, wifiFailReason);
-  return false;
+}
+
+static void startFallbackAP() {
+  // If all else fails, become an AP so you can still reach config.
+  // AP_STA rather than AP: ESP-NOW is already running on the STA interface.
+  LOG.println("[BOOT] All WiFi failed - AP fallback mode");
+  char fallbackAP[48];
+  snprintf(fallbackAP, sizeof(fallbackAP), "%s %s", getRoleEmoji(cfg.role), cfg.hostname);
+  WiFi.disconnect(false);   // Stop STA scans hopping the AP's channel
+  WiFi.mode(WIFI_AP_STA);
+  WiFi.softAP(fallbackAP);
+  LOG.printf("[BOOT] Fallback AP: %s at 192.168.4.1\n", fallbackAP);
+  wifiBootStage = WIFI_BOOT_DONE;
+  lastWiFiRetry = millis();  // Auto-reconnect takes over from here
+}
+
+// Boot association timeouts: configured SSID → hardcoded fallback → AP
+static void wifiBootLoop() {
+  if (wifiBootStage == WIFI_BOOT_DONE || wifiConnected || wifiDisabled) return;
+  if (millis() - wifiAttemptStart < WIFI_CONNECT_TIMEOUT_MS) return;
+
+  recordWiFiFailure(wifiAttemptSsid);
+  if (wifiBootStage == WIFI_BOOT_CONFIGURED && strlen(FALLBACK_WIFI_SSID) > 0) {
+    LOG.println("[BOOT] Config WiFi failed - trying hardcoded fallback...");
+    wifiBootStage = WIFI_BOOT_FALLBACK;
+    startWiFi(FALLBACK_WIFI_SSID, FALLBACK_WIFI_PASS, cfg.hostname);
+    return;
+  }
+  startFallbackAP();
 }
 
 // ============================================================================
@@ -174,7 +220,8 @@ void setup() {
   // serialTee also go to the UART as normal.
   serialTee.begin(115200);
   logOutput = &serialTee;  // Redirect LOG macro to captured output
-  delay(500);
+  // No settle delay: serialTee keeps everything printed from here on, so
+  // early boot lines still reach /console and /api/log
 
   LOG.println("\n\n========================================");
   LOG.println("  " PROJECT_NAME " v" FIRMWARE_VERSION);
@@ -182,6 +229,10 @@ void setup() {
   LOG.println("========================================");
   LOG.println("[BOOT] Initializing Motion Analysis & Speed System...");
 
+  // Allocation tracking table (no-op unless built with HEAP_TRACK_ENABLED)
+  heapTrackBegin();
+  bootMark(BOOT_SERIAL);
+
   // Initialize filesystem
   // IMPORTANT: Do NOT use LittleFS.begin(true) here!
   // The 'true' parameter means "format if mount fails", which silently wipes
@@ -205,9 +256,11 @@ void setup() {
   } else {
     LOG.println("[BOOT] LittleFS mount FAILED even after format!");
   }
+  bootMark(BOOT_FS);
 
   // Load configuration
   bool configured = loadConfig();
+  bootMark(BOOT_CONFIG);
 
   if (!configured) {
     // Before entering setup mode, check if we have a config file that
@@ -270,6 +323,12 @@ void setup() {
   else {
     // ====================================================================
     // NORMAL MODE - Configured and ready
+    //
+    // Bring-up order puts the timing path first: association is started
+    // and left to run in the background, then ESP-NOW and the role's ISRs
+    // come up, then peripherals, logs and finally the web UI. WiFi, the
+    // DY-SV5W power-on sequence and the filesystem loads overlap instead of
+    // running back to back. Phase times: /api/diagnostics "boot".
     // ====================================================================
     LOG.printf("[BOOT] Config loaded: role=%s, hostname=%s\n", cfg.role, cfg.hostname);
 
@@ -283,53 +342,45 @@ void setup() {
     }
     else {
       // ================================================================
-      // WiFi CONNECTION - same proven pattern as original BULLETPROOF
+      // WiFi CONNECTION - same proven pattern as original BULLETPROOF,
+      // but wifiBootLoop() waits for it instead of setup()
       // ================================================================
-      bool connected = false;
-
-      // Try 1: Use config credentials (from captive portal)
       if (strlen(cfg.wifi_ssid) > 0) {
         LOG.println("[BOOT] Trying configured WiFi credentials...");
-        connected = connectWiFi(cfg.wifi_ssid, cfg.wifi_pass, cfg.hostname);
-      }
-
-      // Try 2: Hardcoded fallback (if defined)
-      if (!connected && strlen(FALLBACK_WIFI_SSID) > 0) {
-        LOG.println("[BOOT] Config WiFi failed - trying hardcoded fallback...");
-        connected = connectWiFi(FALLBACK_WIFI_SSID, FALLBACK_WIFI_PASS, cfg.hostname);
-      }
-
-      // Try 3: If all else fails, become an AP so you can still reach config
-      if (!connected) {
-        LOG.println("[BOOT] All WiFi failed - AP fallback mode");
-        char fallbackAP[48];
-        snprintf(fallbackAP, sizeof(fallbackAP), "%s %s", getRoleEmoji(cfg.role), cfg.hostname);
-        WiFi.mode(WIFI_AP);
-        WiFi.softAP(fallbackAP);
-        LOG.printf("[BOOT] Fallback AP: %s at 192.168.4.1\n", fallbackAP);
+        wifiBootStage = WIFI_BOOT_CONFIGURED;
+        startWiFi(cfg.wifi_ssid, cfg.wifi_pass, cfg.hostname);
+      } else if (strlen(FALLBACK_WIFI_SSID) > 0) {
+        LOG.println("[BOOT] No configured SSID - trying hardcoded fallback...");
+        wifiBootStage = WIFI_BOOT_FALLBACK;
+        startWiFi(FALLBACK_WIFI_SSID, FALLBACK_WIFI_PASS, cfg.hostname);
+      } else {
+        WiFi.mode(WIFI_STA);   // ESP-NOW needs the STA interface up
+        startFallbackAP();
       }
     }
+    bootMark(BOOT_WIFI_START);
 
-    // mDNS
-    if (MDNS.begin(cfg.hostname)) {
-      MDNS.addService("http", "tcp", 80);
-      LOG.printf("[BOOT] mDNS: http://%s.local\n", cfg.hostname);
-    }
-
-    // ESP-NOW (works in both STA and AP_STA modes)
+    // ESP-NOW (works in both STA and AP_STA modes, associated or not)
     initESPNow();
+    bootMark(BOOT_ESPNOW);
 
-    // Web server & WebSocket
-    initWebServer();
-    startWebServer();
-
-    // OTA updates
-    ArduinoOTA.setHostname(cfg.hostname);
-    ArduinoOTA.setPassword(cfg.ota_password);
-    ArduinoOTA.begin();
-    LOG.println("[BOOT] OTA ready");
+    // Role-specific setup — sensor ISRs attach here
+    if (strcmp(cfg.role, "finish") == 0) {
+      finishGateSetup();
+    }
+    else if (strcmp(cfg.role, "start") == 0) {
+      startGateSetup();
+    }
+    else if (strcmp(cfg.role, "speedtrap") == 0) {
+      speedTrapSetup();
+    }
+    else {
+      LOG.printf("[BOOT] Role '%s' not yet implemented\n", cfg.role);
+    }
+    bootMark(BOOT_RACE_READY);
 
-    // Audio system (optional — guarded by config flag)
+    // Audio system (optional — guarded by config flag). The DY-SV5W
+    // power-on sequence continues from audioLoop().
     if (cfg.audio_enabled) {
       audioSetup();
       LOG.println("[BOOT] Audio system initialized");
@@ -344,29 +395,52 @@ void setup() {
     } else {
       LOG.println("[BOOT] LiDAR sensor disabled (enable in config)");
     }
+    bootMark(BOOT_PERIPHERALS);
 
-    // Role-specific setup
-    if (strcmp(cfg.role, "finish") == 0) {
-      finishGateSetup();
-    }
-    else if (strcmp(cfg.role, "start") == 0) {
-      startGateSetup();
-    }
-    else if (strcmp(cfg.role, "speedtrap") == 0) {
-      speedTrapSetup();
-    }
-    else {
-      LOG.printf("[BOOT] Role '%s' not yet implemented\n", cfg.role);
+    // Race history log — builds the seq index that /api/history?since= seeks with,
+    // then the per-car leaderboard catches up from it
+    raceLogInit();
+    leaderboardInit();
+
+    // Binary run log — recovers a torn tail and continues run numbering
+    runLogInit();
+    totalRuns = runLogLastSeq();
+
+    // Write-behind task for the run log, history, telemetry CSV and peers.json
+    storageBegin();
+    bootMark(BOOT_LOGS);
+
+    // Web server & WebSocket
+    initWebServer();
+    startWebServer();
+
+    // OTA updates
+    ArduinoOTA.setHostname(cfg.hostname);
+    ArduinoOTA.setPassword(cfg.ota_password);
+    ArduinoOTA.begin();
+    LOG.println("[BOOT] OTA ready");
+
+    // mDNS — registers now, announces once the interface has an address
+    if (MDNS.begin(cfg.hostname)) {
+      MDNS.addService("http", "tcp", 80);
+      LOG.printf("[BOOT] mDNS: http://%s.local\n", cfg.hostname);
     }
+    bootMark(BOOT_WEB);
 
-    // Set initial WLED state (finish gate only controls WLED)
-    if (strcmp(cfg.role, "finish") == 0) {
+    // Standalone nodes have no association to wait for — WLED (if any)
+    // joins our AP
+    if (strcmp(cfg.network_mode, "standalone") == 0 && strcmp(cfg.role, "finish") == 0) {
       setWLEDState("idle");
     }
 
     // BOOT button — physical WiFi mode toggle
     pinMode(BOOT_BUTTON_PIN, INPUT_PULLUP);
 
+    // Loop profiler starts counting from here, not from boot
+    profReset();
+
+    bootMark(BOOT_SETUP_DONE);
+    bootTimingLog();
     LOG.println("========================================");
     LOG.println("  ALL SYSTEMS OPERATIONAL");
     LOG.println("========================================");
@@ -393,13 +467,15 @@ void loop() {
   }
 
   // Normal mode
-  ArduinoOTA.handle();
-  server.handleClient();
-  webSocket.loop();
-  processFirmwareUpdate();  // Check for scheduled firmware download (non-blocking when idle)
+  PROF_LOOP_TICK();
+  { PROF_SCOPE(OTA);       ArduinoOTA.handle(); }
+  { PROF_SCOPE(HTTP);      HEAP_TAG(WEB); server.handleClient(); }
+  { PROF_SCOPE(WEBSOCKET); HEAP_TAG(WEB); webSocket.loop(); }
+  { PROF_SCOPE(STREAM);    HEAP_TAG(WEB); streamLoop(); }
+  { PROF_SCOPE(FW_UPDATE); processFirmwareUpdate(); }  // Check for scheduled firmware download (non-blocking when idle)
 
   // Discovery broadcasts (with packed diagnostics in beacon offset)
-  discoveryLoop();
+  { PROF_SCOPE(DISCOVERY); discoveryLoop(); }
 
   // ---- BOOT button: hold 3s → toggle WiFi mode ----
   // Debounced: require 50ms of stable LOW before registering as pressed.
@@ -432,6 +508,7 @@ void loop() {
         WiFi.softAP(cfg.hostname);
         wifiDisabled = true;
         wifiConnected = false;
+        wifiBootStage = WIFI_BOOT_DONE;  // Abandon a boot association still in progress
         LOG.println("[WIFI] BOOT button: WiFi disabled (AP-only + ESP-NOW mode)");
         // Visual feedback: 3 slow blinks
         uint8_t ledPin = cfg.led_pin > 0 ? cfg.led_pin : 2;
@@ -449,7 +526,8 @@ void loop() {
           digitalWrite(ledPin, HIGH); delay(100);
           digitalWrite(ledPin, LOW);  delay(100);
         }
-        connectWiFi(cfg.wifi_ssid, cfg.wifi_pass, cfg.hostname);
+        startWiFi(cfg.wifi_ssid, cfg.wifi_pass, cfg.hostname);
+        lastWiFiRetry = millis();  // Give it a full retry interval before auto-reconnect
       }
     }
   }
@@ -469,7 +547,8 @@ void loop() {
   }
 
   // ---- Non-blocking WiFi auto-reconnect (every 60s when disconnected) ----
-  if (!wifiConnected && !wifiDisabled && (millis() - lastWiFiRetry > WIFI_RETRY_INTERVAL_MS)) {
+  if (!wifiConnected && !wifiDisabled && wifiBootStage == WIFI_BOOT_DONE &&
+      (millis() - lastWiFiRetry > WIFI_RETRY_INTERVAL_MS)) {
     lastWiFiRetry = millis();
     if (WiFi.status() != WL_CONNECTED) {
       LOG.println("[WIFI] Auto-reconnect attempt...");
@@ -478,19 +557,11 @@ void loop() {
       WiFi.begin(cfg.wifi_ssid, cfg.wifi_pass);
     }
   }
-  // Check if WiFi recovered (non-blocking)
+  // Check if WiFi came up — boot association or a reconnect (non-blocking)
   if (!wifiConnected && !wifiDisabled && WiFi.status() == WL_CONNECTED) {
-    wifiConnected = true;
-    WiFi.mode(WIFI_AP_STA);
-    delay(10);  // Let mode switch settle before reading channel
-    uint8_t chan = WiFi.channel();
-    if (chan == 0) chan = 1;  // Fallback if STA channel not yet assigned
-    WiFi.softAP(cfg.hostname, NULL, chan);
-    WiFi.setSleep(false);
-    LOG.printf("[WIFI] Reconnected! IP: %s, Ch: %d, RSSI: %d dBm\n",
-               WiFi.localIP().toString().c_str(), chan, WiFi.RSSI());
-    serialTee.syncNTP(cfg.timezone);
+    onWiFiConnected();
   }
+  wifiBootLoop();
 
   // ---- CMD_IDENTIFY LED blink (10 seconds of rapid blinking) ----
   if (identifyActive && identifyStartMs > 0) {
@@ -506,15 +577,21 @@ void loop() {
 
   // Audio loop (non-blocking DMA feed — guarded by config flag)
   if (cfg.audio_enabled) {
+    PROF_SCOPE(AUDIO);
     audioLoop();
   }
 
   // LiDAR sensor polling (guarded by config flag)
   if (cfg.lidar_enabled) {
+    PROF_SCOPE(LIDAR);
     lidarLoop();
   }
 
+  // Synthetic races + loopback HTTP while a soak test runs
+  soakLoop();
+
   // Role-specific loop
+  PROF_SCOPE(ROLE);
   if (strcmp(cfg.role, "finish") == 0) {
     finishGateLoop();
   }
@@ -7,6 +7,7 @@
 #   2. Heavy compression — squashes dynamic range like a radio transmitter
 #   3. Optional pink noise — subtle static crackle for realism
 #   4. Converts to 8-bit 16kHz mono PCM — what the ESP32 I2S driver expects
+#      (or 4-bit IMA-ADPCM with --adpcm: half the size, 16-bit quality)
 #
 # Output goes to esp32/ (ready to push to devices via LittleFS)
 # A second copy in radio/ keeps the full-quality filtered version
@@ -16,6 +17,7 @@
 #   ./radio_filter.sh armed go     # Process only these clips
 #   ./radio_filter.sh --no-static  # Skip the static/crackle layer
 #   ./radio_filter.sh --preview    # Also generate MP3 previews for listening
+#   ./radio_filter.sh --adpcm      # ESP32 clips as IMA-ADPCM instead of 8-bit PCM
 # ============================================================================
 
 SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
@@ -38,22 +40,25 @@ fi
 # Parse flags
 ADD_STATIC=true
 MAKE_PREVIEW=false
+ADPCM=false
 SPECIFIC_CLIPS=()
 
 for arg in "$@"; do
     case "$arg" in
         --no-static)  ADD_STATIC=false ;;
         --preview)    MAKE_PREVIEW=true ;;
+        --adpcm)      ADPCM=true ;;
         --help|-h)
-            echo "Usage: $0 [--no-static] [--preview] [clip1 clip2 ...]"
+            echo "Usage: $0 [--no-static] [--preview] [--adpcm] [clip1 clip2 ...]"
             echo ""
             echo "Options:"
             echo "  --no-static   Skip the subtle static/crackle layer"
             echo "  --preview     Also generate MP3 preview files"
+            echo "  --adpcm       Encode ESP32 clips as 4-bit IMA-ADPCM (still .wav)"
             echo "  clip1 clip2   Only process these clips (without .wav extension)"
             echo ""
             echo "Output:"
-            echo "  esp32/    — 8-bit 16kHz mono WAV (push to ESP32 LittleFS)"
+            echo "  esp32/    — 8-bit (or IMA-ADPCM) 16kHz mono WAV (push to ESP32 LittleFS)"
             echo "  radio/    — Full-quality filtered WAV (archive)"
             echo "  ../data/  — Copies ESP32 files for PlatformIO uploadfs"
             exit 0
@@ -64,6 +69,16 @@ done
 
 mkdir -p "$RADIO_DIR" "$ESP32_DIR"
 
+# ESP32 codec: 8-bit unsigned PCM, or IMA-ADPCM in a standard WAV container
+# (format tag 0x0011, 256-byte blocks = 505 samples) decoded by the firmware
+if [ "$ADPCM" = true ]; then
+    ESP32_CODEC=(-acodec adpcm_ima_wav -block_size 256)
+    ESP32_DESC="IMA-ADPCM 16kHz mono"
+else
+    ESP32_CODEC=(-acodec pcm_u8)
+    ESP32_DESC="8-bit 16kHz mono"
+fi
+
 # Count raw files
 if [ ${#SPECIFIC_CLIPS[@]} -gt 0 ]; then
     FILES=()
@@ -89,7 +104,7 @@ echo ""
 echo "  M.A.S.S. Trap — Police Radio Filter"
 echo "  ========================================"
 echo "  Input:    $RAW_DIR/"
-echo "  Output:   $ESP32_DIR/ (8-bit 16kHz mono)"
+echo "  Output:   $ESP32_DIR/ ($ESP32_DESC)"
 echo "  Archive:  $RADIO_DIR/ (full quality)"
 echo "  Static:   $ADD_STATIC"
 echo "  Files:    ${#FILES[@]}"
@@ -221,9 +236,9 @@ for filepath in "${FILES[@]}"; do
         mv "$RADIO_DIR/_filtered.wav" "$RADIO_DIR/$filename"
     fi
 
-    # --- Step 3: ESP32 format (8-bit unsigned PCM, 16kHz mono) ---
+    # --- Step 3: ESP32 format (8-bit unsigned PCM or IMA-ADPCM, 16kHz mono) ---
     "$FFMPEG" -y -i "$RADIO_DIR/$filename" \
-        -acodec pcm_u8 -ac 1 -ar 16000 \
+        "${ESP32_CODEC[@]}" -ac 1 -ar 16000 \
         "$ESP32_DIR/$filename" \
         -loglevel error 2>&1
 
@@ -0,0 +1,178 @@
+#include "audio_convert.h"
+
+// ============================================================================
+// DECODE — one specialised loop per format, so the per-sample path has no
+// branches on bits/channels
+// ============================================================================
+bool audioFormatSupported(uint8_t bits, uint8_t channels) {
+  return (bits == 8 || bits == 16 || bits == 24) && (channels == 1 || channels == 2);
+}
+
+static inline int16_t rd16(const uint8_t* p) {
+  return (int16_t)(p[0] | (p[1] << 8));
+}
+
+size_t audioDecodeFrames(const uint8_t* in, size_t frames, uint8_t bits, uint8_t channels,
+                         int16_t* out) {
+  if (!audioFormatSupported(bits, channels)) return 0;
+
+  if (channels == 1) {
+    switch (bits) {
+      case 8:
+        for (size_t i = 0; i < frames; i++) out[i] = (int16_t)(((int32_t)in[i] - 128) * 256);
+        break;
+      case 16:
+        for (size_t i = 0; i < frames; i++) out[i] = rd16(in + i * 2);
+        break;
+      case 24:
+        for (size_t i = 0; i < frames; i++) out[i] = rd16(in + i * 3 + 1);
+        break;
+    }
+  } else {
+    switch (bits) {
+      case 8:
+        for (size_t i = 0; i < frames; i++) {
+          int32_t l = (int32_t)in[i * 2] - 128;
+          int32_t r = (int32_t)in[i * 2 + 1] - 128;
+          out[i] = (int16_t)((l + r) * 128);
+        }
+        break;
+      case 16:
+        for (size_t i = 0; i < frames; i++) {
+          out[i] = (int16_t)(((int32_t)rd16(in + i * 4) + rd16(in + i * 4 + 2)) >> 1);
+        }
+        break;
+      case 24:
+        for (size_t i = 0; i < frames; i++) {
+          out[i] = (int16_t)(((int32_t)rd16(in + i * 6 + 1) + rd16(in + i * 6 + 4)) >> 1);
+        }
+        break;
+    }
+  }
+  return frames;
+}
+
+// ============================================================================
+// IMA-ADPCM — standard 89-step table (IMA/DVI, as written by ffmpeg's
+// adpcm_ima_wav)
+// ============================================================================
+static const int16_t IMA_STEP[89] = {
+  7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+  50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+  253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+  1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+  3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442,
+  11487, 12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794,
+  32767
+};
+
+static const int8_t IMA_INDEX[16] = {
+  -1, -1, -1, -1, 2, 4, 6, 8,
+  -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static inline int16_t imaNibble(AudioAdpcm& a, uint8_t n) {
+  int32_t step = IMA_STEP[a.index];
+  int32_t diff = step >> 3;
+  if (n & 1) diff += step >> 2;
+  if (n & 2) diff += step >> 1;
+  if (n & 4) diff += step;
+  int32_t pred = a.predictor + ((n & 8) ? -diff : diff);
+  if (pred > 32767) pred = 32767;
+  else if (pred < -32768) pred = -32768;
+  a.predictor = (int16_t)pred;
+
+  int32_t idx = a.index + IMA_INDEX[n];
+  a.index = (uint8_t)(idx < 0 ? 0 : (idx > 88 ? 88 : idx));
+  return a.predictor;
+}
+
+void audioAdpcmInit(AudioAdpcm& a, uint16_t blockAlign) {
+  a.blockAlign = blockAlign;
+  a.offset = 0;
+  a.predictor = 0;
+  a.index = 0;
+}
+
+size_t audioAdpcmDecode(AudioAdpcm& a, const uint8_t* in, size_t len, int16_t* out) {
+  size_t n = 0;
+  size_t i = 0;
+  while (i < len) {
+    if (a.offset < 4) {
+      // Block header: gather all four bytes, then emit the predictor
+      a.header[a.offset++] = in[i++];
+      if (a.offset == 4) {
+        a.predictor = (int16_t)(a.header[0] | (a.header[1] << 8));
+        a.index = a.header[2] > 88 ? 88 : a.header[2];
+        out[n++] = a.predictor;
+      }
+      continue;
+    }
+
+    // Data bytes up to the end of the block
+    size_t run = a.blockAlign - a.offset;
+    if (run > len - i) run = len - i;
+    for (size_t k = 0; k < run; k++) {
+      uint8_t b = in[i + k];
+      out[n++] = imaNibble(a, b & 0x0F);
+      out[n++] = imaNibble(a, b >> 4);
+    }
+    i += run;
+    a.offset += run;
+    if (a.offset >= a.blockAlign) a.offset = 0;
+  }
+  return n;
+}
+
+uint32_t audioAdpcmSamples(uint32_t dataBytes, uint16_t blockAlign) {
+  if (blockAlign <= 4) return 0;
+  uint32_t perBlock = (blockAlign - 4) * 2 + 1;
+  uint32_t rest = dataBytes % blockAlign;
+  return (dataBytes / blockAlign) * perBlock + (rest >= 4 ? (rest - 4) * 2 + 1 : 0);
+}
+
+// ============================================================================
+// RESAMPLE — linear interpolation between neighbouring input samples
+//
+// pos indexes the sequence [prev, in[0], in[1], ...]: integer part j picks
+// the pair (x[j], x[j+1]), the fraction weights them. The fraction is
+// taken as Q15 so the product fits in 32 bits.
+// ============================================================================
+void audioResamplerInit(AudioResampler& r, uint32_t inRate, uint32_t outRate) {
+  r.step = (uint32_t)(((uint64_t)inRate << 16) / outRate);
+  r.pos = 1u << 16;   // First output is exactly in[0]
+  r.prev = 0;
+}
+
+size_t audioResample(AudioResampler& r, const int16_t* in, size_t inCount, size_t* consumed,
+                     int16_t* out, size_t outMax) {
+  size_t n = 0;
+  uint32_t pos = r.pos;
+  int16_t prev = r.prev;
+
+  while (n < outMax) {
+    uint32_t j = pos >> 16;
+    if (j >= inCount) break;
+    int32_t a = j ? in[j - 1] : prev;
+    int32_t b = in[j];
+    int32_t f = (pos >> 1) & 0x7FFF;
+    out[n++] = (int16_t)(a + (((b - a) * f) >> 15));
+    pos += r.step;
+  }
+
+  // Everything before x[j] is done with; in[j - 1] becomes the new prev
+  size_t used = pos >> 16;
+  if (used > inCount) used = inCount;
+  if (used) {
+    prev = in[used - 1];
+    pos -= (uint32_t)used << 16;
+  }
+  r.pos = pos;
+  r.prev = prev;
+  *consumed = used;
+  return n;
+}
+
+uint32_t audioResampledLength(uint32_t inFrames, uint32_t inRate, uint32_t outRate) {
+  return (uint32_t)(((uint64_t)inFrames * outRate + inRate - 1) / inRate);
+}
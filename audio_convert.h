@@ -0,0 +1,77 @@
+#ifndef AUDIO_CONVERT_H
+#define AUDIO_CONVERT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// ============================================================================
+// AUDIO CONVERT — PCM format conversion and resampling for the I2S mixer
+//
+// The mixer runs at one fixed rate (16 kHz, 16-bit mono). Clips arrive as
+// 8-bit unsigned, 16-bit or 24-bit signed little-endian PCM, mono or
+// stereo, at whatever rate they were exported. Conversion is two block
+// stages, both integer-only:
+//
+//   audioDecodeFrames()  frames → 16-bit mono. Stereo is averaged, 24-bit
+//                        keeps the top 16 bits, 8-bit is re-centred.
+//   audioResample()      linear interpolation, Q16 phase step, to the
+//                        output rate. State carries across blocks, so a
+//                        clip can be fed in any chunk size.
+//
+// IMA-ADPCM clips (WAV format tag 0x0011, mono) are decoded by
+// audioAdpcmDecode() in place of audioDecodeFrames(): 4 bits per sample,
+// a quarter of the flash reads of 16-bit PCM for the same audio.
+//
+// Clips already at the output rate skip the resampler. No Arduino
+// dependencies: tools/audio_convert_bench.cpp builds this file on the host.
+// ============================================================================
+
+// Decode `frames` interleaved little-endian PCM frames to 16-bit mono.
+// bits: 8, 16 or 24. channels: 1 or 2. Returns frames written (0 for an
+// unsupported format).
+size_t audioDecodeFrames(const uint8_t* in, size_t frames, uint8_t bits, uint8_t channels,
+                         int16_t* out);
+
+// True if audioDecodeFrames() handles the format
+bool audioFormatSupported(uint8_t bits, uint8_t channels);
+
+// IMA-ADPCM stream state. Blocks are blockAlign bytes: a 4-byte header
+// (int16 predictor = first sample, step index, reserved) then two samples
+// per byte, low nibble first. Input may be split anywhere, even inside a
+// header.
+struct AudioAdpcm {
+  uint16_t blockAlign;
+  uint16_t offset;    // Bytes consumed in the current block
+  int16_t predictor;
+  uint8_t index;
+  uint8_t header[4];
+};
+
+void audioAdpcmInit(AudioAdpcm& a, uint16_t blockAlign);
+
+// Decode len bytes of IMA-ADPCM into out. Writes at most 2 * len samples;
+// returns samples written.
+size_t audioAdpcmDecode(AudioAdpcm& a, const uint8_t* in, size_t len, int16_t* out);
+
+// Samples in dataBytes of IMA-ADPCM with the given block size
+uint32_t audioAdpcmSamples(uint32_t dataBytes, uint16_t blockAlign);
+
+struct AudioResampler {
+  uint32_t step;      // Input samples per output sample, Q16
+  uint32_t pos;       // Read position, Q16, relative to `prev`
+  int16_t prev;       // Last input sample of the previous call
+};
+
+void audioResamplerInit(AudioResampler& r, uint32_t inRate, uint32_t outRate);
+
+// Resample in[0..inCount) into out[0..outMax). Returns samples written and
+// sets *consumed to the input samples no longer needed; the caller drops
+// those and passes the rest again with the next input appended.
+size_t audioResample(AudioResampler& r, const int16_t* in, size_t inCount, size_t* consumed,
+                     int16_t* out, size_t outMax);
+
+// Output samples audioResample() produces for inFrames input samples
+// (rounded up — an upper bound for sizing buffers)
+uint32_t audioResampledLength(uint32_t inFrames, uint32_t inRate, uint32_t outRate);
+
+#endif
@@ -1,6 +1,9 @@
 #include "audio_manager.h"
+#include "audio_convert.h"
 #include "config.h"
 #include "dysv5w.h"
+#include "espnow_comm.h"
+#include "heap_track.h"
 #include <LittleFS.h>
 #include <driver/i2s.h>
 
@@ -15,43 +18,310 @@ enum AudioBackend {
 
 static AudioBackend activeBackend = BACKEND_NONE;
 
+// DY-SV5W: scheduled cues, unordered, fired earliest first from audioLoop()
+// (loop() resolution — the module has no sample clock to align to)
+struct DyCue {
+  uint16_t track;
+  uint64_t atUs;
+};
+static portMUX_TYPE dyCueMux = portMUX_INITIALIZER_UNLOCKED;
+static DyCue dyCues[AUDIO_CUE_SLOTS];
+static uint8_t dyCueCount = 0;
+
 // ============================================================================
 // I2S CONFIGURATION for MAX98357A
 // ============================================================================
 #define I2S_PORT          I2S_NUM_0
 #define DMA_BUF_COUNT     8
 #define DMA_BUF_LEN       256
+#define DMA_BUF_BYTES     (DMA_BUF_LEN * 2)   // 16-bit mono
 #define SAMPLE_RATE       16000   // 16kHz mono — good balance of quality and size
+#define BLOCK_SAMPLES     DMA_BUF_LEN         // One DMA buffer per block
+#define FIFO_SAMPLES      (BLOCK_SAMPLES * 2) // Per-voice decoded input awaiting resampling
+#define MAX_FRAME_BYTES   6                   // 24-bit stereo
+#define BLOCK_US          ((uint64_t)BLOCK_SAMPLES * 1000000 / SAMPLE_RATE)
+
+// A write that had to wait for DMA space returned the moment a buffer was
+// freed: the buffer just filled is then queued behind the DMA_BUF_COUNT - 1
+// others (one of them playing). That re-anchors the output clock exactly.
+#define DMA_RING_US       ((uint64_t)(DMA_BUF_COUNT - 1) * DMA_BUF_LEN * 1000000 / SAMPLE_RATE)
+#define DMA_WAIT_ANCHOR_US 2000
+
+#define WAV_FORMAT_PCM        0x0001
+#define WAV_FORMAT_IMA_ADPCM  0x0011
+#define WAV_FORMAT_EXTENSIBLE 0xFFFE              // ffmpeg's choice for 24-bit PCM
+#define GAIN_UNITY        32768               // Q15 1.0
 
 // ============================================================================
-// I2S PLAYBACK STATE
+// I2S PLAYBACK STATE — owned by the audio task
 // ============================================================================
-static File audioFile;
-static bool audioPlaying = false;
+enum AudioCmdType : uint8_t {
+  AUDIO_CMD_PLAY,
+  AUDIO_CMD_STOP,
+  AUDIO_CMD_INVALIDATE
+};
+
+struct AudioCmd {
+  AudioCmdType type;
+  AudioPriority priority;
+  int8_t voice;             // AUDIO_VOICE_ANY = allocate (PLAY) / all (STOP)
+  char file[48];
+  uint32_t postedUs;        // micros() at playSound(), for trigger latency
+  uint64_t atUs;            // playSoundAt(): local esp_timer time to start, 0 = now
+};
+
+// One mixer voice: a clip playing from the cache or streaming from LittleFS
+struct Voice {
+  bool active;
+  char name[48];
+  AudioPriority priority;
+  uint32_t startSeq;        // For stealing the oldest voice
+  int32_t lastGain;         // Q15 gain at the end of the previous block (ramped), -1 = none yet
+  uint32_t postedUs;        // Cleared once the first block is mixed
+  uint16_t lead;            // Silence before the clip in its first block (scheduled start)
+
+  // Cached source (nullptr = streaming from file)
+  const int16_t* pcm;
+  uint32_t samples;
+  uint32_t pos;
+
+  // Streaming source: file → decoded mono FIFO → resampler → mixer
+  File file;
+  uint32_t dataSize;
+  uint32_t bytesRead;
+  uint8_t bits;
+  uint16_t channels;
+  uint32_t rate;
+  uint8_t frameBytes;       // 1 for ADPCM (read in bytes, not frames)
+  bool adpcm;
+  AudioAdpcm ima;
+  AudioResampler resampler;
+  int16_t fifo[FIFO_SAMPLES];
+  uint16_t fifoCount;
+
+  // Capture of a streaming clip, inserted into the cache if it completes
+  int16_t* capture;
+  uint32_t captureSamples;
+  uint32_t captureCapacity;
+};
+
+static QueueHandle_t cmdQueue = nullptr;
+static QueueHandle_t i2sEvents = nullptr;
+static TaskHandle_t audioTaskHandle = nullptr;
+
+static Voice voices[AUDIO_VOICES];
+static uint32_t voiceSeq = 0;
+static volatile uint8_t voiceMask = 0;          // Bit per active voice
+static volatile uint8_t playsPending = 0;       // Posted, not yet started
+static volatile uint8_t cuesPending = 0;        // Scheduled (playSoundAt), not yet started or dropped
+static portMUX_TYPE pendingMux = portMUX_INITIALIZER_UNLOCKED;
+static volatile uint16_t voiceGain[AUDIO_VOICES];        // Q15, set by setVoiceGain()
+
 static bool audioInitialized = false;
-static uint32_t audioDataStart = 0;
-static uint32_t audioDataSize = 0;
-static uint32_t audioBytesRead = 0;
-static uint8_t volumeLevel = 10;
-static uint8_t audioBuffer[512];
+static volatile uint8_t volumeLevel = 10;
+static uint8_t readBuffer[FIFO_SAMPLES * MAX_FRAME_BYTES];
+
+// Two output blocks: one being written to DMA, the next already mixed
+static int16_t pcmBlock[2][BLOCK_SAMPLES];
+static uint32_t blockPostedUs[2];               // Trigger time of a clip first heard in the block
+static bool blockCached[2];
+
+// Mixer scratch (audio task only — kept off its stack)
+static int16_t voiceBlock[BLOCK_SAMPLES];
+static int32_t mixAcc[BLOCK_SAMPLES];
+
+// DMA accounting. TX_DONE fires once per DMA buffer sent; if the DMA has sent
+// more than was queued while a clip is playing, it sent auto-cleared silence.
+static uint32_t dmaQueuedBytes = 0;
+static uint32_t dmaSentBytes = 0;
+
+// Output clock: esp_timer time at which the sample after the last one queued
+// to the DMA will be heard. Valid while the task is feeding the DMA.
+static uint64_t dmaTailUs = 0;
+
+// Scheduled cues (playSoundAt) waiting for their block, unordered
+static AudioCmd cues[AUDIO_CUE_SLOTS];
+static uint8_t cueCount = 0;
+
+struct AudioStats {
+  uint32_t clips;
+  uint32_t blocks;
+  uint32_t bytesPlayed;
+  uint32_t underruns;       // DMA buffers sent empty mid-clip
+  uint32_t droppedBytes;    // PCM not accepted by i2s_write() within the timeout
+  uint32_t readMax_us;      // Longest LittleFS read of one block
+  uint32_t flashBytesRead;  // Clip data read from LittleFS (ADPCM: 1/4 of 16-bit PCM)
+  uint32_t writeMax_us;     // Longest wait in i2s_write() for DMA space
+  uint32_t cacheHits;
+  uint32_t cacheMisses;
+  uint32_t latencyCached_us;      // playSound() → first block queued, last clip from PSRAM
+  uint32_t latencyCachedMax_us;
+  uint32_t latencyStream_us;      // Same, last clip streamed from LittleFS
+  uint32_t latencyStreamMax_us;
+  uint32_t mixMax_us;             // Longest mix of one block, all voices
+  uint8_t  voicesMax;             // Most voices playing at once
+  uint32_t voiceSteals;           // Lower-priority voice cut off for a new clip
+  uint32_t clipsRejected;         // Every voice busy with a higher priority
+  uint32_t saturatedBlocks;       // Blocks where the mix hit full scale
+  uint32_t cues;                  // Scheduled cues started on time
+  uint32_t cuesLate;              // Started late, within AUDIO_CUE_MAX_LATE_US
+  uint32_t cuesDropped;           // Too late, or no free cue slot
+  uint32_t cueLateMax_us;
+};
+static AudioStats stats;
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// CLIP CACHE — decoded 16-bit mono PCM at SAMPLE_RATE, in PSRAM
+//
+// The firmware clips (the "firmware" category in audio/clips.json) are
+// loaded at task start and pinned. Any other clip is captured the first
+// time it streams all the way through and kept in an LRU bounded by
+// AUDIO_CACHE_LRU_BYTES. Only the audio task touches the cache.
+// ============================================================================
+static const char* const FIRMWARE_CLIPS[] = {
+  "go.wav", "finish.wav", "armed.wav", "speed_trap.wav",
+  "record.wav", "reset.wav", "sync.wav", "error.wav"
+};
+
+struct CachedClip {
+  char name[48];
+  int16_t* pcm;             // nullptr = free slot
+  uint32_t samples;
+  uint32_t lastUsed;        // cacheTick at last play
+  bool pinned;              // Firmware clip, never evicted
+};
+
+static CachedClip clipCache[AUDIO_CACHE_SLOTS];
+static uint32_t cacheTick = 0;
+static uint32_t cacheLruBytes = 0;
+static uint32_t cacheTotalBytes = 0;
+
+static bool isFirmwareClip(const char* name) {
+  for (size_t i = 0; i < sizeof(FIRMWARE_CLIPS) / sizeof(FIRMWARE_CLIPS[0]); i++) {
+    if (strcmp(name, FIRMWARE_CLIPS[i]) == 0) return true;
+  }
+  return false;
+}
+
+static CachedClip* cacheFind(const char* name) {
+  for (int i = 0; i < AUDIO_CACHE_SLOTS; i++) {
+    if (clipCache[i].pcm && strcmp(clipCache[i].name, name) == 0) return &clipCache[i];
+  }
+  return nullptr;
+}
+
+static bool cacheInUse(const CachedClip& c) {
+  for (int v = 0; v < AUDIO_VOICES; v++) {
+    if (voices[v].active && voices[v].pcm == c.pcm) return true;
+  }
+  return false;
+}
+
+static void cacheFree(CachedClip& c) {
+  uint32_t bytes = c.samples * 2;
+  cacheTotalBytes -= bytes;
+  if (!c.pinned) cacheLruBytes -= bytes;
+  free(c.pcm);
+  c.pcm = nullptr;
+}
+
+// Evict least-recently-played unpinned clips (not playing on any voice)
+// until `bytes` more fit in the LRU budget and a slot is free. Returns the
+// free slot, or nullptr.
+static CachedClip* cacheMakeRoom(uint32_t bytes, bool pinned) {
+  for (;;) {
+    CachedClip* slot = nullptr;
+    CachedClip* oldest = nullptr;
+    for (int i = 0; i < AUDIO_CACHE_SLOTS; i++) {
+      CachedClip& c = clipCache[i];
+      if (!c.pcm) {
+        if (!slot) slot = &c;
+      } else if (!c.pinned && !cacheInUse(c) && (!oldest || c.lastUsed < oldest->lastUsed)) {
+        oldest = &c;
+      }
+    }
+    bool fits = pinned || cacheLruBytes + bytes <= AUDIO_CACHE_LRU_BYTES;
+    if (slot && fits) return slot;
+    if (!oldest) return nullptr;
+    cacheFree(*oldest);
+  }
+}
+
+static void captureDiscard(Voice& v) {
+  free(v.capture);
+  v.capture = nullptr;
+}
+
+static void captureStart(Voice& v) {
+  captureDiscard(v);
+  if (!psramFound()) return;
 
-static uint8_t wavBitsPerSample = 16;
-static uint16_t wavChannels = 1;
-static uint32_t wavSampleRate = 16000;
+  // Cached PCM is what the mixer sees: mono at the output rate
+  uint32_t inSamples = v.adpcm ? audioAdpcmSamples(v.dataSize, v.ima.blockAlign)
+                               : v.dataSize / v.frameBytes;
+  uint32_t samples = audioResampledLength(inSamples, v.rate, SAMPLE_RATE);
+  if (samples == 0 || samples * 2 > AUDIO_CACHE_MAX_CLIP_BYTES) return;
+
+  HEAP_TAG(AUDIO);
+  v.capture = (int16_t*)ps_malloc(samples * 2);
+  if (!v.capture) return;
+  v.captureCapacity = samples;
+  v.captureSamples = 0;
+}
+
+// Clip streamed to the end: move the capture into the cache. A clip cut
+// short by a read error is not kept.
+static void captureCommit(Voice& v) {
+  if (!v.capture) return;
+  if (v.bytesRead != v.dataSize || cacheFind(v.name)) {
+    captureDiscard(v);
+    return;
+  }
+  bool pinned = isFirmwareClip(v.name);
+  CachedClip* slot = cacheMakeRoom(v.captureSamples * 2, pinned);
+  if (!slot) {
+    captureDiscard(v);
+    return;
+  }
+  strlcpy(slot->name, v.name, sizeof(slot->name));
+  slot->pcm = v.capture;
+  slot->samples = v.captureSamples;
+  slot->lastUsed = ++cacheTick;
+  slot->pinned = pinned;
+  cacheTotalBytes += v.captureSamples * 2;
+  if (!pinned) cacheLruBytes += v.captureSamples * 2;
+  v.capture = nullptr;
+}
 
 // ============================================================================
 // WAV HEADER PARSER (I2S backend only)
 // ============================================================================
-static bool parseWavHeader(File& f) {
+static bool parseWavHeader(Voice& v) {
+  File& f = v.file;
   uint8_t header[44];
   if (f.read(header, 44) != 44) return false;
 
   if (header[0] != 'R' || header[1] != 'I' || header[2] != 'F' || header[3] != 'F') return false;
   if (header[8] != 'W' || header[9] != 'A' || header[10] != 'V' || header[11] != 'E') return false;
 
-  wavChannels = header[22] | (header[23] << 8);
-  wavSampleRate = header[24] | (header[25] << 8) | (header[26] << 16) | (header[27] << 24);
-  wavBitsPerSample = header[34] | (header[35] << 8);
+  uint16_t format = header[20] | (header[21] << 8);
+  v.channels = header[22] | (header[23] << 8);
+  v.rate = header[24] | (header[25] << 8) | (header[26] << 16) | (header[27] << 24);
+  uint16_t blockAlign = header[32] | (header[33] << 8);
+  v.bits = header[34] | (header[35] << 8);
+
+  if (format == WAV_FORMAT_IMA_ADPCM) {
+    if (v.channels != 1 || v.bits != 4 || blockAlign <= 4) return false;   // Mono only
+    v.adpcm = true;
+    audioAdpcmInit(v.ima, blockAlign);
+  } else if (format == WAV_FORMAT_PCM || format == WAV_FORMAT_EXTENSIBLE) {
+    if (!audioFormatSupported(v.bits, v.channels)) return false;
+    v.adpcm = false;
+  } else {
+    return false;
+  }
+  if (v.rate == 0) return false;
 
   f.seek(12);
   while (f.available() >= 8) {
@@ -63,8 +333,11 @@ static bool parseWavHeader(File& f) {
 
     if (chunkHeader[0] == 'd' && chunkHeader[1] == 'a' &&
         chunkHeader[2] == 't' && chunkHeader[3] == 'a') {
-      audioDataStart = f.position();
-      audioDataSize = chunkSize;
+      v.frameBytes = v.adpcm ? 1 : (v.bits / 8) * v.channels;
+      v.dataSize = chunkSize - chunkSize % v.frameBytes;
+      v.bytesRead = 0;
+      v.fifoCount = 0;
+      audioResamplerInit(v.resampler, v.rate, SAMPLE_RATE);
       return true;
     }
 
@@ -77,6 +350,8 @@ static bool parseWavHeader(File& f) {
 // ============================================================================
 // I2S SETUP
 // ============================================================================
+static void audioTask(void*);
+
 static void i2sSetup() {
   i2s_config_t i2s_config = {
     .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
@@ -99,7 +374,8 @@ static void i2sSetup() {
     .data_in_num = I2S_PIN_NO_CHANGE
   };
 
-  esp_err_t err = i2s_driver_install(I2S_PORT, &i2s_config, 0, NULL);
+  // Event queue: one I2S_EVENT_TX_DONE per DMA buffer, for underrun accounting
+  esp_err_t err = i2s_driver_install(I2S_PORT, &i2s_config, DMA_BUF_COUNT, &i2sEvents);
   if (err != ESP_OK) {
     LOG.printf("[AUDIO] I2S driver install failed: %d\n", err);
     return;
@@ -112,120 +388,622 @@ static void i2sSetup() {
     return;
   }
 
+  cmdQueue = xQueueCreate(AUDIO_CMD_QUEUE_DEPTH, sizeof(AudioCmd));
+  if (!cmdQueue) {
+    LOG.println("[AUDIO] Failed to create command queue");
+    i2s_driver_uninstall(I2S_PORT);
+    return;
+  }
+
+  for (uint8_t i = 0; i < AUDIO_VOICES; i++) voiceGain[i] = GAIN_UNITY;
+
   i2s_zero_dma_buffer(I2S_PORT);
   audioInitialized = true;
   activeBackend = BACKEND_I2S;
 
-  LOG.printf("[AUDIO] I2S initialized: BCLK=%d, LRC=%d, DOUT=%d\n",
-                cfg.i2s_bclk_pin, cfg.i2s_lrc_pin, cfg.i2s_dout_pin);
+  // Core 0 with storage and the log drain — keeps loop() (Core 1) free
+  xTaskCreatePinnedToCore(audioTask, "audio", AUDIO_TASK_STACK, nullptr,
+                          AUDIO_TASK_PRIORITY, &audioTaskHandle, 0);
+
+  LOG.printf("[AUDIO] I2S initialized: BCLK=%d, LRC=%d, DOUT=%d, %d voices\n",
+                cfg.i2s_bclk_pin, cfg.i2s_lrc_pin, cfg.i2s_dout_pin, AUDIO_VOICES);
 }
 
 // ============================================================================
-// I2S LOOP — Feed DMA buffer (non-blocking)
+// I2S TASK — voice start/stop (audio task only)
 // ============================================================================
-static void i2sLoop() {
-  if (!audioInitialized || !audioPlaying) return;
+static void voiceStop(uint8_t idx) {
+  Voice& v = voices[idx];
+  captureDiscard(v);
+  if (v.file) v.file.close();
+  v.active = false;
+  v.pcm = nullptr;
+  voiceMask &= ~(1 << idx);
+}
 
-  size_t bytesToRead = sizeof(audioBuffer);
-  size_t remaining = audioDataSize - audioBytesRead;
-  if (bytesToRead > remaining) bytesToRead = remaining;
+static void voiceStopAll() {
+  for (uint8_t i = 0; i < AUDIO_VOICES; i++) {
+    if (voices[i].active) voiceStop(i);
+  }
+}
 
-  if (bytesToRead == 0) {
-    stopSound();
-    return;
+static bool voiceOpenFile(Voice& v, const char* filename) {
+  String path = String("/") + filename;
+  if (!LittleFS.exists(path)) {
+    LOG.printf("[AUDIO] File not found: %s\n", path.c_str());
+    return false;
   }
 
-  size_t bytesRead = audioFile.read(audioBuffer, bytesToRead);
-  if (bytesRead == 0) {
-    stopSound();
-    return;
+  v.file = LittleFS.open(path, "r");
+  if (!v.file) {
+    LOG.printf("[AUDIO] Failed to open: %s\n", path.c_str());
+    return false;
+  }
+
+  if (!parseWavHeader(v)) {
+    LOG.printf("[AUDIO] Invalid WAV: %s\n", path.c_str());
+    v.file.close();
+    return false;
   }
+  return true;
+}
 
-  int16_t sampleBuf[256];
-  size_t sampleCount = 0;
+// Pick a voice for a new clip: the requested one, else a free one, else the
+// oldest voice of the lowest priority not above the new clip's. -1 = none.
+static int8_t voiceAllocate(int8_t want, AudioPriority priority) {
+  if (want >= 0 && want < AUDIO_VOICES) return want;
 
-  if (wavBitsPerSample == 8) {
-    for (size_t i = 0; i < bytesRead; i++) {
-      int16_t sample = ((int16_t)audioBuffer[i] - 128) << 8;
-      sample = (sample * volumeLevel) / 21;
-      sampleBuf[sampleCount++] = sample;
+  int8_t victim = -1;
+  for (int8_t i = 0; i < AUDIO_VOICES; i++) {
+    Voice& v = voices[i];
+    if (!v.active) return i;
+    if (v.priority > priority) continue;
+    if (victim < 0 || v.priority < voices[victim].priority ||
+        (v.priority == voices[victim].priority && v.startSeq < voices[victim].startSeq)) {
+      victim = i;
     }
+  }
+  return victim;
+}
+
+// lead: samples of silence before the clip in the next mixed block, for a
+// cue that falls part-way through it
+static void voiceStart(const AudioCmd& cmd, uint16_t lead) {
+  int8_t idx = voiceAllocate(cmd.voice, cmd.priority);
+  if (idx < 0) {
+    LOG.printf("[AUDIO] All voices busy, dropped: %s\n", cmd.file);
+    portENTER_CRITICAL(&statsMux);
+    stats.clipsRejected++;
+    portEXIT_CRITICAL(&statsMux);
+    return;
+  }
+
+  Voice& v = voices[idx];
+  if (v.active) {
+    voiceStop(idx);
+    portENTER_CRITICAL(&statsMux);
+    stats.voiceSteals++;
+    portEXIT_CRITICAL(&statsMux);
+  }
+
+  strlcpy(v.name, cmd.file, sizeof(v.name));
+  v.priority = cmd.priority;
+  v.startSeq = ++voiceSeq;
+  v.lead = lead;
+  if (cmd.atUs) {
+    // Scheduled: the first sample lands on the cue time, so no fade-in, and
+    // trigger latency is meaningless
+    v.postedUs = 0;
+    v.lastGain = -1;
   } else {
-    sampleCount = bytesRead / 2;
-    for (size_t i = 0; i < sampleCount; i++) {
-      int16_t sample = (int16_t)(audioBuffer[i * 2] | (audioBuffer[i * 2 + 1] << 8));
-      sample = (sample * volumeLevel) / 21;
-      sampleBuf[i] = sample;
+    v.postedUs = cmd.postedUs;
+    v.lastGain = 0;   // Fade in over the first block
+  }
+
+  CachedClip* cached = cacheFind(cmd.file);
+  if (cached) {
+    cached->lastUsed = ++cacheTick;
+    v.pcm = cached->pcm;
+    v.samples = cached->samples;
+    v.pos = 0;
+  } else {
+    if (!voiceOpenFile(v, cmd.file)) return;
+    captureStart(v);
+  }
+  v.active = true;
+  voiceMask |= (1 << idx);
+
+  uint8_t active = 0;
+  for (uint8_t i = 0; i < AUDIO_VOICES; i++) {
+    if (voices[i].active) active++;
+  }
+
+  portENTER_CRITICAL(&statsMux);
+  stats.clips++;
+  if (cached) stats.cacheHits++;
+  else stats.cacheMisses++;
+  if (active > stats.voicesMax) stats.voicesMax = active;
+  portEXIT_CRITICAL(&statsMux);
+
+  if (cached) {
+    LOG.printf("[AUDIO] Voice %d: %s (cached, %u samples, prio %d)\n",
+                  idx, v.name, v.samples, v.priority);
+  } else {
+    LOG.printf("[AUDIO] Voice %d: %s (%dHz, %s%d-bit, %dch, %d bytes, prio %d)\n",
+                  idx, v.name, v.rate, v.adpcm ? "IMA-ADPCM " : "", v.bits, v.channels,
+                  v.dataSize, v.priority);
+  }
+}
+
+// ============================================================================
+// I2S TASK — read one block of a voice into 16-bit mono PCM
+//
+// A streaming voice reads raw frames from LittleFS, decodes them into its
+// FIFO (audioDecodeFrames) and resamples from the FIFO to the output rate
+// (audioResample), so every clip reaches the mixer as 16 kHz mono whatever
+// it was exported as, and the I2S clock is never touched.
+// ============================================================================
+static bool voiceRefill(Voice& v) {
+  // ADPCM: each byte decodes to at most two samples
+  size_t frames = FIFO_SAMPLES - v.fifoCount;
+  if (v.adpcm) frames /= 2;
+  size_t remaining = (v.dataSize - v.bytesRead) / v.frameBytes;
+  if (frames > remaining) frames = remaining;
+  if (frames == 0) return false;
+
+  uint32_t t0 = micros();
+  size_t bytesRead = v.file.read(readBuffer, frames * v.frameBytes);
+  uint32_t took = micros() - t0;
+  v.bytesRead += bytesRead;
+
+  portENTER_CRITICAL(&statsMux);
+  if (took > stats.readMax_us) stats.readMax_us = took;
+  stats.flashBytesRead += bytesRead;
+  portEXIT_CRITICAL(&statsMux);
+
+  frames = bytesRead / v.frameBytes;
+  if (v.adpcm) {
+    v.fifoCount += audioAdpcmDecode(v.ima, readBuffer, bytesRead, v.fifo + v.fifoCount);
+  } else {
+    v.fifoCount += audioDecodeFrames(readBuffer, frames, v.bits, v.channels, v.fifo + v.fifoCount);
+  }
+  return frames > 0;
+}
+
+static size_t voiceStreamBlock(Voice& v, int16_t* out, size_t want) {
+  bool direct = v.rate == SAMPLE_RATE;
+  size_t produced = 0;
+
+  while (produced < want) {
+    size_t used;
+    if (direct) {
+      used = v.fifoCount;
+      if (used > want - produced) used = want - produced;
+      memcpy(out + produced, v.fifo, used * 2);
+      produced += used;
+    } else {
+      produced += audioResample(v.resampler, v.fifo, v.fifoCount, &used,
+                                out + produced, want - produced);
+    }
+    if (used) {
+      v.fifoCount -= used;
+      memmove(v.fifo, v.fifo + used, v.fifoCount * 2);
     }
+    if (produced < want && !voiceRefill(v)) break;
   }
 
-  if (wavChannels == 2) {
-    size_t monoCount = sampleCount / 2;
-    for (size_t i = 0; i < monoCount; i++) {
-      sampleBuf[i] = sampleBuf[i * 2];
+  if (v.capture) {
+    if (v.captureSamples + produced <= v.captureCapacity) {
+      memcpy(v.capture + v.captureSamples, out, produced * 2);
+      v.captureSamples += produced;
+    } else {
+      captureDiscard(v);
     }
-    sampleCount = monoCount;
   }
+  return produced;
+}
 
-  size_t bytesWritten = 0;
-  i2s_write(I2S_PORT, sampleBuf, sampleCount * 2, &bytesWritten, 0);
+static size_t voiceReadBlock(Voice& v, int16_t* out, size_t want) {
+  if (!v.pcm) return voiceStreamBlock(v, out, want);
 
-  audioBytesRead += bytesRead;
+  size_t frames = v.samples - v.pos;
+  if (frames > want) frames = want;
+  memcpy(out, v.pcm + v.pos, frames * 2);
+  v.pos += frames;
+  return frames;
 }
 
 // ============================================================================
-// I2S PLAY SOUND
+// I2S TASK — MIXER
+//
+// Each voice is scaled by its gain (setVoiceGain), the master volume and,
+// while a higher-priority voice is playing, AUDIO_DUCK_GAIN. Gain changes
+// are ramped linearly across one block so ducking and new voices don't
+// click. Voices are summed in 32 bits and saturated to 16 bits once.
 // ============================================================================
-static void i2sPlaySound(const char* filename) {
-  if (!audioInitialized) return;
+static int32_t voiceTargetGain(uint8_t idx, AudioPriority topPriority) {
+  int32_t g = ((int32_t)voiceGain[idx] * volumeLevel) / 21;
+  if (voices[idx].priority < topPriority) g = (g * AUDIO_DUCK_GAIN) >> 15;
+  return g;
+}
 
-  if (audioPlaying) stopSound();
+// Mix the next block of every active voice into out. Returns the samples
+// in the block (0 once every voice has finished).
+static size_t mixBlock(int16_t* out, uint32_t& postedUs, bool& cached) {
+  postedUs = 0;
+  cached = false;
 
-  String path = String("/") + filename;
-  if (!LittleFS.exists(path)) {
-    LOG.printf("[AUDIO] File not found: %s\n", path.c_str());
-    return;
+  AudioPriority top = AUDIO_PRIO_LOW;
+  for (uint8_t i = 0; i < AUDIO_VOICES; i++) {
+    if (voices[i].active && voices[i].priority > top) top = voices[i].priority;
   }
 
-  audioFile = LittleFS.open(path, "r");
-  if (!audioFile) {
-    LOG.printf("[AUDIO] Failed to open: %s\n", path.c_str());
+  uint32_t t0 = micros();
+  size_t blockLen = 0;
+  for (uint8_t i = 0; i < AUDIO_VOICES; i++) {
+    Voice& v = voices[i];
+    if (!v.active) continue;
+
+    size_t lead = v.lead;
+    v.lead = 0;
+    size_t n = voiceReadBlock(v, voiceBlock, BLOCK_SAMPLES - lead);
+    if (n == 0) {
+      captureCommit(v);   // Streamed all the way through — keep it
+      voiceStop(i);
+      continue;
+    }
+
+    int32_t g1 = voiceTargetGain(i, top);
+    int32_t g0 = v.lastGain < 0 ? g1 : v.lastGain;
+    int32_t step = (g1 - g0) / BLOCK_SAMPLES;
+    int32_t g = g0;
+    if (lead + n > blockLen) {
+      // First voice to reach this far: nothing summed here yet
+      for (size_t k = blockLen; k < lead + n; k++) mixAcc[k] = 0;
+      blockLen = lead + n;
+    }
+    int32_t* acc = mixAcc + lead;
+    for (size_t k = 0; k < n; k++) {
+      acc[k] += (voiceBlock[k] * g) >> 15;
+      g += step;
+    }
+    v.lastGain = g1;
+
+    if (v.postedUs && !postedUs) {
+      postedUs = v.postedUs;
+      cached = v.pcm != nullptr;
+    }
+    v.postedUs = 0;
+  }
+
+  bool clipped = false;
+  for (size_t k = 0; k < blockLen; k++) {
+    int32_t s = mixAcc[k];
+    if (s > 32767) { s = 32767; clipped = true; }
+    else if (s < -32768) { s = -32768; clipped = true; }
+    out[k] = (int16_t)s;
+  }
+
+  uint32_t took = micros() - t0;
+  portENTER_CRITICAL(&statsMux);
+  if (took > stats.mixMax_us) stats.mixMax_us = took;
+  if (clipped) stats.saturatedBlocks++;
+  portEXIT_CRITICAL(&statsMux);
+  return blockLen;
+}
+
+// ============================================================================
+// I2S TASK — block until the DMA ring takes the whole block
+// ============================================================================
+static void i2sWriteBlock(const int16_t* pcm, size_t samples, uint32_t postedUs, bool cached) {
+  const uint8_t* p = (const uint8_t*)pcm;
+  size_t left = samples * 2;
+
+  uint32_t t0 = micros();
+  while (left > 0) {
+    size_t written = 0;
+    i2s_write(I2S_PORT, p, left, &written, pdMS_TO_TICKS(AUDIO_WRITE_TIMEOUT_MS));
+    if (written == 0) break;   // DMA stalled for the whole timeout
+    p += written;
+    left -= written;
+  }
+  uint32_t now = micros();
+  uint32_t took = now - t0;
+  dmaQueuedBytes += samples * 2 - left;
+
+  uint64_t nowLocal = nowUs();
+  if (took >= DMA_WAIT_ANCHOR_US) {
+    dmaTailUs = nowLocal + DMA_RING_US;
+  } else {
+    dmaTailUs += (uint64_t)(samples - left / 2) * 1000000 / SAMPLE_RATE;
+    if (dmaTailUs < nowLocal) dmaTailUs = nowLocal;   // Ring ran dry
+  }
+
+  portENTER_CRITICAL(&statsMux);
+  stats.blocks++;
+  stats.bytesPlayed += samples * 2 - left;
+  stats.droppedBytes += left;
+  if (took > stats.writeMax_us) stats.writeMax_us = took;
+  if (postedUs) {
+    // A clip's first block is in the DMA ring: trigger-to-first-sample
+    uint32_t latency = now - postedUs;
+    if (cached) {
+      stats.latencyCached_us = latency;
+      if (latency > stats.latencyCachedMax_us) stats.latencyCachedMax_us = latency;
+    } else {
+      stats.latencyStream_us = latency;
+      if (latency > stats.latencyStreamMax_us) stats.latencyStreamMax_us = latency;
+    }
+  }
+  portEXIT_CRITICAL(&statsMux);
+}
+
+static void i2sCountDmaEvents() {
+  i2s_event_t ev;
+  uint32_t starved = 0;
+  while (xQueueReceive(i2sEvents, &ev, 0) == pdTRUE) {
+    if (ev.type != I2S_EVENT_TX_DONE) continue;
+    dmaSentBytes += DMA_BUF_BYTES;
+    if (dmaSentBytes > dmaQueuedBytes) {
+      starved++;
+      dmaSentBytes = dmaQueuedBytes;
+    }
+  }
+  if (starved) {
+    portENTER_CRITICAL(&statsMux);
+    stats.underruns += starved;
+    portEXIT_CRITICAL(&statsMux);
+  }
+}
+
+// ============================================================================
+// I2S TASK — load the firmware clips into the cache
+// ============================================================================
+static void i2sPreloadClips() {
+  if (!psramFound()) {
+    LOG.println("[AUDIO] No PSRAM — clips stream from LittleFS");
     return;
   }
 
-  if (!parseWavHeader(audioFile)) {
-    LOG.printf("[AUDIO] Invalid WAV: %s\n", path.c_str());
-    audioFile.close();
+  uint32_t t0 = millis();
+  uint8_t loaded = 0;
+  Voice& v = voices[0];   // Scratch: no voice plays until this returns
+  for (size_t i = 0; i < sizeof(FIRMWARE_CLIPS) / sizeof(FIRMWARE_CLIPS[0]); i++) {
+    const char* name = FIRMWARE_CLIPS[i];
+    if (!LittleFS.exists(String("/") + name)) continue;   // Optional clips
+    if (!voiceOpenFile(v, name)) continue;
+
+    strlcpy(v.name, name, sizeof(v.name));
+    captureStart(v);
+    while (v.capture && voiceStreamBlock(v, voiceBlock, BLOCK_SAMPLES) > 0) {}
+    captureCommit(v);
+    v.file.close();
+    if (cacheFind(name)) loaded++;
+  }
+
+  LOG.printf("[AUDIO] Cached %u firmware clips (%u KB PSRAM) in %lu ms\n",
+                loaded, cacheTotalBytes / 1024, millis() - t0);
+}
+
+// ============================================================================
+// I2S TASK — scheduled cues
+//
+// playSoundAt() cues wait here until the block that contains their start
+// time is mixed, then start with a lead of silence so the first sample
+// lands on that time. Knowing when a block will be heard needs the DMA ring
+// latency, which is only exact once a write has had to wait for space — so
+// the task starts feeding silence AUDIO_CUE_PREROLL_US ahead of a cue.
+// ============================================================================
+static void pendingRelease(uint8_t n) {
+  portENTER_CRITICAL(&pendingMux);
+  playsPending = playsPending > n ? playsPending - n : 0;
+  portEXIT_CRITICAL(&pendingMux);
+}
+
+static void cuePendingRelease(uint8_t n) {
+  portENTER_CRITICAL(&pendingMux);
+  cuesPending = cuesPending > n ? cuesPending - n : 0;
+  portEXIT_CRITICAL(&pendingMux);
+}
+
+static void cueAdd(const AudioCmd& cmd) {
+  if (cueCount >= AUDIO_CUE_SLOTS) {
+    LOG.printf("[AUDIO] Cue slots full, dropped: %s\n", cmd.file);
+    portENTER_CRITICAL(&statsMux);
+    stats.cuesDropped++;
+    portEXIT_CRITICAL(&statsMux);
+    cuePendingRelease(1);
     return;
   }
+  cues[cueCount++] = cmd;
+}
+
+// Drop the cues for one voice, or all of them for AUDIO_VOICE_ANY
+static void cueCancel(int8_t voice) {
+  uint8_t dropped = 0;
+  for (uint8_t i = 0; i < cueCount; ) {
+    if (voice < 0 || cues[i].voice == voice) {
+      cues[i] = cues[--cueCount];
+      dropped++;
+    } else {
+      i++;
+    }
+  }
+  cuePendingRelease(dropped);
+}
 
-  if (wavSampleRate != SAMPLE_RATE) {
-    i2s_set_sample_rates(I2S_PORT, wavSampleRate);
+// True if a cue starts within `us` from now
+static bool cueWithin(uint64_t us) {
+  uint64_t horizon = nowUs() + us;
+  for (uint8_t i = 0; i < cueCount; i++) {
+    if (cues[i].atUs <= horizon) return true;
   }
+  return false;
+}
 
-  audioFile.seek(audioDataStart);
-  audioBytesRead = 0;
-  audioPlaying = true;
+// Ticks until the audio task must wake to pre-roll the earliest cue
+static TickType_t cueWaitTicks() {
+  if (cueCount == 0) return portMAX_DELAY;
+  uint64_t first = cues[0].atUs;
+  for (uint8_t i = 1; i < cueCount; i++) {
+    if (cues[i].atUs < first) first = cues[i].atUs;
+  }
+  uint64_t wake = nowUs() + AUDIO_CUE_PREROLL_US;
+  if (first <= wake) return 0;
+  return pdMS_TO_TICKS((first - wake) / 1000) + 1;
+}
 
-  LOG.printf("[AUDIO] Playing: %s (%dHz, %dbit, %dch, %d bytes)\n",
-                filename, wavSampleRate, wavBitsPerSample, wavChannels, audioDataSize);
+// Start every cue that falls in the block heard from blockUs onwards
+static void cueStartDue(uint64_t blockUs) {
+  for (uint8_t i = 0; i < cueCount; ) {
+    AudioCmd& c = cues[i];
+    if (c.atUs >= blockUs + BLOCK_US) {
+      i++;
+      continue;
+    }
+
+    uint16_t lead = 0;
+    uint32_t late = 0;
+    if (c.atUs >= blockUs) {
+      lead = (uint16_t)((c.atUs - blockUs) * SAMPLE_RATE / 1000000);
+    } else {
+      late = (uint32_t)(blockUs - c.atUs);
+    }
+
+    portENTER_CRITICAL(&statsMux);
+    if (late > AUDIO_CUE_MAX_LATE_US) stats.cuesDropped++;
+    else if (late) stats.cuesLate++;
+    else stats.cues++;
+    if (late > stats.cueLateMax_us) stats.cueLateMax_us = late;
+    portEXIT_CRITICAL(&statsMux);
+
+    if (late > AUDIO_CUE_MAX_LATE_US) {
+      LOG.printf("[AUDIO] Cue %s missed by %u us, dropped\n", c.file, late);
+    } else {
+      voiceStart(c, lead);
+    }
+    cuePendingRelease(1);
+    cues[i] = cues[--cueCount];
+  }
+}
+
+// Mix the block that will be heard after `queuedSamples` more samples have
+// gone to the DMA. Emits silence while a cue is pre-rolling.
+static size_t mixNext(uint8_t idx, size_t queuedSamples) {
+  if (cueCount) {
+    cueStartDue(dmaTailUs + (uint64_t)queuedSamples * 1000000 / SAMPLE_RATE);
+  }
+  size_t n = mixBlock(pcmBlock[idx], blockPostedUs[idx], blockCached[idx]);
+  if (n == 0 && cueWithin(AUDIO_CUE_PREROLL_US)) {
+    memset(pcmBlock[idx], 0, sizeof(pcmBlock[idx]));
+    n = BLOCK_SAMPLES;
+  }
+  return n;
+}
+
+// Idle → feeding: restart the DMA accounting and the output clock
+static void dmaStart() {
+  // The buffer in flight when playback starts counts as queued, so its
+  // TX_DONE is not mistaken for a starved buffer
+  i2s_zero_dma_buffer(I2S_PORT);
+  xQueueReset(i2sEvents);
+  dmaQueuedBytes = DMA_BUF_BYTES;
+  dmaSentBytes = 0;
+  // Until a write waits for space, assume a full ring of silence ahead
+  dmaTailUs = nowUs() + DMA_RING_US;
 }
 
 // ============================================================================
-// I2S STOP
+// I2S TASK
 // ============================================================================
-static void i2sStop() {
-  if (!audioInitialized) return;
+static void handleCommand(const AudioCmd& cmd) {
+  if (cmd.type == AUDIO_CMD_PLAY) {
+    if (cmd.atUs) {
+      cueAdd(cmd);   // Stays pending until it starts
+      return;
+    }
+    voiceStart(cmd, 0);
+    pendingRelease(1);
+  } else if (cmd.type == AUDIO_CMD_STOP) {
+    cueCancel(cmd.voice);
+    if (cmd.voice >= 0 && cmd.voice < AUDIO_VOICES) {
+      if (voices[cmd.voice].active) voiceStop(cmd.voice);
+    } else {
+      voiceStopAll();
+      i2s_zero_dma_buffer(I2S_PORT);
+    }
+  } else {
+    // A WAV was replaced or deleted. Stop any voice playing it first (its
+    // PCM is about to be freed, or its capture is stale).
+    for (uint8_t i = 0; i < AUDIO_VOICES; i++) {
+      if (voices[i].active && strcmp(voices[i].name, cmd.file) == 0) voiceStop(i);
+    }
+    CachedClip* c = cacheFind(cmd.file);
+    if (c) cacheFree(*c);
+  }
+}
+
+static void audioTask(void*) {
+  uint8_t cur = 0;
+  size_t curSamples = 0;
+  AudioCmd cmd;
 
-  audioPlaying = false;
-  if (audioFile) {
-    audioFile.close();
+  i2sPreloadClips();
+
+  for (;;) {
+    // Idle: sleep on the command queue until the next cue needs pre-roll.
+    // Playing: check it between blocks.
+    TickType_t wait = (voiceMask || curSamples) ? 0 : cueWaitTicks();
+    while (xQueueReceive(cmdQueue, &cmd, wait) == pdTRUE) {
+      wait = 0;
+      handleCommand(cmd);
+    }
+
+    // Starting from idle (a clip, or a cue coming up): mix the first block
+    // now rather than waiting a block behind the read-ahead
+    if (curSamples == 0) {
+      if (!voiceMask && !cueWithin(AUDIO_CUE_PREROLL_US)) continue;
+      dmaStart();
+      cur = 0;
+      curSamples = mixNext(cur, 0);
+      if (curSamples == 0) continue;
+    }
+
+    // Mix ahead before blocking on the DMA, so flash reads overlap with the
+    // buffers already queued
+    uint8_t next = cur ^ 1;
+    size_t nextSamples = mixNext(next, curSamples);
+
+    i2sWriteBlock(pcmBlock[cur], curSamples, blockPostedUs[cur], blockCached[cur]);
+    i2sCountDmaEvents();
+
+    cur = next;
+    curSamples = nextSamples;
   }
-  i2s_zero_dma_buffer(I2S_PORT);
+}
 
-  if (wavSampleRate != SAMPLE_RATE) {
-    i2s_set_sample_rates(I2S_PORT, SAMPLE_RATE);
-    wavSampleRate = SAMPLE_RATE;
+// ============================================================================
+// I2S PLAY / STOP — post to the audio task
+// ============================================================================
+static void i2sPost(const AudioCmd& cmd) {
+  if (!audioInitialized) return;
+
+  // Counted before posting so isPlaying() (or audioCuesScheduled() for
+  // a cue) is true from the moment playSound() returns; the task takes it
+  // back once the voice starts
+  volatile uint8_t& pending = cmd.atUs ? cuesPending : playsPending;
+  if (cmd.type == AUDIO_CMD_PLAY) {
+    portENTER_CRITICAL(&pendingMux);
+    pending++;
+    portEXIT_CRITICAL(&pendingMux);
+  }
+  if (xQueueSend(cmdQueue, &cmd, 0) != pdTRUE) {
+    if (cmd.type == AUDIO_CMD_PLAY) {
+      portENTER_CRITICAL(&pendingMux);
+      pending--;
+      portEXIT_CRITICAL(&pendingMux);
+    }
+    LOG.println("[AUDIO] Command queue full, dropped");
   }
 }
 
@@ -233,6 +1011,7 @@ static void i2sStop() {
 // PUBLIC API — dispatches to active backend
 // ============================================================================
 void audioSetup() {
+  HEAP_TAG(AUDIO);
   if (!cfg.audio_enabled) return;
 
   if (strcmp(cfg.audio_backend, "dysv5w") == 0) {
@@ -251,40 +1030,130 @@ void audioSetup() {
 }
 
 void audioLoop() {
-  if (activeBackend == BACKEND_I2S) {
-    i2sLoop();
+  HEAP_TAG(AUDIO);
+  if (activeBackend == BACKEND_DYSV5W) {
+    dysv5wLoop();   // Sends queued commands, tracks BUSY
+
+    // Fire the earliest due cue; any others due go on later passes, so a
+    // countdown plays every beep in order
+    DyCue due = {};
+    uint64_t now = nowUs();
+    portENTER_CRITICAL(&dyCueMux);
+    int8_t first = -1;
+    for (uint8_t i = 0; i < dyCueCount; i++) {
+      if (dyCues[i].atUs <= now && (first < 0 || dyCues[i].atUs < dyCues[first].atUs)) {
+        first = i;
+      }
+    }
+    if (first >= 0) {
+      due = dyCues[first];
+      dyCues[first] = dyCues[--dyCueCount];
+    }
+    portEXIT_CRITICAL(&dyCueMux);
+
+    if (due.track) {
+      uint64_t lateUs = now - due.atUs;
+      uint32_t late = lateUs > UINT32_MAX ? UINT32_MAX : (uint32_t)lateUs;
+      portENTER_CRITICAL(&statsMux);
+      if (late > AUDIO_CUE_MAX_LATE_US) stats.cuesDropped++;
+      else if (late > 1000) stats.cuesLate++;   // loop() jitter under 1 ms is on time
+      else stats.cues++;
+      if (late > stats.cueLateMax_us) stats.cueLateMax_us = late;
+      portEXIT_CRITICAL(&statsMux);
+
+      if (late > AUDIO_CUE_MAX_LATE_US) {
+        LOG.printf("[AUDIO] Cue track %u missed by %u us, dropped\n", due.track, late);
+      } else {
+        dysv5wPlayTrack(due.track, true);   // A cue is due now, not after the clip playing
+      }
+    }
   }
-  // DY-SV5W is fire-and-forget, no loop needed
 }
 
-void playSound(const char* filename) {
+void playSound(const char* filename, AudioPriority priority, int8_t voice) {
+  HEAP_TAG(AUDIO);
   if (activeBackend == BACKEND_I2S) {
-    i2sPlaySound(filename);
+    AudioCmd cmd = {};
+    cmd.type = AUDIO_CMD_PLAY;
+    cmd.priority = priority;
+    cmd.voice = voice;
+    cmd.postedUs = micros();
+    strlcpy(cmd.file, filename, sizeof(cmd.file));
+    i2sPost(cmd);
   } else if (activeBackend == BACKEND_DYSV5W) {
     uint16_t track = dysv5wLookupTrack(filename);
     if (track > 0) {
-      dysv5wPlayTrack(track);
+      dysv5wPlayTrack(track, priority == AUDIO_PRIO_HIGH);
     }
   }
 }
 
-void stopSound() {
+void playSoundAt(const char* filename, uint64_t fleetTimeUs, AudioPriority priority,
+                 int8_t voice) {
+  HEAP_TAG(AUDIO);
+  uint64_t atUs = fleetToLocalUs(fleetTimeUs);
+  if (atUs == 0) atUs = 1;   // 0 means "now" in AudioCmd
+
   if (activeBackend == BACKEND_I2S) {
-    i2sStop();
+    AudioCmd cmd = {};
+    cmd.type = AUDIO_CMD_PLAY;
+    cmd.priority = priority;
+    cmd.voice = voice;
+    cmd.postedUs = micros();
+    cmd.atUs = atUs;
+    strlcpy(cmd.file, filename, sizeof(cmd.file));
+    i2sPost(cmd);
   } else if (activeBackend == BACKEND_DYSV5W) {
+    uint16_t track = dysv5wLookupTrack(filename);
+    if (track == 0) return;
+    bool added = false;
+    portENTER_CRITICAL(&dyCueMux);
+    if (dyCueCount < AUDIO_CUE_SLOTS) {
+      dyCues[dyCueCount++] = {track, atUs};
+      added = true;
+    }
+    portEXIT_CRITICAL(&dyCueMux);
+    if (!added) {
+      LOG.printf("[AUDIO] Cue slots full, dropped: %s\n", filename);
+      portENTER_CRITICAL(&statsMux);
+      stats.cuesDropped++;
+      portEXIT_CRITICAL(&statsMux);
+    }
+  }
+}
+
+void stopSound(int8_t voice) {
+  if (activeBackend == BACKEND_I2S) {
+    AudioCmd cmd = {};
+    cmd.type = AUDIO_CMD_STOP;
+    cmd.voice = voice;
+    i2sPost(cmd);
+  } else if (activeBackend == BACKEND_DYSV5W) {
+    portENTER_CRITICAL(&dyCueMux);
+    dyCueCount = 0;
+    portEXIT_CRITICAL(&dyCueMux);
     dysv5wStop();
   }
 }
 
 bool isPlaying() {
   if (activeBackend == BACKEND_I2S) {
-    return audioPlaying;
+    return voiceMask != 0 || playsPending != 0;
   } else if (activeBackend == BACKEND_DYSV5W) {
     return dysv5wIsBusy();
   }
   return false;
 }
 
+uint8_t audioCuesScheduled() {
+  if (activeBackend == BACKEND_I2S) {
+    return cuesPending;
+  } else if (activeBackend == BACKEND_DYSV5W) {
+    return dyCueCount;
+  }
+  return 0;
+}
+
 void setVolume(uint8_t level) {
   if (activeBackend == BACKEND_I2S) {
     if (level > 21) level = 21;
@@ -296,6 +1165,12 @@ void setVolume(uint8_t level) {
   }
 }
 
+void setVoiceGain(uint8_t voice, uint8_t percent) {
+  if (voice >= AUDIO_VOICES) return;
+  if (percent > 100) percent = 100;
+  voiceGain[voice] = (uint16_t)(((uint32_t)percent * GAIN_UNITY) / 100);
+}
+
 String getAudioFileList() {
   String json = "[";
   File root = LittleFS.open("/");
@@ -313,3 +1188,49 @@ String getAudioFileList() {
   json += "]";
   return json;
 }
+
+void audioWriteStats(JsonWriter& w) {
+  if (activeBackend == BACKEND_DYSV5W) {
+    dysv5wWriteStats(w);
+    return;
+  }
+  if (activeBackend != BACKEND_I2S) return;
+  AudioStats s;
+  portENTER_CRITICAL(&statsMux);
+  s = stats;
+  portEXIT_CRITICAL(&statsMux);
+  w.field("voices", AUDIO_VOICES)
+   .field("voices_active", (uint8_t)__builtin_popcount(voiceMask))
+   .field("voices_max", s.voicesMax)
+   .field("voice_steals", s.voiceSteals)
+   .field("clips_rejected", s.clipsRejected)
+   .field("saturated_blocks", s.saturatedBlocks)
+   .field("mix_max_us", s.mixMax_us)
+   .field("clips", s.clips)
+   .field("blocks", s.blocks)
+   .field("bytes_played", s.bytesPlayed)
+   .field("underruns", s.underruns)
+   .field("dropped_bytes", s.droppedBytes)
+   .field("read_max_us", s.readMax_us)
+   .field("flash_bytes_read", s.flashBytesRead)
+   .field("write_max_us", s.writeMax_us)
+   .field("cache_hits", s.cacheHits)
+   .field("cache_misses", s.cacheMisses)
+   .field("latency_cached_us", s.latencyCached_us)
+   .field("latency_cached_max_us", s.latencyCachedMax_us)
+   .field("latency_stream_us", s.latencyStream_us)
+   .field("latency_stream_max_us", s.latencyStreamMax_us)
+   .field("cues", s.cues)
+   .field("cues_late", s.cuesLate)
+   .field("cues_dropped", s.cuesDropped)
+   .field("cue_late_max_us", s.cueLateMax_us);
+}
+
+void audioInvalidateClip(const char* path) {
+  if (activeBackend != BACKEND_I2S) return;
+  if (path[0] == '/') path++;
+  AudioCmd cmd = {};
+  cmd.type = AUDIO_CMD_INVALIDATE;
+  strlcpy(cmd.file, path, sizeof(cmd.file));
+  i2sPost(cmd);
+}
@@ -2,35 +2,109 @@
 #define AUDIO_MANAGER_H
 
 #include <Arduino.h>
+#include "json_writer.h"
 
 // ============================================================================
 // Audio Manager — Unified API for I2S (MAX98357A) and UART (DY-SV5W) backends
 // ============================================================================
 // Backend is selected by cfg.audio_backend: "i2s" or "dysv5w"
 // All callers use the same API regardless of backend.
+//
+// I2S playback runs on its own task (Core 0). playSound()/stopSound() post a
+// command and return; the task reads the WAV one block ahead of the block it
+// is writing and blocks in i2s_write() until the DMA ring has room, so a busy
+// loop() or a slow LittleFS read no longer skips or repeats audio. The DMA
+// ring holds DMA_BUF_COUNT x DMA_BUF_LEN samples (128 ms at 16 kHz) — a read
+// that stalls longer than that is counted as an underrun.
+//
+// The task mixes up to AUDIO_VOICES clips at once. A new clip takes a free
+// voice, else the oldest voice whose priority is not above its own; if all
+// are busy with higher-priority clips it is dropped. While any voice is
+// playing, voices of lower priority are ducked to AUDIO_DUCK_GAIN.
+//
+// Clips are played from a PSRAM cache of decoded 16-bit PCM when possible:
+// the firmware clips are loaded when the task starts, and any other clip
+// that plays to the end is kept in an LRU. A cached clip starts without
+// touching LittleFS.
+//
+// playSoundAt() schedules a clip on the fleet clock (see espnow_comm.h). The
+// task tracks when each mixed block will leave the DAC and starts the clip
+// part-way into the block that contains its time, so speakers on different
+// nodes start within the clock-sync error of each other, not a block.
+
+#define AUDIO_TASK_STACK        4096
+#define AUDIO_TASK_PRIORITY     2       // Above storage/log drain, below WiFi
+#define AUDIO_CMD_QUEUE_DEPTH   4
+#define AUDIO_WRITE_TIMEOUT_MS  100     // i2s_write() wait before bytes are dropped
+#define AUDIO_VOICES            4
+#define AUDIO_VOICE_ANY         -1
+#define AUDIO_DUCK_GAIN         9830    // Q15: lower-priority voices at ~30%
+#define AUDIO_CACHE_SLOTS       16
+#define AUDIO_CACHE_LRU_BYTES   (1024 * 1024)   // Non-firmware clips, evicted LRU
+#define AUDIO_CACHE_MAX_CLIP_BYTES (256 * 1024) // ~8 s at 16 kHz; longer clips always stream
+#define AUDIO_CUE_SLOTS         8       // playSoundAt() cues waiting for their time
+#define AUDIO_CUE_PREROLL_US    250000  // Feed the DMA silence this far ahead of a cue
+#define AUDIO_CUE_MAX_LATE_US   50000   // A cue missed by more than this is dropped
+
+enum AudioPriority : uint8_t {
+  AUDIO_PRIO_LOW = 0,       // Ambience, lab prompts — ducked under everything
+  AUDIO_PRIO_NORMAL,        // Default
+  AUDIO_PRIO_HIGH           // Race-critical cues (go, finish)
+};
 
 // Initialize the audio backend. No-op if audio not enabled in config.
 // Call once from setup().
 void audioSetup();
 
-// Feed DMA buffer (I2S backend only). Non-blocking — call every loop().
-// No-op for DY-SV5W backend (UART is fire-and-forget).
+// Call every loop(). Drains the DY-SV5W command queue; no-op for I2S (the
+// audio task feeds the DMA).
 void audioLoop();
 
 // Play a sound clip by filename (e.g. "armed.wav", "speed_trap.wav").
-// I2S: opens WAV from LittleFS. DY-SV5W: maps name to track number.
-void playSound(const char* filename);
+// I2S: mixed with whatever is playing, on `voice` if given (replacing its
+// clip) or on a voice picked by priority. DY-SV5W: maps name to track
+// number and queues it behind the clip playing; AUDIO_PRIO_HIGH cuts in
+// instead. Voice is ignored (one clip at a time).
+void playSound(const char* filename, AudioPriority priority = AUDIO_PRIO_NORMAL,
+               int8_t voice = AUDIO_VOICE_ANY);
 
-// Stop any currently playing sound immediately.
-void stopSound();
+// Play a clip when the fleet clock reaches fleetTimeUs (fleetNowUs() + lead).
+// I2S: sample-aligned to the output clock; needs the lead to reach the
+// audio task, and a cue more than AUDIO_CUE_MAX_LATE_US late is dropped.
+// DY-SV5W: fired in time order from audioLoop(), so only as exact as
+// loop() is. To play a cue on other nodes as well, see sendAudioCueAll().
+void playSoundAt(const char* filename, uint64_t fleetTimeUs,
+                 AudioPriority priority = AUDIO_PRIO_NORMAL, int8_t voice = AUDIO_VOICE_ANY);
 
-// Returns true if a sound is currently playing.
+// Stop one voice, or every sound when voice is AUDIO_VOICE_ANY. Scheduled
+// cues for that voice (or all of them) are cancelled too.
+void stopSound(int8_t voice = AUDIO_VOICE_ANY);
+
+// Returns true if a sound is currently playing (or posted to start now).
+// Cues scheduled with playSoundAt() count only once they start.
 bool isPlaying();
 
+// Cues scheduled with playSoundAt() that have not started (or been dropped)
+// yet. Up to AUDIO_CUE_SLOTS on either backend.
+uint8_t audioCuesScheduled();
+
 // Set volume level. I2S: 0-21. DY-SV5W: 0-30.
 void setVolume(uint8_t level);
 
+// Per-voice gain, 0-100% (I2S only), applied on top of the volume level
+void setVoiceGain(uint8_t voice, uint8_t percent);
+
 // Get list of WAV files in LittleFS as JSON array string
 String getAudioFileList();
 
+// Drop a cached clip after its WAV was replaced or deleted ("/go.wav" or
+// "go.wav"). I2S backend only.
+void audioInvalidateClip(const char* path);
+
+// Write playback counters (voices, blocks, underruns, dropped bytes,
+// read/write/mix time, cache hits, trigger-to-first-sample latency and
+// scheduled cues on time/late/dropped) into an open JSON object (fields
+// only). DY-SV5W: its command queue and BUSY counters instead.
+void audioWriteStats(JsonWriter& w);
+
 #endif
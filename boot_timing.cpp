@@ -0,0 +1,43 @@
+#include "boot_timing.h"
+#include "config.h"
+#include <esp_timer.h>
+
+static const char* const PHASE_NAMES[BOOT_PHASE_COUNT] = {
+  "serial", "fs", "config", "wifi_start", "espnow", "race_ready",
+  "peripherals", "logs", "web", "setup_done", "wifi_up"
+};
+
+// Microseconds since app start; 0 = not reached
+static int64_t phaseUs[BOOT_PHASE_COUNT];
+
+void bootMark(BootPhase phase) {
+  if (phase >= BOOT_PHASE_COUNT || phaseUs[phase] != 0) return;
+  phaseUs[phase] = esp_timer_get_time();
+}
+
+uint32_t bootPhaseMs(BootPhase phase) {
+  if (phase >= BOOT_PHASE_COUNT) return 0;
+  return (uint32_t)((phaseUs[phase] + 999) / 1000);
+}
+
+void bootTimingLog() {
+  char line[256];
+  int pos = snprintf(line, sizeof(line), "[BOOT] Phases (ms):");
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT && pos < (int)sizeof(line); i++) {
+    if (phaseUs[i] == 0) continue;
+    pos += snprintf(line + pos, sizeof(line) - pos, " %s=%u", PHASE_NAMES[i],
+                    bootPhaseMs((BootPhase)i));
+  }
+  LOG.println(line);
+}
+
+void bootTimingWrite(JsonWriter& w) {
+  w.beginObject("phases_ms");
+  for (uint8_t i = 0; i < BOOT_PHASE_COUNT; i++) {
+    if (phaseUs[i] == 0) w.fieldNull(PHASE_NAMES[i]);
+    else w.field(PHASE_NAMES[i], phaseUs[i] / 1000.0, 1);
+  }
+  w.endObject();
+  w.field("race_ready_ms", bootPhaseMs(BOOT_RACE_READY))
+   .field("wifi_ms", bootPhaseMs(BOOT_WIFI_UP));
+}
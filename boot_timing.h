@@ -0,0 +1,48 @@
+#ifndef BOOT_TIMING_H
+#define BOOT_TIMING_H
+
+#include <Arduino.h>
+#include "json_writer.h"
+
+// ============================================================================
+// BOOT TIMING — When each bring-up phase finished, for /api/diagnostics
+//
+// setup() marks each phase as it completes; times are milliseconds since the
+// app started (esp_timer), so the ROM/bootloader time before that is not
+// included. WiFi association runs in the background, so BOOT_WIFI_UP is
+// usually marked from loop(), after setup() has returned.
+//
+// The order below is the bring-up order. A timing node is race-ready at
+// BOOT_RACE_READY: ESP-NOW is up and the role's ISRs are attached. The LiDAR,
+// audio, web UI, OTA and mDNS come after that.
+// ============================================================================
+
+enum BootPhase : uint8_t {
+  BOOT_SERIAL = 0,     // serialTee up, banner printed
+  BOOT_FS,             // LittleFS mounted
+  BOOT_CONFIG,         // config.json loaded
+  BOOT_WIFI_START,     // STA association started (or the AP is up)
+  BOOT_ESPNOW,         // ESP-NOW up, saved peers registered
+  BOOT_RACE_READY,     // Role setup done: sensor ISRs attached
+  BOOT_PERIPHERALS,    // LiDAR UART and audio backend started
+  BOOT_LOGS,           // Race log index, leaderboard, run log, storage task
+  BOOT_WEB,            // HTTP + WebSocket listening, OTA, mDNS
+  BOOT_SETUP_DONE,     // End of setup()
+  BOOT_WIFI_UP,        // STA associated and got an IP
+  BOOT_PHASE_COUNT
+};
+
+// Record the time a phase completed. Only the first mark of a phase counts.
+void bootMark(BootPhase phase);
+
+// Milliseconds since app start when the phase completed, 0 = not reached
+uint32_t bootPhaseMs(BootPhase phase);
+
+// Print one line with every phase reached so far
+void bootTimingLog();
+
+// Write "phases_ms": {...} plus race_ready_ms / wifi_ms into an open JSON
+// object (fields only)
+void bootTimingWrite(JsonWriter& w);
+
+#endif
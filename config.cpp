@@ -1,74 +1,222 @@
 #include "config.h"
+#include "metrics.h"
+#include "run_log.h"
+#include "storage.h"
+#include "heap_track.h"
 #include <ArduinoJson.h>
 #include <LittleFS.h>
 #include <Preferences.h>
 #include <esp_mac.h>
+#include <sys/time.h>
+#include <esp_rom_crc.h>
 
 // NVS namespace for config backup (survives LittleFS wipes)
 #define NVS_NAMESPACE "masstrap"
 
 DeviceConfig cfg;
 
-void setDefaults(DeviceConfig& c) {
-  c.configured = false;
-  c.version = CONFIG_VERSION;
-
-  memset(c.wifi_ssid, 0, sizeof(c.wifi_ssid));
-  memset(c.wifi_pass, 0, sizeof(c.wifi_pass));
-  strncpy(c.hostname, "masstrap", sizeof(c.hostname) - 1);
-  strncpy(c.network_mode, "wifi", sizeof(c.network_mode) - 1);
+// ============================================================================
+// FIELD TABLE HELPERS — one macro per CONFIG_FIELDS type, so every generated
+// function is a single CONFIG_FIELDS(...) expansion
+// ============================================================================
+static void copyStr(char* dst, size_t size, const char* src) {
+  strncpy(dst, src ? src : "", size - 1);
+  dst[size - 1] = '\0';
+}
 
-  strncpy(c.role, "finish", sizeof(c.role) - 1);
+// Defaults
+#define CFG_DEFAULT_STR(m, d)    copyStr(m, sizeof(m), d)
+#define CFG_DEFAULT_MAC(m, d)    parseMacString(d, m)
+#define CFG_DEFAULT_BOOL(m, d)   m = d
+#define CFG_DEFAULT_U8(m, d)     m = d
+#define CFG_DEFAULT_U16(m, d)    m = d
+#define CFG_DEFAULT_INT(m, d)    m = d
+#define CFG_DEFAULT_FLOAT(m, d)  m = d
+
+// JSON out
+#define CFG_PUT_STR(o, k, m)     o[k] = (const char*)m
+#define CFG_PUT_MAC(o, k, m)     o[k] = formatMac(m)
+#define CFG_PUT_BOOL(o, k, m)    o[k] = m
+#define CFG_PUT_U8(o, k, m)      o[k] = m
+#define CFG_PUT_U16(o, k, m)     o[k] = m
+#define CFG_PUT_INT(o, k, m)     o[k] = m
+#define CFG_PUT_FLOAT(o, k, m)   o[k] = m
+
+// JSON in — a missing key takes the table default, as the hand-written
+// parser did
+#define CFG_GET_STR(o, k, m, d)    copyStr(m, sizeof(m), o[k] | d)
+#define CFG_GET_MAC(o, k, m, d)    parseMacString(o[k] | d, m)
+#define CFG_GET_BOOL(o, k, m, d)   m = o[k] | (bool)(d)
+#define CFG_GET_U8(o, k, m, d)     m = o[k] | (uint8_t)(d)
+#define CFG_GET_U16(o, k, m, d)    m = o[k] | (uint16_t)(d)
+#define CFG_GET_INT(o, k, m, d)    m = o[k] | (int)(d)
+#define CFG_GET_FLOAT(o, k, m, d)  m = o[k] | (float)(d)
+
+// Range check — numeric types only
+#define CFG_CHECK_NUM(m, name, lo, hi) \
+  if ((double)(m) < (double)(lo) || (double)(m) > (double)(hi)) { \
+    LOG.printf("[CONFIG] %s out of range (%g, allowed %g-%g)\n", name, (double)(m), (double)(lo), (double)(hi)); \
+    return false; \
+  }
+#define CFG_CHECK_STR(m, name, lo, hi)
+#define CFG_CHECK_MAC(m, name, lo, hi)
+#define CFG_CHECK_BOOL(m, name, lo, hi)
+#define CFG_CHECK_U8(m, name, lo, hi)     CFG_CHECK_NUM(m, name, lo, hi)
+#define CFG_CHECK_U16(m, name, lo, hi)    CFG_CHECK_NUM(m, name, lo, hi)
+#define CFG_CHECK_INT(m, name, lo, hi)    CFG_CHECK_NUM(m, name, lo, hi)
+#define CFG_CHECK_FLOAT(m, name, lo, hi)  CFG_CHECK_NUM(m, name, lo, hi)
+
+// Binary image — force string termination after unpacking
+#define CFG_FIX_STR(m)    m[sizeof(m) - 1] = '\0'
+#define CFG_FIX_MAC(m)
+#define CFG_FIX_BOOL(m)
+#define CFG_FIX_U8(m)
+#define CFG_FIX_U16(m)
+#define CFG_FIX_INT(m)
+#define CFG_FIX_FLOAT(m)
+
+// Walk (and optionally create) a "a/b" group path below root
+static JsonObject configGroup(JsonObject root, const char* path, bool create) {
+  JsonObject obj = root;
+  while (*path) {
+    const char* slash = strchr(path, '/');
+    size_t n = slash ? (size_t)(slash - path) : strlen(path);
+    char part[24];
+    if (n >= sizeof(part)) n = sizeof(part) - 1;
+    memcpy(part, path, n);
+    part[n] = '\0';
+    JsonObject next = obj[part];
+    if (next.isNull()) {
+      if (!create) return JsonObject();
+      next = obj.createNestedObject(part);
+    }
+    obj = next;
+    path += slash ? n + 1 : n;
+  }
+  return obj;
+}
 
+uint8_t configDefaultDeviceId() {
   // Derive default device ID from MAC address to avoid collisions
   // when multiple devices all default to ID 1
   uint8_t mac[6];
   esp_efuse_mac_get_default(mac);
-  c.device_id = (mac[5] % 253) + 1;  // 1-254 range
-
-  c.sensor_pin = 4;
-  c.sensor_pin_2 = 5;    // Speed trap second sensor
-  c.led_pin = 2;
-
-  // Audio — disabled by default, I2S backend for backwards compatibility
-  c.audio_enabled = false;
-  strncpy(c.audio_backend, "i2s", sizeof(c.audio_backend) - 1);
-  c.i2s_bclk_pin = 15;
-  c.i2s_lrc_pin = 16;
-  c.i2s_dout_pin = 17;
-  c.audio_volume = 10;
-  c.dysv5w_tx_pin = 15;   // Default UART TX to DY-SV5W RXD
-  c.dysv5w_busy_pin = 16; // Default BUSY (DY-SV5W I/O1, LOW = playing)
-
-  // LiDAR Sensor (TF-Luna UART) — disabled by default
-  c.lidar_enabled = false;
-  c.lidar_rx_pin = 39;
-  c.lidar_tx_pin = 38;
-  c.lidar_threshold_mm = 50;
-
-  // Speed Trap
-  c.sensor_spacing_m = 0.10f;
-
-  memset(c.peer_mac, 0, 6);
-
-  c.track_length_m = 2.0f;
-  c.scale_factor = 64;
-
-  memset(c.google_sheets_url, 0, sizeof(c.google_sheets_url));
-  memset(c.wled_host, 0, sizeof(c.wled_host));
-  c.wled_effect_idle = 0;
-  c.wled_effect_armed = 28;
-  c.wled_effect_racing = 49;
-  c.wled_effect_finished = 11;
-
-  // Regional / Display
-  strncpy(c.units, "imperial", sizeof(c.units) - 1);      // Default: imperial (mph, ft) — US users
-  strncpy(c.timezone, "EST5EDT,M3.2.0,M11.1.0", sizeof(c.timezone) - 1);  // Default: US Eastern
-
-  strncpy(c.ota_password, "admin", sizeof(c.ota_password) - 1);
-
-  // Viewer password — blank = open access (backwards compatible)
-  memset(c.viewer_password, 0, sizeof(c.viewer_password));
+  return (mac[5] % 253) + 1;  // 1-254 range
+}
+
+void setDefaults(DeviceConfig& c) {
+#define X(type, group, key, member, def, lo, hi) CFG_DEFAULT_##type(c.member, def);
+  CONFIG_FIELDS(X)
+#undef X
+}
+
+// ============================================================================
+// BINARY IMAGE — DeviceConfig in NVS, packed field by field in table order
+//
+// The primary boot source: one NVS read and a CRC instead of reading and
+// parsing /config.json. The schema id is a CRC of every row's type, path
+// and size, so an image written by firmware with a different table is
+// ignored (and rewritten from the JSON) rather than misread.
+// ============================================================================
+#define CONFIG_BLOB_KEY     "cfg_bin"
+#define CONFIG_BLOB_MAGIC   0x4643544D   // "MTCF"
+#define CONFIG_BLOB_FORMAT  1
+
+struct __attribute__((packed)) ConfigBlobHeader {
+  uint32_t magic;
+  uint16_t format;
+  uint16_t length;    // Payload bytes after the header
+  uint32_t schema;    // configSchemaId() of the writer
+  uint32_t crc;       // CRC32 of the payload
+};
+
+#define X(type, group, key, member, def, lo, hi) + sizeof(DeviceConfig::member)
+static const size_t CONFIG_BLOB_PAYLOAD = 0 CONFIG_FIELDS(X);
+#undef X
+
+#define X(type, group, key, member, def, lo, hi) #type ":" group "/" key ";"
+static const char CONFIG_SCHEMA[] = CONFIG_FIELDS(X);
+#undef X
+
+static uint32_t configSchemaId() {
+  uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)CONFIG_SCHEMA, sizeof(CONFIG_SCHEMA) - 1);
+  uint16_t size;
+#define X(type, group, key, member, def, lo, hi) \
+  size = sizeof(DeviceConfig::member); \
+  crc = esp_rom_crc32_le(crc, (const uint8_t*)&size, sizeof(size));
+  CONFIG_FIELDS(X)
+#undef X
+  return crc;
+}
+
+static void packConfig(const DeviceConfig& c, uint8_t* out) {
+  size_t off = 0;
+#define X(type, group, key, member, def, lo, hi) \
+  memcpy(out + off, &c.member, sizeof(c.member)); off += sizeof(c.member);
+  CONFIG_FIELDS(X)
+#undef X
+}
+
+static void unpackConfig(DeviceConfig& c, const uint8_t* in) {
+  size_t off = 0;
+#define X(type, group, key, member, def, lo, hi) \
+  memcpy(&c.member, in + off, sizeof(c.member)); off += sizeof(c.member); CFG_FIX_##type(c.member);
+  CONFIG_FIELDS(X)
+#undef X
+}
+
+static bool saveConfigImage(Preferences& prefs) {
+  uint8_t buf[sizeof(ConfigBlobHeader) + CONFIG_BLOB_PAYLOAD];
+  uint8_t* payload = buf + sizeof(ConfigBlobHeader);
+  packConfig(cfg, payload);
+  ConfigBlobHeader h = {};
+  h.magic = CONFIG_BLOB_MAGIC;
+  h.format = CONFIG_BLOB_FORMAT;
+  h.length = CONFIG_BLOB_PAYLOAD;
+  h.schema = configSchemaId();
+  h.crc = esp_rom_crc32_le(0, payload, CONFIG_BLOB_PAYLOAD);
+  memcpy(buf, &h, sizeof(h));
+  return prefs.putBytes(CONFIG_BLOB_KEY, buf, sizeof(buf)) == sizeof(buf);
+}
+
+static bool loadConfigImage() {
+  uint8_t buf[sizeof(ConfigBlobHeader) + CONFIG_BLOB_PAYLOAD];
+  Preferences prefs;
+  if (!prefs.begin(NVS_NAMESPACE, true)) return false;  // read-only
+  bool present = prefs.isKey(CONFIG_BLOB_KEY);
+  size_t len = present ? prefs.getBytesLength(CONFIG_BLOB_KEY) : 0;
+  bool read = present && len == sizeof(buf) && prefs.getBytes(CONFIG_BLOB_KEY, buf, sizeof(buf)) == sizeof(buf);
+  prefs.end();
+  if (!present) return false;
+
+  ConfigBlobHeader h;
+  memcpy(&h, buf, sizeof(h));
+  if (!read || h.magic != CONFIG_BLOB_MAGIC || h.format != CONFIG_BLOB_FORMAT ||
+      h.length != CONFIG_BLOB_PAYLOAD || h.schema != configSchemaId()) {
+    LOG.println("[CONFIG] Binary config is from another firmware layout — loading config.json");
+    return false;
+  }
+  const uint8_t* payload = buf + sizeof(ConfigBlobHeader);
+  if (esp_rom_crc32_le(0, payload, CONFIG_BLOB_PAYLOAD) != h.crc) {
+    LOG.println("[CONFIG] Binary config CRC mismatch — loading config.json");
+    return false;
+  }
+
+  DeviceConfig c = cfg;
+  unpackConfig(c, payload);
+  if (!c.configured) return false;
+  cfg = c;
+  LOG.printf("[CONFIG] Loaded %u-byte binary config from NVS: role=%s, hostname=%s, wifi=%s\n",
+             (unsigned)CONFIG_BLOB_PAYLOAD, cfg.role, cfg.hostname, cfg.wifi_ssid);
+  return true;
+}
+
+void configInvalidateImage() {
+  Preferences prefs;
+  if (prefs.begin(NVS_NAMESPACE, false)) {
+    if (prefs.isKey(CONFIG_BLOB_KEY)) prefs.remove(CONFIG_BLOB_KEY);
+    prefs.end();
+  }
 }
 
 // Attempt to restore config from NVS backup (survives LittleFS wipes)
@@ -102,9 +250,26 @@ static bool loadConfigFromNVS() {
   return true;
 }
 
+static bool loadConfigFromFile();
+
 bool loadConfig() {
   setDefaults(cfg);
 
+  if (loadConfigImage()) return true;
+  setDefaults(cfg);
+  if (!loadConfigFromFile()) return false;
+
+  // First boot on this firmware, or the image was stale: cache it so the
+  // next boot skips the JSON
+  Preferences prefs;
+  if (prefs.begin(NVS_NAMESPACE, false)) {
+    if (saveConfigImage(prefs)) LOG.println("[CONFIG] Binary config image written to NVS");
+    prefs.end();
+  }
+  return true;
+}
+
+static bool loadConfigFromFile() {
   if (!LittleFS.exists(CONFIG_FILE)) {
     LOG.println("[CONFIG] No config file found on LittleFS");
     // Try NVS backup before giving up
@@ -181,29 +346,35 @@ bool loadConfig() {
 bool saveConfig() {
   String json = configToJson();
 
+  bool fileOk = false;
   File file = LittleFS.open(CONFIG_FILE, "w");
-  if (!file) {
+  if (file) {
+    metricInc(MET_FS_BYTES_WRITTEN, file.print(json));
+    file.close();
+    fileOk = true;
+    LOG.println("[CONFIG] Config saved to LittleFS");
+  } else {
     LOG.println("[CONFIG] Failed to open config file for writing");
-    return false;
   }
 
-  file.print(json);
-  file.close();
-  LOG.println("[CONFIG] Config saved to LittleFS");
-
-  // Backup critical boot fields to NVS (survives LittleFS wipes from uploadfs)
+  // Binary image (primary boot source) + critical boot fields as separate
+  // keys (survive LittleFS wipes from uploadfs, and an image from a
+  // firmware with a different field table)
+  bool imageOk = false;
   Preferences prefs;
   if (prefs.begin(NVS_NAMESPACE, false)) {
+    imageOk = saveConfigImage(prefs);
+    if (!imageOk) LOG.println("[CONFIG] Failed to write binary config to NVS");
     prefs.putString("wifi_ssid", cfg.wifi_ssid);
     prefs.putString("wifi_pass", cfg.wifi_pass);
     prefs.putString("hostname",  cfg.hostname);
     prefs.putString("role",      cfg.role);
     prefs.putBool("configured",  cfg.configured);
     prefs.end();
-    LOG.println("[CONFIG] NVS backup saved (wifi/role/hostname)");
+    LOG.println("[CONFIG] NVS backup saved (binary image + wifi/role/hostname)");
   }
 
-  return true;
+  return fileOk || imageOk;
 }
 
 bool isValidGPIO(uint8_t pin) {
@@ -215,6 +386,11 @@ bool isValidGPIO(uint8_t pin) {
 }
 
 bool validateConfig(const DeviceConfig& c) {
+  // Numeric ranges from the field table
+#define X(type, group, key, member, def, lo, hi) CFG_CHECK_##type(c.member, group "/" key, lo, hi)
+  CONFIG_FIELDS(X)
+#undef X
+
   if (!isValidGPIO(c.sensor_pin)) {
     LOG.printf("[CONFIG] Invalid sensor pin: %d\n", c.sensor_pin);
     return false;
@@ -227,18 +403,6 @@ bool validateConfig(const DeviceConfig& c) {
     LOG.println("[CONFIG] Sensor and LED pins cannot be the same");
     return false;
   }
-  if (c.device_id == 0) {
-    LOG.println("[CONFIG] Device ID must be > 0");
-    return false;
-  }
-  if (c.track_length_m <= 0 || c.track_length_m > 100) {
-    LOG.println("[CONFIG] Track length must be 0-100m");
-    return false;
-  }
-  if (c.scale_factor < 1 || c.scale_factor > 1000) {
-    LOG.println("[CONFIG] Scale factor must be 1-1000");
-    return false;
-  }
   if (strlen(c.hostname) == 0) {
     LOG.println("[CONFIG] Hostname cannot be empty");
     return false;
@@ -253,68 +417,14 @@ bool validateConfig(const DeviceConfig& c) {
 }
 
 String configToJson() {
+  HEAP_TAG(JSON);
   StaticJsonDocument<2560> doc;
+  JsonObject root = doc.to<JsonObject>();
 
-  doc["configured"] = cfg.configured;
-  doc["version"] = cfg.version;
-
-  JsonObject network = doc.createNestedObject("network");
-  network["wifi_ssid"] = cfg.wifi_ssid;
-  network["wifi_pass"] = cfg.wifi_pass;
-  network["hostname"] = cfg.hostname;
-  network["mode"] = cfg.network_mode;
-
-  JsonObject device = doc.createNestedObject("device");
-  device["role"] = cfg.role;
-  device["id"] = cfg.device_id;
-
-  JsonObject pins = doc.createNestedObject("pins");
-  pins["sensor_pin"] = cfg.sensor_pin;
-  pins["sensor_pin_2"] = cfg.sensor_pin_2;
-  pins["led_pin"] = cfg.led_pin;
-
-  JsonObject audio = doc.createNestedObject("audio");
-  audio["enabled"] = cfg.audio_enabled;
-  audio["backend"] = cfg.audio_backend;
-  audio["bclk_pin"] = cfg.i2s_bclk_pin;
-  audio["lrc_pin"] = cfg.i2s_lrc_pin;
-  audio["dout_pin"] = cfg.i2s_dout_pin;
-  audio["volume"] = cfg.audio_volume;
-  audio["dysv5w_tx_pin"] = cfg.dysv5w_tx_pin;
-  audio["dysv5w_busy_pin"] = cfg.dysv5w_busy_pin;
-
-  JsonObject lidar = doc.createNestedObject("lidar");
-  lidar["enabled"] = cfg.lidar_enabled;
-  lidar["rx_pin"] = cfg.lidar_rx_pin;
-  lidar["tx_pin"] = cfg.lidar_tx_pin;
-  lidar["threshold_mm"] = cfg.lidar_threshold_mm;
-
-  JsonObject peer = doc.createNestedObject("peer");
-  peer["mac"] = formatMac(cfg.peer_mac);
-
-  JsonObject track = doc.createNestedObject("track");
-  track["length_m"] = cfg.track_length_m;
-  track["scale_factor"] = cfg.scale_factor;
-  track["sensor_spacing_m"] = cfg.sensor_spacing_m;
-
-  JsonObject integrations = doc.createNestedObject("integrations");
-  integrations["google_sheets_url"] = cfg.google_sheets_url;
-  integrations["wled_host"] = cfg.wled_host;
-  JsonObject wled_fx = integrations.createNestedObject("wled_effects");
-  wled_fx["idle"] = cfg.wled_effect_idle;
-  wled_fx["armed"] = cfg.wled_effect_armed;
-  wled_fx["racing"] = cfg.wled_effect_racing;
-  wled_fx["finished"] = cfg.wled_effect_finished;
-
-  JsonObject regional = doc.createNestedObject("regional");
-  regional["units"] = cfg.units;
-  regional["timezone"] = cfg.timezone;
-
-  JsonObject ota = doc.createNestedObject("ota");
-  ota["password"] = cfg.ota_password;
-
-  JsonObject auth = doc.createNestedObject("auth");
-  auth["viewer_password"] = cfg.viewer_password;
+#define X(type, group, key, member, def, lo, hi) \
+  { JsonObject o = configGroup(root, group, true); CFG_PUT_##type(o, key, cfg.member); }
+  CONFIG_FIELDS(X)
+#undef X
 
   String output;
   serializeJsonPretty(doc, output);
@@ -322,98 +432,34 @@ String configToJson() {
 }
 
 bool configFromJson(const String& json) {
+  HEAP_TAG(JSON);
   StaticJsonDocument<2560> doc;
   DeserializationError err = deserializeJson(doc, json);
   if (err) {
     LOG.printf("[CONFIG] JSON parse error: %s\n", err.c_str());
     return false;
   }
-
-  cfg.configured = doc["configured"] | false;
-  cfg.version = doc["version"] | CONFIG_VERSION;
-
-  JsonObject network = doc["network"];
-  if (network) {
-    strncpy(cfg.wifi_ssid, network["wifi_ssid"] | "", sizeof(cfg.wifi_ssid) - 1);
-    strncpy(cfg.wifi_pass, network["wifi_pass"] | "", sizeof(cfg.wifi_pass) - 1);
-    strncpy(cfg.hostname, network["hostname"] | "masstrap", sizeof(cfg.hostname) - 1);
-    strncpy(cfg.network_mode, network["mode"] | "wifi", sizeof(cfg.network_mode) - 1);
-  }
-
-  JsonObject device = doc["device"];
-  if (device) {
-    strncpy(cfg.role, device["role"] | "finish", sizeof(cfg.role) - 1);
-    cfg.device_id = device["id"] | 1;
-  }
-
-  JsonObject pins = doc["pins"];
-  if (pins) {
-    cfg.sensor_pin = pins["sensor_pin"] | 4;
-    cfg.sensor_pin_2 = pins["sensor_pin_2"] | 5;
-    cfg.led_pin = pins["led_pin"] | 2;
-  }
-
-  JsonObject audio = doc["audio"];
-  if (audio) {
-    cfg.audio_enabled = audio["enabled"] | false;
-    strncpy(cfg.audio_backend, audio["backend"] | "i2s", sizeof(cfg.audio_backend) - 1);
-    cfg.i2s_bclk_pin = audio["bclk_pin"] | 15;
-    cfg.i2s_lrc_pin = audio["lrc_pin"] | 16;
-    cfg.i2s_dout_pin = audio["dout_pin"] | 17;
-    cfg.audio_volume = audio["volume"] | 10;
-    cfg.dysv5w_tx_pin = audio["dysv5w_tx_pin"] | 15;
-    cfg.dysv5w_busy_pin = audio["dysv5w_busy_pin"] | 16;
-  }
-
-  JsonObject lidar = doc["lidar"];
-  if (!lidar) lidar = doc["tof"]; // Backwards-compatible with old config files
-  if (lidar) {
-    cfg.lidar_enabled = lidar["enabled"] | false;
+  JsonObject root = doc.as<JsonObject>();
+
+  // Groups that are absent keep their current values; a key missing from a
+  // group that is present takes its default
+#define X(type, group, key, member, def, lo, hi) \
+  { JsonObject o = configGroup(root, group, false); if (!o.isNull()) CFG_GET_##type(o, key, cfg.member, def); }
+  CONFIG_FIELDS(X)
+#undef X
+
+  // Backwards-compatible with old config files: "tof" group, I2C pin names
+  JsonObject lidar = root["lidar"];
+  if (lidar.isNull()) lidar = root["tof"];
+  if (!lidar.isNull()) {
+    if (root["lidar"].isNull()) {
+      cfg.lidar_enabled = lidar["enabled"] | false;
+      cfg.lidar_threshold_mm = lidar["threshold_mm"] | 50;
+    }
+    // The field table never reads a "tof" group, so take its UART pins here
+    // too, before the I2C-era names
     cfg.lidar_rx_pin = lidar["rx_pin"] | lidar["sda_pin"] | 39;
     cfg.lidar_tx_pin = lidar["tx_pin"] | lidar["scl_pin"] | 38;
-    cfg.lidar_threshold_mm = lidar["threshold_mm"] | 50;
-  }
-
-  JsonObject peer = doc["peer"];
-  if (peer) {
-    const char* macStr = peer["mac"] | "00:00:00:00:00:00";
-    parseMacString(macStr, cfg.peer_mac);
-  }
-
-  JsonObject track = doc["track"];
-  if (track) {
-    cfg.track_length_m = track["length_m"] | 2.0f;
-    cfg.scale_factor = track["scale_factor"] | 64;
-    cfg.sensor_spacing_m = track["sensor_spacing_m"] | 0.10f;
-  }
-
-  JsonObject integrations = doc["integrations"];
-  if (integrations) {
-    strncpy(cfg.google_sheets_url, integrations["google_sheets_url"] | "", sizeof(cfg.google_sheets_url) - 1);
-    strncpy(cfg.wled_host, integrations["wled_host"] | "", sizeof(cfg.wled_host) - 1);
-    JsonObject wled_fx = integrations["wled_effects"];
-    if (wled_fx) {
-      cfg.wled_effect_idle = wled_fx["idle"] | 0;
-      cfg.wled_effect_armed = wled_fx["armed"] | 28;
-      cfg.wled_effect_racing = wled_fx["racing"] | 49;
-      cfg.wled_effect_finished = wled_fx["finished"] | 11;
-    }
-  }
-
-  JsonObject regional = doc["regional"];
-  if (regional) {
-    strncpy(cfg.units, regional["units"] | "imperial", sizeof(cfg.units) - 1);
-    strncpy(cfg.timezone, regional["timezone"] | "EST5EDT,M3.2.0,M11.1.0", sizeof(cfg.timezone) - 1);
-  }
-
-  JsonObject ota = doc["ota"];
-  if (ota) {
-    strncpy(cfg.ota_password, ota["password"] | "admin", sizeof(cfg.ota_password) - 1);
-  }
-
-  JsonObject auth = doc["auth"];
-  if (auth) {
-    strncpy(cfg.viewer_password, auth["viewer_password"] | "", sizeof(cfg.viewer_password) - 1);
   }
 
   if (cfg.configured) {
@@ -427,7 +473,11 @@ bool configFromJson(const String& json) {
 void resetConfig() {
   LOG.println("[CONFIG] Factory reset - deleting config and rebooting");
   LittleFS.remove(CONFIG_FILE);
-  LittleFS.remove("/runs.csv");
+  {
+    StorageLock lock;   // Not under a pending race append
+    runLogClear();
+  }
+  LittleFS.remove(RUN_LOG_LEGACY_CSV);
   // Clear NVS backup too — full factory reset
   Preferences prefs;
   if (prefs.begin(NVS_NAMESPACE, false)) {
@@ -458,13 +508,24 @@ bool parseMacString(const char* macStr, uint8_t* macOut) {
   return true;
 }
 
+void formatMac(const uint8_t* mac, char* out) {
+  snprintf(out, 18, "%02X:%02X:%02X:%02X:%02X:%02X",
+           mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+}
+
 String formatMac(const uint8_t* mac) {
   char buf[18];
-  snprintf(buf, sizeof(buf), "%02X:%02X:%02X:%02X:%02X:%02X",
-           mac[0], mac[1], mac[2], mac[3], mac[4], mac[5]);
+  formatMac(mac, buf);
   return String(buf);
 }
 
+uint64_t epochMs() {
+  struct timeval tv;
+  gettimeofday(&tv, nullptr);
+  if (tv.tv_sec < 1700000000) return 0;  // Clock not set by NTP yet
+  return (uint64_t)tv.tv_sec * 1000ULL + tv.tv_usec / 1000;
+}
+
 void getMacSuffix(char* buf, size_t len) {
   uint8_t mac[6];
   esp_efuse_mac_get_default(mac);
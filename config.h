@@ -49,6 +49,9 @@
 // Race timeout (milliseconds)
 #define RACE_TIMEOUT_MS         30000       // 30s — abort if no finish
 
+// LiDAR launch timing (start gate)
+#define START_LIDAR_WAIT_MS     50          // Longest START is held for a staged car's LiDAR departure
+
 // ESP-NOW peer health intervals (milliseconds)
 #define PING_INTERVAL_MS        1000        // Keepalive when peer is online (was 2000)
 #define PING_BACKOFF_MS         5000        // Keepalive when peer is offline (was 10000)
@@ -61,6 +64,17 @@
 #define PEER_STALE_THRESH_MS    30000       // <30s = STALE, >30s = OFFLINE (was 60000)
 #define PEER_SAVE_DEBOUNCE_MS   2000        // Delay before writing /peers.json
 
+// Live WebSocket streams (binary topic frames on port 81)
+#define STREAM_FLUSH_MS         100         // Max age of a batch before it is sent (10 frames/s)
+#define STREAM_SENSOR_SAMPLE_MS 10          // Beam/prox sensor sampling period (100 Hz)
+#define STREAM_BATCH_SAMPLES    32          // Samples per topic batch before an early flush
+#define STREAM_LOG_MAX_BYTES    1024        // Serial log text per "log" stream frame
+
+// Race history log (/history.jsonl)
+#define RACE_LOG_INDEX_INITIAL  256         // Initial seq→offset index capacity (doubles as needed)
+#define HISTORY_PAGE_DEFAULT    100         // /api/history?since= default page size
+#define HISTORY_PAGE_MAX        500         // Upper bound on ?limit=
+
 // Hostname generation
 #define HOSTNAME_PREFIX         "mass"      // mass-finish, mass-start, mass-trap
 
@@ -70,6 +84,7 @@
 
 // WiFi resilience — non-blocking background reconnect
 #define WIFI_RETRY_INTERVAL_MS  60000       // Try reconnect every 60s when disconnected
+#define WIFI_CONNECT_TIMEOUT_MS 20000       // Boot association attempt before fallback
 
 // Global log output — all Serial.printf calls should use LOG.printf instead
 // This captures output for the web serial monitor (/console)
@@ -117,6 +132,7 @@ struct DeviceConfig {
   uint8_t lidar_rx_pin;
   uint8_t lidar_tx_pin;
   uint16_t lidar_threshold_mm;
+  uint16_t lidar_min_amp; // Frames below this TF-Luna amplitude are gated out
 
   // Speed Trap
   float sensor_spacing_m; // Distance between speed trap sensors
@@ -147,18 +163,79 @@ struct DeviceConfig {
   char viewer_password[32];  // Blank = open access (no viewer gate)
 };
 
+// ============================================================================
+// CONFIG FIELD TABLE — the one list of persisted DeviceConfig fields
+//
+// setDefaults(), configToJson(), configFromJson(), the range checks in
+// validateConfig() and the NVS binary image are all generated from this
+// table, so a field added here is saved, loaded, exported and checked
+// everywhere at once. Rows are in JSON output order.
+//
+//   X(type, group, key, member, default, min, max)
+//
+// type:  STR (char[]), BOOL, U8, U16, INT, FLOAT, MAC (uint8_t[6])
+// group: JSON object path, "" = top level, "a/b" = nested
+// min/max: inclusive range for numeric types, ignored for STR/BOOL/MAC
+// ============================================================================
+#define CONFIG_FIELDS(X) \
+  X(BOOL,  "",                          "configured",        configured,           false,                    0, 0) \
+  X(INT,   "",                          "version",           version,              CONFIG_VERSION,           0, 1000) \
+  X(STR,   "network",                   "wifi_ssid",         wifi_ssid,            "",                       0, 0) \
+  X(STR,   "network",                   "wifi_pass",         wifi_pass,            "",                       0, 0) \
+  X(STR,   "network",                   "hostname",          hostname,             "masstrap",               0, 0) \
+  X(STR,   "network",                   "mode",              network_mode,         "wifi",                   0, 0) \
+  X(STR,   "device",                    "role",              role,                 "finish",                 0, 0) \
+  X(U8,    "device",                    "id",                device_id,            configDefaultDeviceId(),  1, 255) \
+  X(U8,    "pins",                      "sensor_pin",        sensor_pin,           4,                        0, 48) \
+  X(U8,    "pins",                      "sensor_pin_2",      sensor_pin_2,         5,                        0, 48) \
+  X(U8,    "pins",                      "led_pin",           led_pin,              2,                        0, 48) \
+  X(BOOL,  "audio",                     "enabled",           audio_enabled,        false,                    0, 0) \
+  X(STR,   "audio",                     "backend",           audio_backend,        "i2s",                    0, 0) \
+  X(U8,    "audio",                     "bclk_pin",          i2s_bclk_pin,         15,                       0, 48) \
+  X(U8,    "audio",                     "lrc_pin",           i2s_lrc_pin,          16,                       0, 48) \
+  X(U8,    "audio",                     "dout_pin",          i2s_dout_pin,         17,                       0, 48) \
+  X(U8,    "audio",                     "volume",            audio_volume,         10,                       0, 30) \
+  X(U8,    "audio",                     "dysv5w_tx_pin",     dysv5w_tx_pin,        15,                       0, 48) \
+  X(U8,    "audio",                     "dysv5w_busy_pin",   dysv5w_busy_pin,      16,                       0, 48) \
+  X(BOOL,  "lidar",                     "enabled",           lidar_enabled,        false,                    0, 0) \
+  X(U8,    "lidar",                     "rx_pin",            lidar_rx_pin,         39,                       0, 48) \
+  X(U8,    "lidar",                     "tx_pin",            lidar_tx_pin,         38,                       0, 48) \
+  X(U16,   "lidar",                     "threshold_mm",      lidar_threshold_mm,   50,                       0, 8000) \
+  X(U16,   "lidar",                     "min_amp",           lidar_min_amp,        100,                      0, 65535) \
+  X(MAC,   "peer",                      "mac",               peer_mac,             "00:00:00:00:00:00",      0, 0) \
+  X(FLOAT, "track",                     "length_m",          track_length_m,       2.0f,                     0.01f, 100) \
+  X(INT,   "track",                     "scale_factor",      scale_factor,         64,                       1, 1000) \
+  X(FLOAT, "track",                     "sensor_spacing_m",  sensor_spacing_m,     0.10f,                    0.001f, 10) \
+  X(STR,   "integrations",              "google_sheets_url", google_sheets_url,    "",                       0, 0) \
+  X(STR,   "integrations",              "wled_host",         wled_host,            "",                       0, 0) \
+  X(U8,    "integrations/wled_effects", "idle",              wled_effect_idle,     0,                        0, 255) \
+  X(U8,    "integrations/wled_effects", "armed",             wled_effect_armed,    28,                       0, 255) \
+  X(U8,    "integrations/wled_effects", "racing",            wled_effect_racing,   49,                       0, 255) \
+  X(U8,    "integrations/wled_effects", "finished",          wled_effect_finished, 11,                       0, 255) \
+  X(STR,   "regional",                  "units",             units,                "imperial",               0, 0) \
+  X(STR,   "regional",                  "timezone",          timezone,             "EST5EDT,M3.2.0,M11.1.0", 0, 0) \
+  X(STR,   "ota",                       "password",          ota_password,         "admin",                  0, 0) \
+  X(STR,   "auth",                      "viewer_password",   viewer_password,      "",                       0, 0)
+
 // Global config instance
 extern DeviceConfig cfg;
 
-// Load config from LittleFS. Returns true if valid config found.
-// Falls back to NVS backup if LittleFS config is missing/corrupt.
+// Load config at boot. Tries, in order: the binary image in NVS (no JSON
+// parse), /config.json on LittleFS, then the NVS backup of the boot fields.
+// A successful JSON load rewrites the binary image for next time.
+// Returns true if a valid config was found.
 bool loadConfig();
 
-// Save current config to LittleFS. Returns true on success.
-// Also saves critical boot fields (ssid, pass, role, hostname) to NVS
-// as a backup that survives LittleFS wipes (e.g. uploadfs).
+// Save current config: /config.json on LittleFS (export/import copy), the
+// binary image in NVS, and the critical boot fields (ssid, pass, role,
+// hostname) as separate NVS keys that survive LittleFS wipes (e.g.
+// uploadfs). Returns true if the JSON or the binary image was written.
 bool saveConfig();
 
+// Drop the binary image so the next boot loads /config.json. Call after
+// writing config.json directly (restore, file upload) instead of saveConfig().
+void configInvalidateImage();
+
 // Validate config values. Returns true if valid.
 bool validateConfig(const DeviceConfig& c);
 
@@ -168,6 +245,9 @@ bool isValidGPIO(uint8_t pin);
 // Set default values on the config struct
 void setDefaults(DeviceConfig& c);
 
+// Default device ID, derived from the MAC so fresh nodes don't collide
+uint8_t configDefaultDeviceId();
+
 // Serialize config to JSON string (for API and backup)
 String configToJson();
 
@@ -182,6 +262,10 @@ bool parseMacString(const char* macStr, uint8_t* macOut);
 
 // Format uint8_t[6] MAC to "XX:XX:XX:XX:XX:XX" string
 String formatMac(const uint8_t* mac);
+void formatMac(const uint8_t* mac, char* out);   // out: 18 bytes, no heap
+
+// Unix epoch ms, or 0 while the clock has not been set by NTP
+uint64_t epochMs();
 
 // Get 4-char hex suffix from hardware MAC (e.g., "A7B2")
 void getMacSuffix(char* buf, size_t len);
@@ -171,6 +171,7 @@ var wsReconnectTimer = null;
 var wsConnected = false;
 var wsMessageHandlers = [];
 var wsReconnectAttempts = 0;
+var wsStreamHandlers = {};   // topic name -> [handler(samples, seq)]
 
 function connectWebSocket() {
   // Protocol-aware: use wss:// when loaded over HTTPS (e.g. Tailscale Funnel)
@@ -193,12 +194,20 @@ function connectWebSocket() {
     return;
   }
 
+  ws.binaryType = 'arraybuffer';
+
   ws.onopen = function() {
     wsConnected = true;
     wsReconnectAttempts = 0;
     updateConnectionBadge(true);
     clearTimeout(wsReconnectTimer);
     console.log('[WS] Connected to ' + wsUrl);
+    // Subscriptions are per-connection — restore them after a reconnect
+    for (var topic in wsStreamHandlers) {
+      if (wsStreamHandlers.hasOwnProperty(topic) && wsStreamHandlers[topic].length > 0) {
+        ws.send(JSON.stringify({ cmd: 'subscribe', topic: topic }));
+      }
+    }
   };
 
   ws.onclose = function(evt) {
@@ -214,8 +223,17 @@ function connectWebSocket() {
   };
 
   ws.onmessage = function(event) {
+    if (typeof event.data !== 'string') {
+      handleStreamFrame(event.data);
+      return;
+    }
     try {
       var data = JSON.parse(event.data);
+      if (data.stream !== undefined) {
+        // Subscribe/unsubscribe acknowledgement — not a state broadcast
+        if (data.error) console.warn('[WS] Stream ' + data.stream + ': ' + data.error);
+        return;
+      }
       for (var i = 0; i < wsMessageHandlers.length; i++) {
         wsMessageHandlers[i](data);
       }
@@ -229,6 +247,69 @@ function onWsMessage(handler) {
   wsMessageHandlers.push(handler);
 }
 
+// ====================================================================
+// LIVE STREAMS — binary topic frames (see live_stream.h for the layout)
+// ====================================================================
+var WS_STREAM_TOPICS = ['lidar', 'sensors', 'sync', 'log'];
+
+function decodeStreamSamples(topic, view, count) {
+  // Log frames carry `count` records as UTF-8 text; seq is the first record's seq
+  if (topic === 'log') {
+    return { records: count, text: new TextDecoder().decode(new Uint8Array(view.buffer, 8, view.byteLength - 8)) };
+  }
+  var samples = [];
+  var off = 8;
+  for (var i = 0; i < count; i++) {
+    if (topic === 'lidar') {
+      samples.push({ t_ms: view.getUint32(off, true), distance_mm: view.getUint16(off + 4, true),
+                     amplitude: view.getUint16(off + 6, true), state: view.getUint8(off + 8) });
+      off += 9;
+    } else if (topic === 'sensors') {
+      var levels = view.getUint8(off + 4);
+      samples.push({ t_ms: view.getUint32(off, true), beam1: (levels & 1) !== 0,
+                     beam2: (levels & 2) !== 0, raceState: view.getUint8(off + 5) });
+      off += 6;
+    } else if (topic === 'sync') {
+      // int64 offset: low word unsigned + high word signed (offsets stay well inside 2^53)
+      var offset = view.getInt32(off + 8, true) * 4294967296 + view.getUint32(off + 4, true);
+      samples.push({ t_ms: view.getUint32(off, true), offset_us: offset,
+                     drift_us: view.getInt32(off + 12, true) });
+      off += 16;
+    }
+  }
+  return samples;
+}
+
+function handleStreamFrame(buf) {
+  if (!buf || buf.byteLength < 8) return;
+  var view = new DataView(buf);
+  if (view.getUint8(0) !== 0xB5) return;
+  var topic = WS_STREAM_TOPICS[view.getUint8(1)];
+  var handlers = topic ? wsStreamHandlers[topic] : null;
+  if (!handlers || handlers.length === 0) return;
+  var samples = decodeStreamSamples(topic, view, view.getUint16(2, true));
+  var seq = view.getUint32(4, true);
+  for (var i = 0; i < handlers.length; i++) {
+    handlers[i](samples, seq);
+  }
+}
+
+// Subscribe to a live stream topic. handler(samples, seq) receives each decoded batch.
+function wsSubscribe(topic, handler) {
+  if (!wsStreamHandlers[topic]) wsStreamHandlers[topic] = [];
+  wsStreamHandlers[topic].push(handler);
+  if (ws && ws.readyState === WebSocket.OPEN) {
+    ws.send(JSON.stringify({ cmd: 'subscribe', topic: topic }));
+  }
+}
+
+function wsUnsubscribe(topic) {
+  delete wsStreamHandlers[topic];
+  if (ws && ws.readyState === WebSocket.OPEN) {
+    ws.send(JSON.stringify({ cmd: 'unsubscribe', topic: topic }));
+  }
+}
+
 function wsSend(data) {
   if (ws && ws.readyState === WebSocket.OPEN) {
     ws.send(JSON.stringify(data));
@@ -29,6 +29,62 @@ static HardwareSerial dysv5wSerial(1);
 static uint8_t busyGPIO = 0;
 static bool dysv5wReady = false;
 
+// ============================================================================
+// COMMAND QUEUE — filled by the public API from any task (loop(), web
+// handlers, ESP-NOW callbacks), drained by dysv5wLoop(). Nothing here waits
+// on the UART: a frame is written only when the TX FIFO has room for all of
+// it, at least DYSV5W_CMD_GAP_MS after the previous one.
+// ============================================================================
+#define DYCMD_PREEMPT   0x01    // PLAY: send even while a clip is playing
+
+struct DyCmd {
+  uint8_t cmd;              // DYSV5W_CMD_*
+  uint8_t flags;
+  uint16_t arg;             // Track number / volume / device
+};
+
+static DyCmd queue[DYSV5W_QUEUE_DEPTH];
+static uint8_t qHead = 0;
+static uint8_t qCount = 0;
+static portMUX_TYPE queueMux = portMUX_INITIALIZER_UNLOCKED;
+
+static DyCmd& qAt(uint8_t i) {
+  return queue[(qHead + i) % DYSV5W_QUEUE_DEPTH];
+}
+
+// ============================================================================
+// STATE MACHINE — driven by the BUSY pin (I/O1, LOW while playing)
+//
+//   POWER_ON  module boots and auto-plays every track; the first BUSY fall
+//             (or DYSV5W_POWER_ON_MS) means it is listening. The stop/stop/
+//             select-TF sequence is queued ahead of everything else.
+//   READY     next command goes out
+//   STARTING  PLAY sent, waiting for BUSY to fall
+//   PLAYING   waiting for BUSY to rise; queued PLAYs wait here (sequenced)
+// ============================================================================
+enum DyState : uint8_t { DY_POWER_ON, DY_READY, DY_STARTING, DY_PLAYING };
+static DyState state = DY_POWER_ON;
+static uint32_t stateMs = 0;        // millis() when the state was entered
+static uint32_t lastTxMs = 0;
+static uint32_t playSentUs = 0;
+static int16_t sentVolume = -1;     // Last volume sent, -1 = module default
+
+// BUSY edges, from the ISR
+static volatile bool busyLow = false;
+static volatile uint32_t busyFallUs = 0;
+
+struct DyStats {
+  uint32_t sent;
+  uint32_t coalesced;       // Volume commands merged or skipped
+  uint32_t dropped;         // Queue full
+  uint32_t clips;           // Clips that played to BUSY rising
+  uint32_t startTimeouts;   // PLAY sent, BUSY never fell
+  uint32_t startLatency_ms;     // PLAY sent → BUSY fall, last clip
+  uint32_t startLatencyMax_ms;
+  uint8_t queueMax;
+};
+static DyStats stats;
+
 // ============================================================================
 // TRACK MAP — clip filename to DY-SV5W track number
 // Must match the numbered files on the TF card (00001.mp3 through 00020.mp3)
@@ -67,10 +123,10 @@ static const TrackEntry TRACK_MAP[] = {
 static const int TRACK_MAP_SIZE = sizeof(TRACK_MAP) / sizeof(TRACK_MAP[0]);
 
 // ============================================================================
-// SEND COMMAND
+// SEND COMMAND — false if the UART can't take the whole frame right now
 // ============================================================================
-static void sendCommand(uint8_t cmd, const uint8_t* data, uint8_t dataLen) {
-  if (!dysv5wReady) return;
+static bool sendCommand(uint8_t cmd, const uint8_t* data, uint8_t dataLen) {
+  if (!dysv5wReady) return false;
 
   // Frame: [AA] [CMD] [LEN] [DATA...] [SM]
   uint8_t frame[16];
@@ -86,6 +142,8 @@ static void sendCommand(uint8_t cmd, const uint8_t* data, uint8_t dataLen) {
   for (uint8_t i = 0; i < idx; i++) sum += frame[i];
   frame[idx++] = (uint8_t)(sum & 0xFF);
 
+  if (dysv5wSerial.availableForWrite() < idx) return false;
+
   // Debug: log exact hex bytes
   char hex[48];
   int pos = 0;
@@ -94,8 +152,74 @@ static void sendCommand(uint8_t cmd, const uint8_t* data, uint8_t dataLen) {
   }
   LOG.printf("[DY-SV5W] TX: %s\n", hex);
 
-  dysv5wSerial.write(frame, idx);
-  dysv5wSerial.flush();
+  dysv5wSerial.write(frame, idx);   // Into the TX FIFO; no flush()
+  stats.sent++;
+  return true;
+}
+
+static bool sendQueued(const DyCmd& c) {
+  switch (c.cmd) {
+    case DYSV5W_CMD_PLAY: {
+      uint8_t data[2] = {
+        (uint8_t)(c.arg >> 8),     // high byte
+        (uint8_t)(c.arg & 0xFF)    // low byte
+      };
+      if (!sendCommand(DYSV5W_CMD_PLAY, data, 2)) return false;
+      LOG.printf("[DY-SV5W] Play track %d\n", c.arg);
+      return true;
+    }
+    case DYSV5W_CMD_VOLUME: {
+      uint8_t level = (uint8_t)c.arg;
+      if (!sendCommand(DYSV5W_CMD_VOLUME, &level, 1)) return false;
+      sentVolume = level;
+      LOG.printf("[DY-SV5W] Volume set to %d/30\n", level);
+      return true;
+    }
+    case DYSV5W_CMD_SET_DEVICE: {
+      uint8_t dev = (uint8_t)c.arg;
+      return sendCommand(DYSV5W_CMD_SET_DEVICE, &dev, 1);
+    }
+    default:
+      return sendCommand(c.cmd, NULL, 0);
+  }
+}
+
+// Queue a command (caller holds queueMux). front: ahead of everything queued.
+static bool enqueueLocked(uint8_t cmd, uint16_t arg, uint8_t flags, bool front) {
+  if (qCount >= DYSV5W_QUEUE_DEPTH) {
+    stats.dropped++;
+    return false;
+  }
+  if (front) {
+    qHead = (qHead + DYSV5W_QUEUE_DEPTH - 1) % DYSV5W_QUEUE_DEPTH;
+    queue[qHead] = { cmd, flags, arg };
+  } else {
+    qAt(qCount) = { cmd, flags, arg };
+  }
+  qCount++;
+  if (qCount > stats.queueMax) stats.queueMax = qCount;
+  return true;
+}
+
+// Drop every queued PLAY (caller holds queueMux)
+static void dropPlaysLocked() {
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < qCount; i++) {
+    DyCmd c = qAt(i);
+    if (c.cmd != DYSV5W_CMD_PLAY) qAt(kept++) = c;
+  }
+  qCount = kept;
+}
+
+static void IRAM_ATTR busyISR() {
+  bool low = digitalRead(busyGPIO) == LOW;
+  if (low && !busyLow) busyFallUs = micros();
+  busyLow = low;
+}
+
+static void setState(DyState s) {
+  state = s;
+  stateMs = millis();
 }
 
 // ============================================================================
@@ -110,48 +234,160 @@ void dysv5wSetup(uint8_t txPin, uint8_t busyPin) {
 
   // BUSY pin: INPUT_PULLUP since I/O1 is open-drain on DY-SV5W
   pinMode(busyPin, INPUT_PULLUP);
+  busyLow = digitalRead(busyPin) == LOW;
+  attachInterrupt(digitalPinToInterrupt(busyPin), busyISR, CHANGE);
 
-  dysv5wReady = true;
-
-  // Module auto-plays all tracks on power-on — kill it
-  delay(500);
-  dysv5wStop();
-  delay(100);
-  dysv5wStop();
-  delay(100);
+  // Power-on: the module auto-plays all tracks — stop it twice, then select
+  // the TF card. Anything the caller queues goes after.
+  portENTER_CRITICAL(&queueMux);
+  enqueueLocked(DYSV5W_CMD_SET_DEVICE, DYSV5W_DEVICE_SD, 0, true);
+  enqueueLocked(DYSV5W_CMD_STOP, 0, 0, true);
+  enqueueLocked(DYSV5W_CMD_STOP, 0, 0, true);
+  portEXIT_CRITICAL(&queueMux);
 
-  // Select SD/TF card as playback device
-  uint8_t dev = DYSV5W_DEVICE_SD;
-  sendCommand(DYSV5W_CMD_SET_DEVICE, &dev, 1);
-  delay(100);
+  dysv5wReady = true;
+  setState(DY_POWER_ON);
 
   LOG.printf("[DY-SV5W] UART initialized: TX=GPIO%d, BUSY=GPIO%d, 9600 baud\n",
              txPin, busyPin);
 }
 
-void dysv5wPlayTrack(uint16_t trackNumber) {
+void dysv5wLoop() {
+  if (!dysv5wReady) return;
+  uint32_t now = millis();
+  bool busy = busyLow;
+
+  switch (state) {
+    case DY_POWER_ON:
+      if (!busy && now - stateMs < DYSV5W_POWER_ON_MS) return;
+      LOG.printf("[DY-SV5W] Module up after %lu ms (%s)\n", now - stateMs,
+                 busy ? "BUSY" : "timeout");
+      setState(DY_READY);
+      break;
+
+    case DY_STARTING:
+      if (busy) {
+        // A preempting PLAY over a clip already playing sees no new fall
+        int32_t sinceSend = (int32_t)(busyFallUs - playSentUs);
+        if (sinceSend >= 0) {
+          stats.startLatency_ms = sinceSend / 1000;
+          if (stats.startLatency_ms > stats.startLatencyMax_ms) {
+            stats.startLatencyMax_ms = stats.startLatency_ms;
+          }
+        }
+        setState(DY_PLAYING);
+      } else if (now - stateMs > DYSV5W_START_TIMEOUT_MS) {
+        stats.startTimeouts++;
+        LOG.println("[DY-SV5W] BUSY never fell after PLAY (missing track?)");
+        setState(DY_READY);
+      }
+      break;
+
+    case DY_PLAYING:
+      if (!busy) {
+        stats.clips++;
+        setState(DY_READY);
+      }
+      break;
+
+    default:
+      break;
+  }
+
+  if (now - lastTxMs < DYSV5W_CMD_GAP_MS) return;
+
+  DyCmd c;
+  portENTER_CRITICAL(&queueMux);
+  bool have = qCount > 0;
+  if (have) c = qAt(0);
+  portEXIT_CRITICAL(&queueMux);
+  if (!have) return;
+
+  // Sequenced clips wait for the one playing to end
+  bool playing = state == DY_STARTING || state == DY_PLAYING;
+  if (c.cmd == DYSV5W_CMD_PLAY && playing && !(c.flags & DYCMD_PREEMPT)) return;
+
+  if (!sendQueued(c)) return;   // UART full — retry next loop
+  lastTxMs = now;
+
+  portENTER_CRITICAL(&queueMux);
+  qHead = (qHead + 1) % DYSV5W_QUEUE_DEPTH;
+  qCount--;
+  portEXIT_CRITICAL(&queueMux);
+
+  if (c.cmd == DYSV5W_CMD_PLAY) {
+    playSentUs = micros();
+    setState(DY_STARTING);
+  } else if (c.cmd == DYSV5W_CMD_STOP) {
+    setState(DY_READY);
+  }
+}
+
+void dysv5wPlayTrack(uint16_t trackNumber, bool preempt) {
   if (trackNumber == 0) return;
-  uint8_t data[2] = {
-    (uint8_t)(trackNumber >> 8),   // high byte
-    (uint8_t)(trackNumber & 0xFF)  // low byte
-  };
-  sendCommand(DYSV5W_CMD_PLAY, data, 2);
-  LOG.printf("[DY-SV5W] Play track %d\n", trackNumber);
+  bool ok;
+  portENTER_CRITICAL(&queueMux);
+  if (preempt) {
+    dropPlaysLocked();
+    ok = enqueueLocked(DYSV5W_CMD_PLAY, trackNumber, DYCMD_PREEMPT, false);
+  } else {
+    ok = enqueueLocked(DYSV5W_CMD_PLAY, trackNumber, 0, false);
+  }
+  portEXIT_CRITICAL(&queueMux);
+  if (!ok) LOG.printf("[DY-SV5W] Queue full, dropped track %d\n", trackNumber);
 }
 
 void dysv5wStop() {
-  sendCommand(DYSV5W_CMD_STOP, NULL, 0);
+  portENTER_CRITICAL(&queueMux);
+  dropPlaysLocked();
+  enqueueLocked(DYSV5W_CMD_STOP, 0, 0, false);
+  portEXIT_CRITICAL(&queueMux);
 }
 
 void dysv5wSetVolume(uint8_t level) {
   if (level > 30) level = 30;
-  sendCommand(DYSV5W_CMD_VOLUME, &level, 1);
-  LOG.printf("[DY-SV5W] Volume set to %d/30\n", level);
+  portENTER_CRITICAL(&queueMux);
+  bool merged = false;
+  for (uint8_t i = 0; i < qCount; i++) {
+    if (qAt(i).cmd == DYSV5W_CMD_VOLUME) {
+      qAt(i).arg = level;   // Latest wins, keeps its place in the queue
+      merged = true;
+      break;
+    }
+  }
+  if (merged || level == sentVolume) {
+    stats.coalesced++;
+  } else {
+    enqueueLocked(DYSV5W_CMD_VOLUME, level, 0, false);
+  }
+  portEXIT_CRITICAL(&queueMux);
 }
 
 bool dysv5wIsBusy() {
   if (!dysv5wReady) return false;
-  return digitalRead(busyGPIO) == LOW;
+  if (busyLow || state == DY_STARTING) return true;
+  bool queued = false;
+  portENTER_CRITICAL(&queueMux);
+  for (uint8_t i = 0; i < qCount && !queued; i++) {
+    queued = qAt(i).cmd == DYSV5W_CMD_PLAY;
+  }
+  portEXIT_CRITICAL(&queueMux);
+  return queued;
+}
+
+void dysv5wWriteStats(JsonWriter& w) {
+  portENTER_CRITICAL(&queueMux);
+  uint8_t queued = qCount;
+  portEXIT_CRITICAL(&queueMux);
+  w.field("queued", queued)
+   .field("queue_max", stats.queueMax)
+   .field("commands_sent", stats.sent)
+   .field("volume_coalesced", stats.coalesced)
+   .field("commands_dropped", stats.dropped)
+   .field("clips", stats.clips)
+   .field("start_timeouts", stats.startTimeouts)
+   .field("start_latency_ms", stats.startLatency_ms)
+   .field("start_latency_max_ms", stats.startLatencyMax_ms);
 }
 
 uint16_t dysv5wLookupTrack(const char* clipName) {
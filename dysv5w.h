@@ -2,6 +2,7 @@
 #define DYSV5W_H
 
 #include <Arduino.h>
+#include "json_writer.h"
 
 // ============================================================================
 // DY-SV5W UART Sound Module Driver
@@ -13,23 +14,45 @@
 //
 // Plays MP3/WAV files from TF card by track number (00001.mp3 = track 1).
 // BUSY pin (I/O1): LOW while playing, HIGH when idle.
+//
+// Every call only queues a command; dysv5wLoop() sends them one frame at a
+// time, never waiting on the UART, and follows the BUSY pin (on an
+// interrupt) to know when a clip has started and ended. Clips queued while
+// one plays follow it in order; a preempting play cuts in.
 // ============================================================================
 
-// Initialize UART and BUSY pin. Call once from audioSetup().
+#define DYSV5W_QUEUE_DEPTH      8
+#define DYSV5W_CMD_GAP_MS       30      // Between frames — the module drops back-to-back commands
+#define DYSV5W_POWER_ON_MS      500     // Longest wait for the power-on auto-play to start
+#define DYSV5W_START_TIMEOUT_MS 300     // PLAY sent, BUSY still HIGH → give up on that clip
+
+// Initialize UART and BUSY pin. Call once from audioSetup(). Returns at
+// once; the power-on stop/stop/select-TF sequence is queued ahead of any
+// other command and goes out as soon as the module is up (its power-on
+// auto-play pulls BUSY LOW), or after DYSV5W_POWER_ON_MS.
 void dysv5wSetup(uint8_t txPin, uint8_t busyPin);
 
+// Send queued commands and track BUSY. Call every loop() via audioLoop().
+void dysv5wLoop();
+
 // Play a track by number (1-65535, maps to 00001.mp3-65535.mp3 on TF card).
-void dysv5wPlayTrack(uint16_t trackNumber);
+// Queued behind the clip playing, unless preempt: then queued plays are
+// dropped and this one is sent as soon as the line is free.
+void dysv5wPlayTrack(uint16_t trackNumber, bool preempt = false);
 
-// Stop playback immediately.
+// Stop playback and drop queued plays.
 void dysv5wStop();
 
-// Set volume (0-30). Default after power-on is 20.
+// Set volume (0-30). Default after power-on is 20. Merged with a volume
+// still queued, skipped if already set.
 void dysv5wSetVolume(uint8_t level);
 
-// Returns true if module is currently playing (BUSY pin LOW).
+// Returns true if a clip is playing (BUSY LOW), starting, or queued.
 bool dysv5wIsBusy();
 
+// Write queue and playback counters into an open JSON object (fields only)
+void dysv5wWriteStats(JsonWriter& w);
+
 // Map a clip filename (e.g. "speed_trap", "armed") to its track number.
 // Returns 0 if the clip name is not found in the track map.
 uint16_t dysv5wLookupTrack(const char* clipName);
@@ -33,6 +33,12 @@
 
 #include "espnow_comm.h"
 #include "config.h"
+#include "serial_log.h"
+#include "metrics.h"
+#include "storage.h"
+#include "heap_track.h"
+#include "json_writer.h"
+#include "audio_manager.h"
 #include <ArduinoJson.h>
 #include <LittleFS.h>
 #include <WiFi.h>
@@ -43,6 +49,7 @@
 volatile RaceState raceState = IDLE;
 bool dryRunMode = false;
 int64_t clockOffset_us = 0;
+bool clockSynced = false;
 bool peerConnected = false;
 unsigned long lastPeerSeen = 0;
 
@@ -67,6 +74,20 @@ volatile bool wifiReconnectRequested = false;
 static unsigned long lastBeaconTime = 0;
 static unsigned long lastPeerCheck = 0;
 static bool needsSave = false;             // Deferred save flag
+
+// Paired peers as of the last save request. Taken on the requesting task so
+// the storage task never walks peers[] while loop() or the ESP-NOW callback
+// is changing it.
+struct SavedPeer {
+  uint8_t mac[6];
+  uint8_t deviceId;
+  char role[16];
+  char hostname[32];
+};
+static SavedPeer saveSnapshot[MAX_PEERS];
+static uint8_t saveSnapshotCount = 0;
+static portMUX_TYPE saveSnapshotMux = portMUX_INITIALIZER_UNLOCKED;
+static void queuePeersSave();
 static unsigned long saveRequestedAt = 0;  // Debounce to reduce flash wear
 
 // ============================================================================
@@ -95,6 +116,22 @@ uint64_t IRAM_ATTR nowUs() {
   return esp_timer_get_time();
 }
 
+// ============================================================================
+// FLEET CLOCK — clockOffset_us = start_gate_clock - local_clock (0 on the
+// start gate itself and on roles that don't sync)
+// ============================================================================
+uint64_t fleetNowUs() {
+  return nowUs() + clockOffset_us;
+}
+
+uint64_t fleetToLocalUs(uint64_t fleetUs) {
+  return fleetUs - clockOffset_us;
+}
+
+bool fleetClockSynced() {
+  return strcmp(cfg.role, "start") == 0 || clockSynced;
+}
+
 // ============================================================================
 // HELPER: Build an ESPMessage with our identity
 // ============================================================================
@@ -229,7 +266,7 @@ static int upsertPeer(const uint8_t* mac, const char* role, const char* hostname
   peers[idx].paired = false;
   peerCount++;
 
-  LOG.printf("[PEERS] New device: %s (%s) @ %s\n", hostname, role, macToStr(mac).c_str());
+  LOG_DEFER(PEERS, INFO, "New device: %s (%s) @ %s", hostname, role, macToStr(mac).c_str());
   return idx;
 }
 
@@ -244,7 +281,7 @@ void forgetPeer(const uint8_t* mac) {
     peers[i] = peers[i + 1];
   }
   peerCount--;
-  savePeers();
+  queuePeersSave();
 }
 
 void forgetAllPeers() {
@@ -253,6 +290,10 @@ void forgetAllPeers() {
     esp_now_del_peer(peers[i].mac);
   }
   peerCount = 0;
+  // A save still queued must not bring the old list back
+  portENTER_CRITICAL(&saveSnapshotMux);
+  saveSnapshotCount = 0;
+  portEXIT_CRITICAL(&saveSnapshotMux);
   LittleFS.remove("/peers.json");
 }
 
@@ -262,6 +303,7 @@ void forgetAllPeers() {
 // ============================================================================
 
 void loadPeers() {
+  HEAP_TAG(JSON);
   if (!LittleFS.exists("/peers.json")) {
     LOG.println("[PEERS] No saved peers — fresh start");
     return;
@@ -307,18 +349,42 @@ void loadPeers() {
   LOG.printf("[PEERS] Loaded %d saved peer(s)\n", peerCount);
 }
 
+// Copy the paired peers (caller's task), then queue the write
+static void queuePeersSave() {
+  SavedPeer snap[MAX_PEERS];
+  uint8_t n = 0;
+  for (int i = 0; i < peerCount && n < MAX_PEERS; i++) {
+    if (!peers[i].paired) continue;  // Only save paired peers
+    SavedPeer& p = snap[n++];
+    memcpy(p.mac, peers[i].mac, 6);
+    p.deviceId = peers[i].deviceId;
+    strlcpy(p.role, peers[i].role, sizeof(p.role));
+    strlcpy(p.hostname, peers[i].hostname, sizeof(p.hostname));
+  }
+  portENTER_CRITICAL(&saveSnapshotMux);
+  memcpy(saveSnapshot, snap, n * sizeof(SavedPeer));
+  saveSnapshotCount = n;
+  portEXIT_CRITICAL(&saveSnapshotMux);
+  storageRequestPeersSave();
+}
+
+// Runs on the storage task: writes the latest snapshot, not peers[]
 void savePeers() {
+  HEAP_TAG(JSON);
+  SavedPeer snap[MAX_PEERS];
+  portENTER_CRITICAL(&saveSnapshotMux);
+  uint8_t n = saveSnapshotCount;
+  memcpy(snap, saveSnapshot, n * sizeof(SavedPeer));
+  portEXIT_CRITICAL(&saveSnapshotMux);
+
   StaticJsonDocument<1024> doc;
   JsonArray arr = doc.to<JsonArray>();
-
-  for (int i = 0; i < peerCount; i++) {
-    if (!peers[i].paired) continue;  // Only save paired peers
-
+  for (uint8_t i = 0; i < n; i++) {
     JsonObject obj = arr.createNestedObject();
-    obj["mac"] = macToStr(peers[i].mac);
-    obj["role"] = peers[i].role;
-    obj["hostname"] = peers[i].hostname;
-    obj["id"] = peers[i].deviceId;
+    obj["mac"] = macToStr(snap[i].mac);
+    obj["role"] = snap[i].role;
+    obj["hostname"] = snap[i].hostname;
+    obj["id"] = snap[i].deviceId;
     obj["paired"] = true;
   }
 
@@ -327,7 +393,7 @@ void savePeers() {
     LOG.println("[PEERS] Failed to write peers.json!");
     return;
   }
-  serializeJson(doc, f);
+  metricInc(MET_FS_BYTES_WRITTEN, serializeJson(doc, f));
   f.close();
   LOG.printf("[PEERS] Saved %d paired peer(s) to flash\n", arr.size());
 }
@@ -341,30 +407,28 @@ static void requestSave() {
 // ============================================================================
 // JSON EXPORT — For web API (/api/peers)
 // ============================================================================
-String getPeersJson() {
-  StaticJsonDocument<2048> doc;
-  JsonArray arr = doc.to<JsonArray>();
+void writePeersJson(Print& out) {
+  JsonWriter w(out);
+  w.beginArray();
 
   for (int i = 0; i < peerCount; i++) {
-    JsonObject obj = arr.createNestedObject();
-    obj["mac"] = macToStr(peers[i].mac);
-    obj["role"] = peers[i].role;
-    obj["hostname"] = peers[i].hostname;
-    obj["id"] = peers[i].deviceId;
-    obj["paired"] = peers[i].paired;
-
+    char mac[18];
+    formatMac(peers[i].mac, mac);
     PeerStatus st = getPeerStatus(peers[i]);
-    obj["status"] = (st == PEER_ONLINE) ? "online" :
-                    (st == PEER_STALE) ? "stale" : "offline";
-    obj["lastSeen"] = peers[i].lastSeen > 0 ?
-                      (int)((millis() - peers[i].lastSeen) / 1000) : -1;
+
+    w.beginObject()
+     .field("mac", mac)
+     .field("role", peers[i].role)
+     .field("hostname", peers[i].hostname)
+     .field("id", peers[i].deviceId)
+     .field("paired", peers[i].paired)
+     .field("status", (st == PEER_ONLINE) ? "online" :
+                      (st == PEER_STALE) ? "stale" : "offline")
+     .field("lastSeen", peers[i].lastSeen > 0 ?
+                        (int)((millis() - peers[i].lastSeen) / 1000) : -1);
 
     // Beacon diagnostics (if we've received at least one beacon with data)
     if (peers[i].diag.valid) {
-      JsonObject d = obj.createNestedObject("diag");
-      d["uptimeMin"]  = peers[i].diag.uptimeMin;
-      d["freeHeapKB"] = peers[i].diag.freeHeapKB;
-      d["rssi"]       = peers[i].diag.rssi;
       const char* stateStr = "UNKNOWN";
       switch (peers[i].diag.raceState) {
         case IDLE:     stateStr = "IDLE";     break;
@@ -372,27 +436,34 @@ String getPeersJson() {
         case RACING:   stateStr = "RACING";   break;
         case FINISHED: stateStr = "FINISHED"; break;
       }
-      d["raceState"]  = stateStr;
       char fwBuf[12];
       snprintf(fwBuf, sizeof(fwBuf), "%d.%d", peers[i].diag.fwMajor, peers[i].diag.fwMinor);
-      d["fwVersion"]  = fwBuf;
+      w.beginObject("diag")
+       .field("uptimeMin", peers[i].diag.uptimeMin)
+       .field("freeHeapKB", peers[i].diag.freeHeapKB)
+       .field("rssi", peers[i].diag.rssi)
+       .field("raceState", stateStr)
+       .field("fwVersion", fwBuf)
+       .endObject();
     }
+    w.endObject();
   }
 
-  String output;
-  serializeJson(doc, output);
-  return output;
+  w.endArray();
 }
 
 // Forward declarations for fleet management handlers (defined after discoveryLoop)
 static void handleWiFiConfig(const WiFiConfigMsg& wcfg, const uint8_t* srcMac);
 static void handleRemoteCmd(const RemoteCmdMsg& rcmd, const uint8_t* srcMac);
+static void handleAudioCue(const AudioCueMsg& cue, const uint8_t* srcMac, uint64_t receiveTime);
 
 // ============================================================================
 // ESP-NOW RECEIVE CALLBACK — Heart of the "Brother's Six" protocol
 // ============================================================================
 static void onDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int len) {
+  HEAP_TAG(ESPNOW);
   if (len < 1) return;
+  metricInc(MET_ESPNOW_RX);
 
   // DEBUG: Uncomment to log unknown traffic (floods ring buffer at ~2/sec/peer)
   // LOG.printf("[ESPNOW-RX] type=%d len=%d from=%02X:%02X:%02X:%02X:%02X:%02X\n",
@@ -439,6 +510,12 @@ static void onDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int
       handleRemoteCmd(rcmd, info->src_addr);
       return;
     }
+    if (msgType == MSG_AUDIO_CUE && len >= (int)sizeof(AudioCueMsg)) {
+      AudioCueMsg cue;
+      memcpy(&cue, data, sizeof(cue));
+      handleAudioCue(cue, info->src_addr, nowUs());
+      return;
+    }
   }
 
   // ---- STANDARD MESSAGES: Fixed 56-byte ESPMessage ----
@@ -472,7 +549,7 @@ static void onDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int
 
     // Auto-pair: if compatible and not yet paired → initiate
     if (!peers[idx].paired && isCompatibleRole(cfg.role, msg.role)) {
-      LOG.printf("[PEERS] Compatible: %s (%s) — requesting pair\n",
+      LOG_DEFER(PEERS, INFO, "Compatible: %s (%s) — requesting pair",
                     msg.hostname, msg.role);
       ESPMessage req;
       buildMessage(req, MSG_PAIR_REQ, nowUs(), 0);
@@ -499,7 +576,7 @@ static void onDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int
 
     // Auto-pair if compatible and not yet paired
     if (!peers[idx].paired && isCompatibleRole(cfg.role, msg.role)) {
-      LOG.printf("[PEERS] Compatible ACK: %s (%s) — requesting pair\n",
+      LOG_DEFER(PEERS, INFO, "Compatible ACK: %s (%s) — requesting pair",
                     msg.hostname, msg.role);
       ESPMessage req;
       buildMessage(req, MSG_PAIR_REQ, nowUs(), 0);
@@ -511,7 +588,7 @@ static void onDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int
   // ---- PAIR_REQ: "I want to pair with you" ----
   if (msg.type == MSG_PAIR_REQ) {
     if (!isCompatibleRole(cfg.role, msg.role)) {
-      LOG.printf("[PEERS] Rejected pair: incompatible %s (%s)\n",
+      LOG_DEFER(PEERS, INFO, "Rejected pair: incompatible %s (%s)",
                     msg.hostname, msg.role);
       return;
     }
@@ -525,7 +602,7 @@ static void onDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int
     }
 
     peers[idx].paired = true;
-    LOG.printf("[PEERS] ★ PAIRED with %s (%s) @ %s\n",
+    LOG_DEFER(PEERS, INFO, "★ PAIRED with %s (%s) @ %s",
                   msg.hostname, msg.role, macToStr(info->src_addr).c_str());
 
     // Confirm
@@ -547,7 +624,7 @@ static void onDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int
 
     if (!peers[idx].paired) {
       peers[idx].paired = true;
-      LOG.printf("[PEERS] ★ PAIR CONFIRMED: %s (%s)\n", msg.hostname, msg.role);
+      LOG_DEFER(PEERS, INFO, "★ PAIR CONFIRMED: %s (%s)", msg.hostname, msg.role);
       requestSave();
     }
     return;
@@ -577,6 +654,18 @@ static void onDataRecv(const esp_now_recv_info_t *info, const uint8_t *data, int
   }
 }
 
+// Delivery result of every esp_now_send() — feeds the per-peer /metrics counters.
+// Broadcasts always report success (no MAC-layer ACK).
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 5, 0)
+static void onDataSent(const wifi_tx_info_t *info, esp_now_send_status_t status) {
+  metricsEspNowSent(info ? info->des_addr : nullptr, status == ESP_NOW_SEND_SUCCESS);
+}
+#else
+static void onDataSent(const uint8_t *mac, esp_now_send_status_t status) {
+  metricsEspNowSent(mac, status == ESP_NOW_SEND_SUCCESS);
+}
+#endif
+
 // ============================================================================
 // INITIALIZATION
 // ============================================================================
@@ -587,6 +676,7 @@ void initESPNow() {
   }
 
   esp_now_register_recv_cb(onDataRecv);
+  esp_now_register_send_cb(onDataSent);
 
   // Broadcast peer for beacons
   esp_now_peer_info_t broadcastPeer = {};
@@ -700,6 +790,21 @@ void unpackBeaconDiag(int64_t packed, PeerDiagnostics& out) {
   out.valid      = true;
 }
 
+// ============================================================================
+// START TIMING — LiDAR launch metrics packed into the MSG_START offset field
+// ============================================================================
+
+int64_t packStartTiming(const StartTiming& t) {
+  if (!t.valid) return 0;
+  return (int64_t)(((uint64_t)t.reaction_us << 32) | (uint32_t)t.launchToBeam_us);
+}
+
+void unpackStartTiming(int64_t packed, StartTiming& out) {
+  out.reaction_us     = (uint32_t)((uint64_t)packed >> 32);
+  out.launchToBeam_us = (int32_t)(uint32_t)(packed & 0xFFFFFFFF);
+  out.valid           = out.reaction_us != 0;
+}
+
 // ============================================================================
 // FLEET MANAGEMENT — WiFi sharing and remote commands
 // ============================================================================
@@ -795,6 +900,32 @@ static void handleRemoteCmd(const RemoteCmdMsg& rcmd, const uint8_t* srcMac) {
   }
 }
 
+// Handle an audio cue from any paired peer (start ↔ finish, finish → others)
+static void handleAudioCue(const AudioCueMsg& cue, const uint8_t* srcMac, uint64_t receiveTime) {
+  int idx = findPeerByMac(srcMac);
+  if (idx < 0 || !peers[idx].paired) {
+    LOG.printf("[FLEET] Audio cue rejected — sender not paired (%s)\n",
+               macToStr(srcMac).c_str());
+    return;
+  }
+
+  char clip[sizeof(cue.clip) + 1];
+  memcpy(clip, cue.clip, sizeof(cue.clip));
+  clip[sizeof(cue.clip)] = '\0';
+
+  // Unsynced: carry the sender's lead over to our clock from the moment the
+  // cue arrived
+  uint64_t at = cue.fleetTimeUs;
+  if (!fleetClockSynced()) {
+    at = receiveTime + clockOffset_us + (int64_t)(cue.fleetTimeUs - cue.sentFleetUs);
+  }
+
+  uint8_t priority = cue.priority > AUDIO_PRIO_HIGH ? AUDIO_PRIO_HIGH : cue.priority;
+  playSoundAt(clip, at, (AudioPriority)priority, cue.voice);
+  LOG.printf("[FLEET] Audio cue %s from %s in %lld us%s\n", clip, cue.senderRole,
+             (long long)(at - fleetNowUs()), fleetClockSynced() ? "" : " (unsynced)");
+}
+
 void sendWiFiConfig(const uint8_t* mac) {
   WiFiConfigMsg wcfg;
   memset(&wcfg, 0, sizeof(wcfg));
@@ -835,6 +966,34 @@ void sendRemoteCmd(const uint8_t* mac, uint8_t cmd, uint32_t param) {
   LOG.printf("[FLEET] Command %d sent to %s\n", cmd, macToStr(mac).c_str());
 }
 
+void sendAudioCue(const uint8_t* mac, const char* clip, uint64_t fleetTimeUs,
+                  uint8_t priority, int8_t voice) {
+  AudioCueMsg cue;
+  memset(&cue, 0, sizeof(cue));
+  cue.type = MSG_AUDIO_CUE;
+  cue.senderId = cfg.device_id;
+  cue.priority = priority;
+  cue.voice = voice;
+  cue.fleetTimeUs = fleetTimeUs;
+  strncpy(cue.clip, clip, sizeof(cue.clip) - 1);
+  strncpy(cue.senderRole, cfg.role, sizeof(cue.senderRole) - 1);
+
+  ensureESPNowPeer(mac);
+  cue.sentFleetUs = fleetNowUs();   // Last, to keep the unsynced error to air time
+  esp_now_send(mac, (uint8_t*)&cue, sizeof(cue));
+}
+
+int sendAudioCueAll(const char* clip, uint64_t fleetTimeUs, uint8_t priority, int8_t voice) {
+  int sent = 0;
+  for (int i = 0; i < peerCount; i++) {
+    if (peers[i].paired) {
+      sendAudioCue(peers[i].mac, clip, fleetTimeUs, priority, voice);
+      sent++;
+    }
+  }
+  return sent;
+}
+
 // ============================================================================
 // DISCOVERY LOOP — Called every iteration of main loop()
 //
@@ -845,6 +1004,7 @@ void sendRemoteCmd(const uint8_t* mac, uint8_t cmd, uint32_t param) {
 //   - Total radio overhead: ~21 bytes/sec (0.001% of WiFi capacity)
 // ============================================================================
 void discoveryLoop() {
+  HEAP_TAG(ESPNOW);
   unsigned long now = millis();
 
   // ---- Beacon every 2 seconds (with packed diagnostics) ----
@@ -865,10 +1025,10 @@ void discoveryLoop() {
     if (peerConnected) lastPeerSeen = now;
   }
 
-  // ---- Deferred save (debounce 2s to reduce flash wear) ----
+  // ---- Deferred save (debounce 2s to reduce flash wear, written by the storage task) ----
   if (needsSave && now - saveRequestedAt > PEER_SAVE_DEBOUNCE_MS) {
     needsSave = false;
-    savePeers();
+    queuePeersSave();
   }
 
   // ---- Apply pending WiFi config when race is IDLE (safety: avoid mid-race reboot) ----
@@ -27,6 +27,7 @@
 #define MSG_TELEM_ACK    17  // Finish → telemetry: acknowledge receipt
 #define MSG_REMOTE_CMD   18  // Finish → peer: remote command (reboot, identify, etc.)
 #define MSG_WIFI_CONFIG  19  // Finish → peer: push WiFi credentials
+#define MSG_AUDIO_CUE    20  // Paired peer → peer: play a clip at a fleet time
 
 // ============================================================================
 // REMOTE COMMAND SUBTYPES
@@ -121,6 +122,21 @@ struct __attribute__((packed)) RemoteCmdMsg {
   char senderRole[16];    // Role of sender (for verification)
 };  // 24 bytes
 
+// Scheduled audio cue — play `clip` when the fleet clock reaches fleetTimeUs.
+// sentFleetUs is the sender's fleet clock at send time: a receiver without a
+// synced offset plays at (receive time + fleetTimeUs - sentFleetUs), which is
+// off only by the air time (~1 ms).
+struct __attribute__((packed)) AudioCueMsg {
+  uint8_t type;           // MSG_AUDIO_CUE (20)
+  uint8_t senderId;
+  uint8_t priority;       // AudioPriority
+  int8_t voice;           // AUDIO_VOICE_ANY (-1) or a voice index
+  uint64_t fleetTimeUs;   // When to play, on the fleet clock
+  uint64_t sentFleetUs;   // Sender's fleet clock when sent
+  char clip[32];          // "beep.wav"
+  char senderRole[16];    // Role of sender (for logging)
+};  // 68 bytes
+
 // ============================================================================
 // BEACON DIAGNOSTICS — Packed into beacon offset field (int64_t, 8 bytes)
 //
@@ -144,6 +160,21 @@ struct PeerDiagnostics {
   bool     valid;         // True if we've received at least one beacon with diag data
 };
 
+// ============================================================================
+// START TIMING — Packed into the MSG_START offset field (int64_t, 8 bytes)
+//
+// The start gate's LiDAR times the car's departure from staging. MSG_START
+// carries what it measured alongside the beam-break timestamp:
+//   Bits 63-32: reaction_us      (uint32 — arm → LiDAR departure)
+//   Bits 31-0:  launchToBeam_us  (int32  — LiDAR departure → start beam)
+// offset 0 (no LiDAR, or no launch seen since arming) = not measured.
+// ============================================================================
+struct StartTiming {
+  uint32_t reaction_us;
+  int32_t  launchToBeam_us;   // Negative if the beam broke before the LiDAR saw the car go
+  bool     valid;
+};
+
 // ============================================================================
 // PEER REGISTRY — The "Brother's Six" System
 //
@@ -187,6 +218,7 @@ struct KnownPeer {
 extern volatile RaceState raceState;
 extern bool dryRunMode;              // Dry-run: race works but no data is logged/saved
 extern int64_t clockOffset_us;
+extern bool clockSynced;             // Finish: at least one MSG_OFFSET received
 extern bool peerConnected;           // Legacy: true if PRIMARY peer is online
 extern unsigned long lastPeerSeen;   // Legacy: millis() of last primary peer msg
 
@@ -199,6 +231,16 @@ extern int peerCount;
 // ============================================================================
 uint64_t nowUs();  // Definition in .cpp is IRAM_ATTR (ISR-safe)
 
+// ============================================================================
+// FLEET CLOCK — the start gate's esp_timer
+//
+// The finish gate follows it through clockOffset_us (MSG_SYNC_REQ/MSG_OFFSET
+// every 10 s). Other roles don't sync; on them fleet time is local time.
+// ============================================================================
+uint64_t fleetNowUs();
+uint64_t fleetToLocalUs(uint64_t fleetUs);
+bool fleetClockSynced();   // True on the start gate, and on a synced finish gate
+
 // ============================================================================
 // INITIALIZATION
 // ============================================================================
@@ -235,14 +277,14 @@ void forgetPeer(const uint8_t* mac);
 // Forget ALL peers (factory reset peers)
 void forgetAllPeers();
 
-// Get peers list as JSON string (for web API)
-String getPeersJson();
+// Write the peers list as a JSON array (for web API)
+void writePeersJson(Print& out);
 
 // ============================================================================
 // PEER PERSISTENCE
 // ============================================================================
 void loadPeers();   // Load /peers.json from LittleFS
-void savePeers();   // Save /peers.json to LittleFS
+void savePeers();   // Write the last queued snapshot to /peers.json (storage task)
 
 // ============================================================================
 // DISCOVERY LOOP — Call from main loop()
@@ -273,6 +315,10 @@ int64_t packBeaconDiag();
 // Unpack diagnostics from a received beacon offset field
 void unpackBeaconDiag(int64_t packed, PeerDiagnostics& out);
 
+// Pack/unpack LiDAR launch timing for the MSG_START offset field
+int64_t packStartTiming(const StartTiming& t);
+void unpackStartTiming(int64_t packed, StartTiming& out);
+
 // Send WiFi credentials to a specific peer (by MAC)
 void sendWiFiConfig(const uint8_t* mac);
 
@@ -282,6 +328,12 @@ void sendWiFiConfigAll();
 // Send a remote command to a specific peer
 void sendRemoteCmd(const uint8_t* mac, uint8_t cmd, uint32_t param = 0);
 
+// Schedule a clip on a specific peer / on ALL paired peers at a fleet time
+// (pair with a local playSoundAt() for the same time). Returns peers sent to.
+void sendAudioCue(const uint8_t* mac, const char* clip, uint64_t fleetTimeUs,
+                  uint8_t priority, int8_t voice);
+int sendAudioCueAll(const char* clip, uint64_t fleetTimeUs, uint8_t priority, int8_t voice);
+
 // Identify flag — set by CMD_IDENTIFY handler, checked in main loop() for LED blink
 extern volatile bool identifyActive;
 extern unsigned long identifyStartMs;
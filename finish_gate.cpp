@@ -2,6 +2,13 @@
 #include "config.h"
 #include "wled_integration.h"
 #include "audio_manager.h"
+#include "live_stream.h"
+#include "race_log.h"
+#include "serial_log.h"
+#include "metrics.h"
+#include "storage.h"
+#include "heap_track.h"
+#include "json_writer.h"
 #include <LittleFS.h>
 
 // Forward declaration from web_server
@@ -16,6 +23,7 @@ String currentCar = "Unknown";
 float currentWeight = 35.0;
 uint32_t totalRuns = 0;
 double midTrackSpeed_mps = 0; // From speed trap node via ESP-NOW
+StartTiming startTiming = {};  // From the start gate's MSG_START
 
 static unsigned long lastPingTime = 0;
 static unsigned long lastSyncTime = 0;
@@ -90,6 +98,7 @@ void finishGateLoop() {
     startTime_us = 0;
     finishTime_us = 0;
     portEXIT_CRITICAL(&finishTimerMux);
+    startTiming = {};
     setWLEDState("idle");
     broadcastState();
     LOG.println("[FINISH] Auto-reset to IDLE");
@@ -113,40 +122,57 @@ void finishGateLoop() {
     // ================================================================
     int64_t elapsed_us = (int64_t)safeFinish - (int64_t)safeStart;
 
-    LOG.println("[FINISH] ===== RACE RESULT =====");
-    LOG.printf("[FINISH] finishTime_us = %llu\n", safeFinish);
-    LOG.printf("[FINISH] startTime_us  = %llu\n", safeStart);
-    LOG.printf("[FINISH] clockOffset   = %lld\n", clockOffset_us);
-    LOG.printf("[FINISH] elapsed_us    = %lld\n", elapsed_us);
+    LOG_DEFER(FINISH, INFO, "===== RACE RESULT =====");
+    LOG_DEFER(FINISH, DEBUG, "finishTime_us = %llu", safeFinish);
+    LOG_DEFER(FINISH, DEBUG, "startTime_us  = %llu", safeStart);
+    LOG_DEFER(FINISH, DEBUG, "clockOffset   = %lld", clockOffset_us);
+    LOG_DEFER(FINISH, DEBUG, "elapsed_us    = %lld", elapsed_us);
 
     // Sanity check: elapsed must be positive and reasonable (< 60 seconds)
     if (elapsed_us <= 0 || elapsed_us > MAX_RACE_DURATION_US) {
-      LOG.printf("[FINISH] BAD TIMING! elapsed=%lld us\n", elapsed_us);
+      LOG_DEFER(FINISH, ERROR, "BAD TIMING! elapsed=%lld us", elapsed_us);
+      metricInc(MET_TIMING_ERRORS);
       elapsed_us = 0; // Will show as 0.000s which signals a timing error
     }
 
     double elapsed_s = elapsed_us / 1000000.0;
     double speed_ms = (elapsed_s > 0) ? cfg.track_length_m / elapsed_s : 0;
 
-    LOG.printf("[FINISH] Time: %.4f s, Speed: %.1f mph\n",
-                  elapsed_s, speed_ms * MPS_TO_MPH);
-    LOG.println("[FINISH] =========================");
+    LOG_DEFER(FINISH, INFO, "Time: %.4f s, Speed: %.1f mph",
+              elapsed_s, speed_ms * MPS_TO_MPH);
+    if (startTiming.valid) {
+      LOG_DEFER(FINISH, INFO, "Reaction: %.3f s, launch to beam: %.1f ms",
+                startTiming.reaction_us / 1000000.0, startTiming.launchToBeam_us / 1000.0);
+    }
+    LOG_DEFER(FINISH, INFO, "=========================");
+    metricInc(MET_RACES_COMPLETED);
 
-    // Save to LittleFS CSV (includes all physics data)
+    // Physics for the run log
     double mass_kg = currentWeight / 1000.0;
     double momentum = mass_kg * speed_ms;
     double ke = 0.5 * mass_kg * speed_ms * speed_ms;
 
+    // Hand the record to the storage task — run log, history and the
+    // leaderboard are written once the race loop goes quiet
     if (!dryRunMode) {
-      File file = LittleFS.open("/runs.csv", "a");
-      if (file) {
-        if (file.size() == 0) file.println("Run,Car,Weight(g),Time(s),Speed(mph),Scale(mph),Momentum,KE(J)");
-        file.printf("%u,%s,%.1f,%.4f,%.2f,%.1f,%.4f,%.4f\n", ++totalRuns, currentCar.c_str(),
-                    currentWeight, elapsed_s, speed_ms * MPS_TO_MPH,
-                    speed_ms * MPS_TO_MPH * (double)cfg.scale_factor,
-                    momentum, ke);
-        file.close();
-      }
+      RaceRecord rec = {};
+      rec.run = ++totalRuns;
+      rec.timestamp_ms = epochMs();
+      strncpy(rec.car, currentCar.c_str(), sizeof(rec.car) - 1);
+      rec.weight_g = currentWeight;
+      rec.time_s = elapsed_s;
+      rec.elapsed_us = (uint32_t)elapsed_us;
+      rec.speed_mps = speed_ms;
+      rec.speed_mph = speed_ms * MPS_TO_MPH;
+      rec.scale_mph = speed_ms * MPS_TO_MPH * (double)cfg.scale_factor;
+      rec.momentum = momentum;
+      rec.ke = ke;
+      rec.midTrack_mps = midTrackSpeed_mps;
+      rec.launchValid = startTiming.valid;
+      rec.reaction_us = startTiming.reaction_us;
+      rec.launchToBeam_us = startTiming.launchToBeam_us;
+      // Timing errors go to the run log but are not results
+      storageSubmitRace(rec, elapsed_us > 0);
     } else {
       LOG.println("[FINISH] Dry-run mode — CSV logging skipped");
     }
@@ -158,7 +184,7 @@ void finishGateLoop() {
     setWLEDState("finished");
 
     // Play finish sound effect
-    playSound("finish.wav");
+    playSound("finish.wav", AUDIO_PRIO_HIGH);
 
     // Broadcast results to WebSocket clients IMMEDIATELY - no delay!
     broadcastState();
@@ -199,12 +225,16 @@ void onFinishGateESPNow(const ESPMessage& msg, uint64_t receiveTime) {
         startTime_us = msg.timestamp - clockOffset_us;
         portEXIT_CRITICAL(&finishTimerMux);
 
-        LOG.printf("[FINISH] START received: raw_ts=%llu, offset=%lld, adjusted=%llu\n",
-                      msg.timestamp, clockOffset_us, startTime_us);
+        // Reaction and launch-to-beam from the start gate's LiDAR (offset
+        // 0 from older firmware or without LiDAR = not measured)
+        unpackStartTiming(msg.offset, startTiming);
+
+        LOG_DEFER(FINISH, DEBUG, "START received: raw_ts=%llu, offset=%lld, adjusted=%llu",
+                  msg.timestamp, clockOffset_us, startTime_us);
 
         raceState = RACING;
         setWLEDState("racing");
-        LOG.println("[FINISH] RACE STARTED!");
+        LOG_DEFER(FINISH, INFO, "RACE STARTED!");
         broadcastState();
       }
       break;
@@ -219,12 +249,15 @@ void onFinishGateESPNow(const ESPMessage& msg, uint64_t receiveTime) {
       // offset = start_gate_clock - finish_gate_clock
       int64_t newOffset = (int64_t)msg.timestamp - (int64_t)receiveTime;
       int64_t drift = newOffset - clockOffset_us;
-      bool firstSync = (clockOffset_us == 0);
+      bool firstSync = !clockSynced;
       clockOffset_us = newOffset;
+      clockSynced = true;
+      streamPushSync(newOffset, firstSync ? 0 : drift);
+      metricsClockSync(firstSync ? 0 : (int32_t)constrain(drift, (int64_t)INT32_MIN, (int64_t)INT32_MAX));
       // Only log on first sync or when drift exceeds 500us to reduce console noise
       if (firstSync || drift > 500 || drift < -500) {
-        LOG.printf("[FINISH] Clock sync: offset=%lld us (%.1f ms), drift=%lld us\n",
-                      clockOffset_us, clockOffset_us / 1000.0, drift);
+        LOG_DEFER(FINISH, INFO, "Clock sync: offset=%lld us (%.1f ms), drift=%lld us",
+                  clockOffset_us, clockOffset_us / 1000.0, drift);
       }
       break;
     }
@@ -233,8 +266,8 @@ void onFinishGateESPNow(const ESPMessage& msg, uint64_t receiveTime) {
       // Speed trap node sent mid-track velocity
       // Encoded as speed_mps * 10000 in the offset field
       midTrackSpeed_mps = msg.offset / SPEED_FIXED_POINT_SCALE;
-      LOG.printf("[FINISH] Speed trap data: %.3f m/s (%.1f mph)\n",
-                    midTrackSpeed_mps, midTrackSpeed_mps * MPS_TO_MPH);
+      LOG_DEFER(FINISH, INFO, "Speed trap data: %.3f m/s (%.1f mph)",
+                midTrackSpeed_mps, midTrackSpeed_mps * MPS_TO_MPH);
       // Acknowledge receipt
       sendToPeer(MSG_SPEED_ACK, nowUs(), 0);
       break;
@@ -281,6 +314,7 @@ static uint16_t telemCRC16(const uint8_t* data, size_t len) {
 }
 
 void onTelemetryHeader(const uint8_t* srcMac, const TelemetryHeader& hdr) {
+  HEAP_TAG(TELEMETRY);
   LOG.printf("[TELEM] Header: runId=%u, %d samples @ %dHz, ±%dg/±%ddps, %ums\n",
              hdr.runId, hdr.sampleCount, hdr.sampleRate,
              hdr.accelRange, hdr.gyroRange_div100 * 100, hdr.duration_ms);
@@ -316,7 +350,8 @@ void onTelemetryHeader(const uint8_t* srcMac, const TelemetryHeader& hdr) {
 
 void onTelemetryChunk(const uint8_t* srcMac, const TelemetryChunk& chunk) {
   if (!telemInProgress || chunk.runId != telemRunId) {
-    LOG.printf("[TELEM] Stale chunk (runId %u, expected %u)\n", chunk.runId, telemRunId);
+    LOG_DEFER(TELEM, WARN, "Stale chunk (runId %u, expected %u)", chunk.runId, telemRunId);
+    metricInc(MET_TELEM_CHUNKS_LOST);
     return;
   }
 
@@ -348,19 +383,23 @@ void onTelemetryChunk(const uint8_t* srcMac, const TelemetryChunk& chunk) {
 
   // Progress log every 10 chunks
   if (telemReceivedChunks % 10 == 0 || telemReceivedChunks == telemExpectedChunks) {
-    LOG.printf("[TELEM] Chunk %d/%d (%d/%d samples)\n",
-               telemReceivedChunks, telemExpectedChunks,
-               telemReceivedSamples, telemExpectedSamples);
+    LOG_DEFER(TELEM, DEBUG, "Chunk %d/%d (%d/%d samples)",
+              telemReceivedChunks, telemExpectedChunks,
+              telemReceivedSamples, telemExpectedSamples);
   }
 }
 
 void onTelemetryEnd(const uint8_t* srcMac, const TelemetryEnd& end) {
+  HEAP_TAG(TELEMETRY);
   if (!telemInProgress || end.runId != telemRunId) {
     LOG.printf("[TELEM] Stale end marker (runId %u)\n", end.runId);
     return;
   }
 
   telemInProgress = false;
+  if (telemReceivedChunks < telemExpectedChunks) {
+    metricInc(MET_TELEM_CHUNKS_LOST, telemExpectedChunks - telemReceivedChunks);
+  }
 
   // Verify
   if (telemReceivedSamples != end.sampleCount) {
@@ -378,35 +417,12 @@ void onTelemetryEnd(const uint8_t* srcMac, const TelemetryEnd& end) {
     LOG.printf("[TELEM] CRC OK: 0x%04X\n", localCRC);
   }
 
-  // Write CSV to LittleFS
-  File f = LittleFS.open("/telemetry_latest.csv", "w");
-  if (f) {
-    f.println("timestamp_ms,accel_x_g,accel_y_g,accel_z_g,gyro_x_dps,gyro_y_dps,gyro_z_dps");
-    for (uint16_t i = 0; i < telemReceivedSamples; i++) {
-      f.printf("%.3f,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f\n",
-        telemBuffer[i].timestamp_us / 1000.0f,
-        telemBuffer[i].ax * TELEM_ACCEL_LSB_TO_G,
-        telemBuffer[i].ay * TELEM_ACCEL_LSB_TO_G,
-        telemBuffer[i].az * TELEM_ACCEL_LSB_TO_G,
-        telemBuffer[i].gx * TELEM_GYRO_LSB_TO_DPS,
-        telemBuffer[i].gy * TELEM_GYRO_LSB_TO_DPS,
-        telemBuffer[i].gz * TELEM_GYRO_LSB_TO_DPS);
-    }
-    f.close();
-
-    LOG.printf("[TELEM] ✓ Saved /telemetry_latest.csv (%d samples, %ums, run %u)\n",
-               telemReceivedSamples, telemDuration_ms, telemRunId);
-  } else {
-    LOG.println("[TELEM] ERROR: Failed to open /telemetry_latest.csv for writing");
+  // The CSV export goes to the storage task, which owns the buffer from here
+  if (telemBuffer != NULL) {
+    storageSubmitTelemetry(telemBuffer, telemReceivedSamples, telemRunId, telemDuration_ms);
+    telemBuffer = NULL;
   }
 
-  // Update last-run info
-  telemDataReady = true;
-  telemLastSampleCount = telemReceivedSamples;
-  telemLastDuration_ms = telemDuration_ms;
-  telemLastRunId = telemRunId;
-  telemLastReceivedAt = millis();
-
   // Send ACK
   ESPMessage ack;
   ack.type = MSG_TELEM_ACK;
@@ -418,31 +434,56 @@ void onTelemetryEnd(const uint8_t* srcMac, const TelemetryEnd& end) {
   esp_now_send(srcMac, (uint8_t*)&ack, sizeof(ack));
 
   LOG.printf("[TELEM] ACK sent. Elapsed: %ums\n", millis() - telemStartedAt);
+}
 
-  // Free buffer (data is in CSV file now)
-  if (telemBuffer != NULL) {
-    free(telemBuffer);
-    telemBuffer = NULL;
+// Runs on the storage task (storage.cpp), after the ACK has gone out
+void telemetryWriteCsv(const IMUSample* samples, uint16_t count, uint32_t runId, uint32_t duration_ms) {
+  File f = LittleFS.open("/telemetry_latest.csv", "w");
+  if (!f) {
+    LOG.println("[TELEM] ERROR: Failed to open /telemetry_latest.csv for writing");
+    return;
+  }
+  f.println("timestamp_ms,accel_x_g,accel_y_g,accel_z_g,gyro_x_dps,gyro_y_dps,gyro_z_dps");
+  for (uint16_t i = 0; i < count; i++) {
+    f.printf("%.3f,%.4f,%.4f,%.4f,%.2f,%.2f,%.2f\n",
+      samples[i].timestamp_us / 1000.0f,
+      samples[i].ax * TELEM_ACCEL_LSB_TO_G,
+      samples[i].ay * TELEM_ACCEL_LSB_TO_G,
+      samples[i].az * TELEM_ACCEL_LSB_TO_G,
+      samples[i].gx * TELEM_GYRO_LSB_TO_DPS,
+      samples[i].gy * TELEM_GYRO_LSB_TO_DPS,
+      samples[i].gz * TELEM_GYRO_LSB_TO_DPS);
   }
+  metricInc(MET_FS_BYTES_WRITTEN, f.size());
+  f.close();
+
+  LOG.printf("[TELEM] ✓ Saved /telemetry_latest.csv (%d samples, %ums, run %u)\n",
+             count, duration_ms, runId);
+
+  // Update last-run info
+  telemDataReady = true;
+  telemLastSampleCount = count;
+  telemLastDuration_ms = duration_ms;
+  telemLastRunId = runId;
+  telemLastReceivedAt = millis();
 }
 
 bool hasTelemetryData() {
   return telemDataReady;
 }
 
-String getTelemetryInfoJson() {
-  String json = "{";
-  json += "\"available\":" + String(telemDataReady ? "true" : "false");
+void writeTelemetryInfoJson(Print& out) {
+  JsonWriter w(out);
+  w.beginObject().field("available", telemDataReady);
   if (telemDataReady) {
-    json += ",\"samples\":" + String(telemLastSampleCount);
-    json += ",\"duration_ms\":" + String(telemLastDuration_ms);
-    json += ",\"runId\":" + String(telemLastRunId);
-    json += ",\"sampleRate\":" + String(telemSampleRate);
-    json += ",\"accelRange\":" + String(telemAccelRange);
-    json += ",\"gyroRange\":" + String(telemGyroRange);
-    json += ",\"receivedAt\":" + String(telemLastReceivedAt);
-    json += ",\"uptime_ms\":" + String(millis());
+    w.field("samples", telemLastSampleCount)
+     .field("duration_ms", telemLastDuration_ms)
+     .field("runId", telemLastRunId)
+     .field("sampleRate", telemSampleRate)
+     .field("accelRange", telemAccelRange)
+     .field("gyroRange", telemGyroRange)
+     .field("receivedAt", telemLastReceivedAt)
+     .field("uptime_ms", millis());
   }
-  json += "}";
-  return json;
+  w.endObject();
 }
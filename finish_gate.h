@@ -19,6 +19,9 @@ extern uint32_t totalRuns;
 // Speed trap data (received from speed trap node via ESP-NOW)
 extern double midTrackSpeed_mps;  // 0 if no speed trap data available
 
+// LiDAR launch timing for the current race (from the start gate's MSG_START)
+extern StartTiming startTiming;   // .valid false if not measured
+
 void finishGateSetup();
 void finishGateLoop();
 void onFinishGateESPNow(const ESPMessage& msg, uint64_t receiveTime);
@@ -28,8 +31,11 @@ void onTelemetryHeader(const uint8_t* srcMac, const TelemetryHeader& hdr);
 void onTelemetryChunk(const uint8_t* srcMac, const TelemetryChunk& chunk);
 void onTelemetryEnd(const uint8_t* srcMac, const TelemetryEnd& end);
 
+// Write /telemetry_latest.csv and publish it as the latest run (storage task)
+void telemetryWriteCsv(const IMUSample* samples, uint16_t count, uint32_t runId, uint32_t duration_ms);
+
 // Telemetry state query (for web API)
 bool hasTelemetryData();
-String getTelemetryInfoJson();
+void writeTelemetryInfoJson(Print& out);
 
 #endif
@@ -0,0 +1,286 @@
+#include "heap_track.h"
+#include "config.h"
+#include <esp_heap_caps.h>
+
+static const char* const TAG_NAMES[HEAP_TAG_COUNT] = {
+  "untagged", "espnow", "web", "json", "telemetry", "audio"
+};
+
+const char* heapTagName(HeapTag tag) {
+  return (tag < HEAP_TAG_COUNT) ? TAG_NAMES[tag] : "?";
+}
+
+#if HEAP_TRACK_ENABLED
+
+// ============================================================================
+// STATE
+// ============================================================================
+// One slot per live tagged block: address, and size << 8 | tag. Open
+// addressing with linear probing; ptr == 0 marks an empty slot.
+struct TrackSlot {
+  uintptr_t ptr;
+  uint32_t meta;
+};
+
+#define SLOT_MASK      (HEAP_TRACK_SLOTS - 1)
+#define SLOT_MAX_FILL  (HEAP_TRACK_SLOTS * 3 / 4)   // Keep probes short
+#define SIZE_MAX_META  0x00FFFFFFUL
+
+static_assert((HEAP_TRACK_SLOTS & SLOT_MASK) == 0, "HEAP_TRACK_SLOTS must be a power of two");
+
+static TrackSlot* slots = nullptr;
+static uint32_t slotsUsed = 0;
+static uint32_t tableFull = 0;         // Tagged allocations dropped because the table was full
+static HeapTagStats stats[HEAP_TAG_COUNT];
+static portMUX_TYPE trackMux = portMUX_INITIALIZER_UNLOCKED;
+
+// Innermost open scope of the running task — see HeapTagScope
+static thread_local HeapTag taskTag = HEAP_TAG_NONE;
+
+// ============================================================================
+// TAG SCOPES
+// ============================================================================
+HeapTagScope::HeapTagScope(HeapTag tag) {
+  prevTag = taskTag;
+  taskTag = tag;
+}
+
+HeapTagScope::~HeapTagScope() {
+  taskTag = prevTag;
+}
+
+// Not read until heapTrackBegin() has run from setup(): allocations made
+// before the scheduler starts have no task, and no TLS to read
+static inline HeapTag currentTag() {
+  return slots ? taskTag : HEAP_TAG_NONE;
+}
+
+// ============================================================================
+// POINTER TABLE (call with trackMux held)
+// ============================================================================
+static inline uint32_t slotHome(uintptr_t ptr) {
+  return ((uint32_t)(ptr >> 3) * 2654435761UL) & SLOT_MASK;   // Knuth multiplicative hash
+}
+
+static bool slotInsert(uintptr_t ptr, uint32_t size, HeapTag tag) {
+  if (slotsUsed >= SLOT_MAX_FILL) return false;
+  uint32_t i = slotHome(ptr);
+  while (slots[i].ptr != 0) i = (i + 1) & SLOT_MASK;
+  slots[i].ptr = ptr;
+  slots[i].meta = ((size < SIZE_MAX_META ? size : SIZE_MAX_META) << 8) | tag;
+  slotsUsed++;
+  return true;
+}
+
+// Remove ptr; returns its meta, or 0 if it was never tracked. Backward-shift
+// deletion keeps every remaining entry reachable from its home slot.
+static uint32_t slotRemove(uintptr_t ptr) {
+  uint32_t i = slotHome(ptr);
+  while (slots[i].ptr != ptr) {
+    if (slots[i].ptr == 0) return 0;
+    i = (i + 1) & SLOT_MASK;
+  }
+  uint32_t meta = slots[i].meta;
+  uint32_t j = i;
+  for (;;) {
+    j = (j + 1) & SLOT_MASK;
+    if (slots[j].ptr == 0) break;
+    uint32_t k = slotHome(slots[j].ptr);
+    // Move j back into the hole at i unless its home lies cyclically in (i, j]
+    bool homeBetween = (i <= j) ? (i < k && k <= j) : (i < k || k <= j);
+    if (!homeBetween) {
+      slots[i] = slots[j];
+      i = j;
+    }
+  }
+  slots[i].ptr = 0;
+  slotsUsed--;
+  return meta;
+}
+
+// ============================================================================
+// ACCOUNTING
+// ============================================================================
+static void noteAlloc(void* p, size_t size, HeapTag tag) {
+  portENTER_CRITICAL(&trackMux);
+  HeapTagStats& s = stats[tag];
+  if (p == nullptr) {
+    if (size) s.failed++;
+  } else {
+    s.allocs++;
+    if (tag != HEAP_TAG_NONE && slots) {
+      if (slotInsert((uintptr_t)p, size, tag)) {
+        s.live_bytes += size;
+        s.live_blocks++;
+        if (s.live_bytes > s.peak_bytes) s.peak_bytes = s.live_bytes;
+      } else {
+        tableFull++;
+      }
+    }
+  }
+  portEXIT_CRITICAL(&trackMux);
+}
+
+// Returns the block's meta (size << 8 | tag), or 0 if it wasn't tracked
+static uint32_t noteFree(void* p) {
+  if (p == nullptr) return 0;
+  uint32_t meta = 0;
+  portENTER_CRITICAL(&trackMux);
+  if (slots && slotsUsed) meta = slotRemove((uintptr_t)p);
+  if (meta) {
+    HeapTagStats& s = stats[meta & 0xFF];
+    s.live_bytes -= meta >> 8;
+    s.live_blocks--;
+    s.frees++;
+  }
+  portEXIT_CRITICAL(&trackMux);
+  return meta;
+}
+
+// ============================================================================
+// LINKER WRAPPERS (-Wl,--wrap=malloc etc.)
+// ============================================================================
+extern "C" {
+void* __real_malloc(size_t size);
+void* __real_calloc(size_t n, size_t size);
+void* __real_realloc(void* p, size_t size);
+void  __real_free(void* p);
+void* __real_ps_malloc(size_t size);
+
+void* __wrap_malloc(size_t size) {
+  void* p = __real_malloc(size);
+  noteAlloc(p, size, currentTag());
+  return p;
+}
+
+void* __wrap_calloc(size_t n, size_t size) {
+  void* p = __real_calloc(n, size);
+  noteAlloc(p, n * size, currentTag());
+  return p;
+}
+
+void* __wrap_ps_malloc(size_t size) {
+  void* p = __real_ps_malloc(size);
+  noteAlloc(p, size, currentTag());
+  return p;
+}
+
+// A grown or moved block keeps the tag it was allocated under
+void* __wrap_realloc(void* p, size_t size) {
+  // Untrack first: once the real realloc returns, p may already belong to
+  // another task's allocation
+  uint32_t meta = noteFree(p);
+  HeapTag tag = meta ? (HeapTag)(meta & 0xFF) : currentTag();
+  void* q = __real_realloc(p, size);
+  if (q == nullptr && size && meta) {
+    // Failed: the old block is still live — put it back, and count the
+    // failure rather than an extra alloc/free pair
+    noteAlloc(p, meta >> 8, tag);
+    portENTER_CRITICAL(&trackMux);
+    stats[tag].allocs--;
+    stats[tag].frees--;
+    stats[tag].failed++;
+    portEXIT_CRITICAL(&trackMux);
+    return nullptr;
+  }
+  if (q || size) noteAlloc(q, size, tag);
+  return q;
+}
+
+void __wrap_free(void* p) {
+  noteFree(p);
+  __real_free(p);
+}
+}  // extern "C"
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+void heapTrackBegin() {
+  if (slots) return;
+  size_t bytes = HEAP_TRACK_SLOTS * sizeof(TrackSlot);
+  // heap_caps_* is not wrapped, so the table doesn't track itself
+  TrackSlot* t = (TrackSlot*)heap_caps_calloc(1, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+  if (!t) t = (TrackSlot*)heap_caps_calloc(1, bytes, MALLOC_CAP_8BIT);
+  portENTER_CRITICAL(&trackMux);
+  slots = t;
+  portEXIT_CRITICAL(&trackMux);
+  LOG.printf("[HEAP] Allocation tracking %s (%u slots)\n",
+             t ? "enabled" : "FAILED — no memory for table", HEAP_TRACK_SLOTS);
+}
+
+void heapTrackReset() {
+  portENTER_CRITICAL(&trackMux);
+  for (int i = 0; i < HEAP_TAG_COUNT; i++) {
+    stats[i].peak_bytes = stats[i].live_bytes;
+    stats[i].allocs = 0;
+    stats[i].frees = 0;
+    stats[i].failed = 0;
+  }
+  tableFull = 0;
+  portEXIT_CRITICAL(&trackMux);
+}
+
+uint32_t heapTrackLiveBytes(HeapTag tag) {
+  if (tag >= HEAP_TAG_COUNT) return 0;
+  return stats[tag].live_bytes;
+}
+
+#else  // !HEAP_TRACK_ENABLED
+
+void heapTrackBegin() {}
+void heapTrackReset() {}
+uint32_t heapTrackLiveBytes(HeapTag) { return 0; }
+
+#endif
+
+uint8_t heapFragPct(uint32_t freeHeap, uint32_t maxAlloc) {
+  // The two readings aren't atomic; an allocation between them can leave
+  // maxAlloc above freeHeap
+  if (freeHeap == 0 || maxAlloc >= freeHeap) return 0;
+  return 100 - (uint8_t)((uint64_t)maxAlloc * 100 / freeHeap);
+}
+
+// ============================================================================
+// JSON
+// ============================================================================
+void heapTrackWrite(JsonWriter& w) {
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t maxAlloc = ESP.getMaxAllocHeap();
+  w.field("tracking", (bool)HEAP_TRACK_ENABLED);
+  w.beginObject("heap")
+   .field("free_heap", freeHeap)
+   .field("min_free_heap", ESP.getMinFreeHeap())
+   .field("max_alloc_heap", maxAlloc)
+   .field("heap_frag_pct", heapFragPct(freeHeap, maxAlloc))
+   .field("psram_free", ESP.getFreePsram())
+   .field("psram_max_alloc", ESP.getMaxAllocPsram())
+   .endObject();
+
+#if HEAP_TRACK_ENABLED
+  HeapTagStats snap[HEAP_TAG_COUNT];
+  uint32_t full, used;
+  portENTER_CRITICAL(&trackMux);
+  memcpy(snap, stats, sizeof(snap));
+  full = tableFull;
+  used = slotsUsed;
+  portEXIT_CRITICAL(&trackMux);
+
+  w.field("table_slots_used", used);
+  w.field("table_full_drops", full);
+  w.beginObject("tags");
+  for (int i = 0; i < HEAP_TAG_COUNT; i++) {
+    w.beginObject(TAG_NAMES[i]);
+    if (i != HEAP_TAG_NONE) {
+      w.field("live_bytes", snap[i].live_bytes)
+       .field("live_blocks", snap[i].live_blocks)
+       .field("peak_bytes", snap[i].peak_bytes)
+       .field("frees", snap[i].frees);
+    }
+    w.field("allocs", snap[i].allocs)
+     .field("failed", snap[i].failed)
+     .endObject();
+  }
+  w.endObject();
+#endif
+}
@@ -0,0 +1,87 @@
+#ifndef HEAP_TRACK_H
+#define HEAP_TRACK_H
+
+#include <Arduino.h>
+#include "json_writer.h"
+
+// ============================================================================
+// HEAP TRACKING — Per-subsystem allocation counters (debug builds)
+//
+// getMaxAllocHeap() shrinking over an all-day event says the heap is
+// fragmenting, not who is doing it. With HEAP_TRACK_ENABLED the linker wraps
+// malloc/calloc/realloc/free/ps_malloc (see [env:heaptrack] in
+// platformio.ini) and every allocation made inside a HEAP_TAG(...) scope is
+// charged to that subsystem: live bytes and blocks, peak, alloc/free counts
+// and failures. Frees are matched through a pointer table in PSRAM, so a
+// block allocated under one tag and freed elsewhere is still credited back.
+//
+// The current tag is thread_local, so it belongs to the task that opened the
+// scope: another task preempting it, on either core, sees its own tag (or
+// none), and the scope's tag is still there when the task resumes.
+// Allocations outside any scope are counted but not sized.
+//
+// Release builds leave HEAP_TRACK_ENABLED at 0: HEAP_TAG() compiles to
+// nothing and malloc is untouched. /api/diagnostics/heap still reports the
+// heap totals and the soak test (soak_test.h) either way.
+// ============================================================================
+
+#ifndef HEAP_TRACK_ENABLED
+#define HEAP_TRACK_ENABLED 0
+#endif
+
+#define HEAP_TRACK_SLOTS   4096   // Live tagged blocks tracked (8 bytes each, PSRAM)
+
+enum HeapTag : uint8_t {
+  HEAP_TAG_NONE = 0,      // Outside any scope
+  HEAP_TAG_ESPNOW,        // Receive callback, discovery, peer registry
+  HEAP_TAG_WEB,           // HTTP handlers, WebSocket, live streams
+  HEAP_TAG_JSON,          // ArduinoJson documents (config, peers, history, state)
+  HEAP_TAG_TELEMETRY,     // IMU telemetry reassembly and CSV export
+  HEAP_TAG_AUDIO,         // WAV loading and playback
+  HEAP_TAG_COUNT
+};
+
+struct HeapTagStats {
+  uint32_t live_bytes;
+  uint32_t live_blocks;
+  uint32_t peak_bytes;
+  uint32_t allocs;
+  uint32_t frees;
+  uint32_t failed;
+};
+
+// Allocate the pointer table. Call early in setup(); allocations made before
+// this are not tracked. No-op unless HEAP_TRACK_ENABLED.
+void heapTrackBegin();
+
+// Restart peaks and alloc/free/fail counts (live totals are kept)
+void heapTrackReset();
+
+// Bytes currently live under a tag (0 when tracking is off)
+uint32_t heapTrackLiveBytes(HeapTag tag);
+
+// "espnow", "web", ... — the keys used in the JSON output
+const char* heapTagName(HeapTag tag);
+
+// Share of the free heap that can't be had as one block, in percent
+// (100 − largest block / free heap). Pass one reading of each so the figure
+// matches the free_heap/max_alloc_heap reported next to it.
+uint8_t heapFragPct(uint32_t freeHeap, uint32_t maxAlloc);
+
+// Write "tracking", "heap" and "tags" into an open JSON object
+void heapTrackWrite(JsonWriter& w);
+
+#if HEAP_TRACK_ENABLED
+class HeapTagScope {
+public:
+  explicit HeapTagScope(HeapTag tag);
+  ~HeapTagScope();
+private:
+  HeapTag prevTag;
+};
+#define HEAP_TAG(tag)  HeapTagScope _heapTag_##tag(HEAP_TAG_##tag)
+#else
+#define HEAP_TAG(tag)  do {} while (0)
+#endif
+
+#endif
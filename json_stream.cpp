@@ -0,0 +1,231 @@
+#include "json_stream.h"
+
+JsonStreamParser::JsonStreamParser(JsonSaxHandler& handler) : h(handler) {
+  key[0] = '\0';
+}
+
+bool JsonStreamParser::fail(const char* why) {
+  if (!err) err = why;
+  return false;
+}
+
+static inline bool isWs(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+// ============================================================================
+// CONTAINERS
+// ============================================================================
+bool JsonStreamParser::openContainer(bool isArray) {
+  if (depth >= JSON_STREAM_MAX_DEPTH) return fail("Nesting too deep");
+  const char* k = haveKey ? key : nullptr;
+  depth++;
+  if (isArray) arrayBits |= (1 << (depth - 1));
+  else arrayBits &= ~(1 << (depth - 1));
+  haveKey = false;
+  if (!h.onStart(depth, isArray, k, pos)) return fail(h.error ? h.error : "Rejected");
+  state = isArray ? ST_VALUE_OR_END : ST_KEY_OR_END;
+  return true;
+}
+
+bool JsonStreamParser::closeContainer(bool isArray) {
+  if (depth == 0) return fail("Unexpected close");
+  bool topIsArray = (arrayBits >> (depth - 1)) & 1;
+  if (topIsArray != isArray) return fail("Mismatched bracket");
+  if (!h.onEnd(depth, isArray)) return fail(h.error ? h.error : "Rejected");
+  depth--;
+  state = (depth == 0) ? ST_DONE : ST_AFTER_VALUE;
+  return true;
+}
+
+// ============================================================================
+// SCALARS
+// ============================================================================
+bool JsonStreamParser::endScalar(JsonTokenType type, double number) {
+  const char* k = haveKey ? key : nullptr;
+  haveKey = false;
+  if (!h.onScalar(depth, k, type, number)) return fail(h.error ? h.error : "Rejected");
+  state = (depth == 0) ? ST_DONE : ST_AFTER_VALUE;
+  return true;
+}
+
+// RFC 8259 number: -?(0|[1-9][0-9]*)(\.[0-9]+)?([eE][+-]?[0-9]+)?
+// strtod alone also takes hex, inf, '+1', '01', '1.' and '1.e5'
+static bool isJsonNumber(const char* p) {
+  if (*p == '-') p++;
+  if (*p == '0') {
+    p++;
+  } else if (isdigit((uint8_t)*p)) {
+    while (isdigit((uint8_t)*p)) p++;
+  } else {
+    return false;
+  }
+  if (*p == '.') {
+    p++;
+    if (!isdigit((uint8_t)*p)) return false;
+    while (isdigit((uint8_t)*p)) p++;
+  }
+  if (*p == 'e' || *p == 'E') {
+    p++;
+    if (*p == '+' || *p == '-') p++;
+    if (!isdigit((uint8_t)*p)) return false;
+    while (isdigit((uint8_t)*p)) p++;
+  }
+  return *p == '\0';
+}
+
+bool JsonStreamParser::endNumber() {
+  num[numLen] = '\0';
+  if (!isJsonNumber(num)) return fail("Bad number");
+  return endScalar(JSON_TOK_NUMBER, strtod(num, nullptr));
+}
+
+bool JsonStreamParser::startValue(char c) {
+  switch (c) {
+    case '{': return openContainer(false);
+    case '[': return openContainer(true);
+    case '"':
+      stringIsKey = false;
+      state = ST_STRING;
+      return true;
+    case 't': literal = "rue";  literalType = JSON_TOK_BOOL; literalValue = true;  state = ST_LITERAL; return true;
+    case 'f': literal = "alse"; literalType = JSON_TOK_BOOL; literalValue = false; state = ST_LITERAL; return true;
+    case 'n': literal = "ull";  literalType = JSON_TOK_NULL; literalValue = false; state = ST_LITERAL; return true;
+    default:
+      if (c == '-' || (c >= '0' && c <= '9')) {
+        num[0] = c;
+        numLen = 1;
+        state = ST_NUMBER;
+        return true;
+      }
+      return fail("Unexpected character");
+  }
+}
+
+// ============================================================================
+// STATE MACHINE — one byte at a time
+// ============================================================================
+bool JsonStreamParser::step(char c) {
+  switch (state) {
+    case ST_VALUE:
+      if (isWs(c)) return true;
+      return startValue(c);
+
+    case ST_VALUE_OR_END:
+      if (isWs(c)) return true;
+      if (c == ']') return closeContainer(true);
+      return startValue(c);
+
+    case ST_KEY_OR_END:
+      if (isWs(c)) return true;
+      if (c == '}') return closeContainer(false);
+      // fall through
+    case ST_KEY:
+      if (isWs(c)) return true;
+      if (c != '"') return fail("Expected key");
+      stringIsKey = true;
+      keyLen = 0;
+      state = ST_STRING;
+      return true;
+
+    case ST_COLON:
+      if (isWs(c)) return true;
+      if (c != ':') return fail("Expected ':'");
+      state = ST_VALUE;
+      return true;
+
+    case ST_AFTER_VALUE: {
+      if (isWs(c)) return true;
+      bool inArray = (arrayBits >> (depth - 1)) & 1;
+      if (c == ',') {
+        state = inArray ? ST_VALUE : ST_KEY;
+        return true;
+      }
+      if (c == ']' || c == '}') return closeContainer(c == ']');
+      return fail("Expected ',' or close");
+    }
+
+    case ST_STRING:
+      if (c == '\\') {
+        state = ST_STRING_ESC;
+        return true;
+      }
+      if ((uint8_t)c < 0x20) return fail("Control character in string");
+      if (c == '"') {
+        if (stringIsKey) {
+          key[keyLen] = '\0';
+          haveKey = true;
+          state = ST_COLON;
+          return true;
+        }
+        return endScalar(JSON_TOK_STRING, 0);
+      }
+      if (stringIsKey && keyLen < JSON_STREAM_KEY_LEN - 1) key[keyLen++] = c;
+      return true;
+
+    case ST_STRING_ESC:
+      if (c == 'u') {
+        hexLeft = 4;
+        state = ST_STRING_HEX;
+        return true;
+      }
+      if (!strchr("\"\\/bfnrt", c)) return fail("Bad escape");
+      // Keys keep the escaped char verbatim — schema keys never need escapes
+      if (stringIsKey && keyLen < JSON_STREAM_KEY_LEN - 1) key[keyLen++] = c;
+      state = ST_STRING;
+      return true;
+
+    case ST_STRING_HEX:
+      if (!isxdigit((unsigned char)c)) return fail("Bad unicode escape");
+      if (--hexLeft == 0) state = ST_STRING;
+      return true;
+
+    case ST_NUMBER:
+      if ((c >= '0' && c <= '9') || c == '.' || c == 'e' || c == 'E' || c == '+' || c == '-') {
+        if (numLen >= JSON_STREAM_NUM_LEN - 1) return fail("Number too long");
+        num[numLen++] = c;
+        return true;
+      }
+      if (!endNumber()) return false;
+      return step(c);  // The terminator belongs to the next token
+
+    case ST_LITERAL:
+      if (c != *literal) return fail("Bad literal");
+      literal++;
+      if (*literal == '\0') return endScalar(literalType, literalValue ? 1 : 0);
+      return true;
+
+    case ST_DONE:
+      if (isWs(c)) return true;
+      return fail("Trailing data");
+  }
+  return fail("Parser state");
+}
+
+void JsonStreamParser::reset() {
+  state = ST_VALUE;
+  depth = 0;
+  arrayBits = 0;
+  haveKey = false;
+  keyLen = 0;
+  numLen = 0;
+  literal = nullptr;
+  pos = 0;
+  err = nullptr;
+  h.error = nullptr;
+}
+
+bool JsonStreamParser::feed(const uint8_t* data, size_t len) {
+  if (err) return false;
+  for (size_t i = 0; i < len; i++, pos++) {
+    if (!step((char)data[i])) return false;
+  }
+  return true;
+}
+
+bool JsonStreamParser::finish() {
+  if (err) return false;
+  if (state == ST_NUMBER && depth == 0 && !endNumber()) return false;
+  if (state != ST_DONE) return fail(pos == 0 ? "Empty body" : "Truncated JSON");
+  return true;
+}
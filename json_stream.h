@@ -0,0 +1,92 @@
+#ifndef JSON_STREAM_H
+#define JSON_STREAM_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// STREAMING JSON VALIDATOR — SAX-style push parser
+//
+// Validates a JSON document fed in arbitrary-sized chunks (e.g. straight
+// from the HTTP body as it arrives) without ever holding the document in
+// RAM. Structure is checked by the parser; schema rules (field types,
+// ranges) live in a JsonSaxHandler that receives one event per container
+// and scalar. Memory use is fixed: a nesting stack plus a short key and
+// number buffer, regardless of document size.
+// ============================================================================
+
+#define JSON_STREAM_MAX_DEPTH   16
+#define JSON_STREAM_KEY_LEN     32    // Longer keys are truncated for the handler
+#define JSON_STREAM_NUM_LEN     32
+
+enum JsonTokenType : uint8_t {
+  JSON_TOK_STRING,
+  JSON_TOK_NUMBER,
+  JSON_TOK_BOOL,
+  JSON_TOK_NULL
+};
+
+// Schema callbacks. Return false (and set `error`) to reject the document.
+//   depth:  1 = inside the top-level container, 2 = one level deeper, ...
+//   key:    member name when the value sits in an object, else nullptr
+//   offset: byte position of the opening '{' / '[' in the stream
+class JsonSaxHandler {
+public:
+  virtual ~JsonSaxHandler() {}
+  virtual bool onStart(uint8_t depth, bool isArray, const char* key, uint32_t offset) { return true; }
+  virtual bool onEnd(uint8_t depth, bool isArray) { return true; }
+  virtual bool onScalar(uint8_t depth, const char* key, JsonTokenType type, double number) { return true; }
+  const char* error = nullptr;
+};
+
+class JsonStreamParser {
+public:
+  explicit JsonStreamParser(JsonSaxHandler& handler);
+
+  // Feed the next chunk. Returns false once the document is invalid (sticky).
+  bool feed(const uint8_t* data, size_t len);
+
+  // Call after the last chunk. True only for a complete, valid document.
+  bool finish();
+
+  // Ready the parser for a new document
+  void reset();
+
+  // Human-readable reason for the first failure (nullptr while valid)
+  const char* error() const { return err; }
+
+  // Bytes consumed so far
+  uint32_t position() const { return pos; }
+
+private:
+  enum State : uint8_t {
+    ST_VALUE, ST_VALUE_OR_END, ST_KEY, ST_KEY_OR_END, ST_COLON, ST_AFTER_VALUE,
+    ST_STRING, ST_STRING_ESC, ST_STRING_HEX, ST_NUMBER, ST_LITERAL, ST_DONE
+  };
+
+  bool step(char c);
+  bool startValue(char c);
+  bool openContainer(bool isArray);
+  bool closeContainer(bool isArray);
+  bool endScalar(JsonTokenType type, double number);
+  bool endNumber();
+  bool fail(const char* why);
+
+  JsonSaxHandler& h;
+  State state = ST_VALUE;
+  uint8_t depth = 0;
+  uint16_t arrayBits = 0;            // Bit d-1 set = container at depth d is an array
+  bool stringIsKey = false;
+  bool haveKey = false;
+  uint8_t hexLeft = 0;
+  char key[JSON_STREAM_KEY_LEN];
+  uint8_t keyLen = 0;
+  char num[JSON_STREAM_NUM_LEN];
+  uint8_t numLen = 0;
+  const char* literal = nullptr;     // Remaining chars of true/false/null
+  JsonTokenType literalType = JSON_TOK_NULL;
+  bool literalValue = false;
+  uint32_t pos = 0;
+  const char* err = nullptr;
+};
+
+#endif
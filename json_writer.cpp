@@ -0,0 +1,185 @@
+#include "json_writer.h"
+#include <math.h>
+
+// ============================================================================
+// PRINT BUFFER
+// ============================================================================
+size_t PrintBuffer::write(uint8_t c) {
+  if (len + 1 >= cap) {
+    overflow = true;
+    return 0;
+  }
+  buf[len++] = c;
+  buf[len] = '\0';
+  return 1;
+}
+
+size_t PrintBuffer::write(const uint8_t* data, size_t n) {
+  size_t room = (cap > len + 1) ? cap - len - 1 : 0;
+  if (n > room) {
+    overflow = true;
+    n = room;
+  }
+  memcpy(buf + len, data, n);
+  len += n;
+  if (cap) buf[len] = '\0';
+  return n;
+}
+
+void PrintBuffer::rewind(size_t n) {
+  if (n < len) len = n;
+  if (cap) buf[len] = '\0';
+  overflow = false;
+}
+
+// ============================================================================
+// STRUCTURE
+// ============================================================================
+void JsonWriter::separator() {
+  if (depth > JSON_WRITER_MAX_DEPTH) return;   // Untracked — already flagged
+  if (needComma & (1UL << depth)) out.print(',');
+  needComma |= (1UL << depth);
+}
+
+void JsonWriter::push() {
+  if (++depth > JSON_WRITER_MAX_DEPTH) overflow = true;
+  else needComma &= ~(1UL << depth);
+}
+
+void JsonWriter::pop() {
+  if (depth == 0) overflow = true;   // More ends than begins
+  else depth--;
+}
+
+void JsonWriter::writeKey(const char* key) {
+  separator();
+  if (key) {
+    writeString(key);
+    out.print(':');
+  }
+}
+
+JsonWriter& JsonWriter::beginObject(const char* key) {
+  writeKey(key);
+  out.print('{');
+  push();
+  return *this;
+}
+
+JsonWriter& JsonWriter::endObject() {
+  out.print('}');
+  pop();
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginArray(const char* key) {
+  writeKey(key);
+  out.print('[');
+  push();
+  return *this;
+}
+
+JsonWriter& JsonWriter::endArray() {
+  out.print(']');
+  pop();
+  return *this;
+}
+
+JsonWriter& JsonWriter::fieldNull(const char* key) {
+  writeKey(key);
+  out.print("null");
+  return *this;
+}
+
+JsonWriter& JsonWriter::rawField(const char* key) {
+  writeKey(key);
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginString(const char* key) {
+  writeKey(key);
+  out.print('"');
+  return *this;
+}
+
+JsonWriter& JsonWriter::stringPart(const char* s) {
+  if (s) writeEscaped(s);
+  return *this;
+}
+
+JsonWriter& JsonWriter::endString() {
+  out.print('"');
+  return *this;
+}
+
+// ============================================================================
+// SCALARS
+// ============================================================================
+void JsonWriter::writeEscaped(const char* s) {
+  // Copy runs of plain characters in one write; escape the rest
+  const char* run = s;
+  for (; *s; s++) {
+    uint8_t c = (uint8_t)*s;
+    if (c >= 0x20 && c != '"' && c != '\\') continue;
+    if (s > run) out.write((const uint8_t*)run, s - run);
+    switch (c) {
+      case '"':  out.print("\\\""); break;
+      case '\\': out.print("\\\\"); break;
+      case '\n': out.print("\\n");  break;
+      case '\r': out.print("\\r");  break;
+      case '\t': out.print("\\t");  break;
+      default: {
+        char esc[7];
+        snprintf(esc, sizeof(esc), "\\u%04x", c);
+        out.print(esc);
+      }
+    }
+    run = s + 1;
+  }
+  if (s > run) out.write((const uint8_t*)run, s - run);
+}
+
+void JsonWriter::writeString(const char* s) {
+  if (!s) {
+    out.print("null");
+    return;
+  }
+  out.print('"');
+  writeEscaped(s);
+  out.print('"');
+}
+
+// JSON has no NaN/Infinity — write null like ArduinoJson does
+void JsonWriter::writeDouble(double v, uint8_t decimals) {
+  if (isnan(v) || isinf(v)) {
+    out.print("null");
+    return;
+  }
+  // Print::print(double) gives up ("ovf") beyond 32 bits; whole numbers that
+  // large go through the integer path instead
+  if (fabs(v) >= 4294967040.0) {
+    writeInt((int64_t)v);
+    return;
+  }
+  out.print(v, decimals);
+}
+
+void JsonWriter::writeInt(int64_t v) {
+  if (v < 0) {
+    out.print('-');
+    writeUint((uint64_t)0 - (uint64_t)v);
+  } else {
+    writeUint((uint64_t)v);
+  }
+}
+
+void JsonWriter::writeUint(uint64_t v) {
+  char digits[21];
+  char* p = digits + sizeof(digits) - 1;
+  *p = '\0';
+  do {
+    *--p = '0' + (v % 10);
+    v /= 10;
+  } while (v);
+  out.print(p);
+}
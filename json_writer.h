@@ -0,0 +1,145 @@
+#ifndef JSON_WRITER_H
+#define JSON_WRITER_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+// ============================================================================
+// STREAMING JSON WRITER — Zero-allocation response builder
+//
+// Status and diagnostic responses used to be assembled with String += or an
+// ArduinoJson document serialized into a String. Both allocate on every
+// request, and over an all-day event the churn fragments internal RAM
+// (getMaxAllocHeap() falls while getFreeHeap() stays put). JsonWriter writes
+// tokens straight to any Print — a PrintBuffer over a stack array for small
+// replies, or the chunked HTTP response for large ones — and never touches
+// the heap.
+//
+//   char buf[256];
+//   PrintBuffer pb(buf, sizeof(buf));
+//   JsonWriter w(pb);
+//   w.beginObject().field("role", cfg.role).field("uptime_s", millis() / 1000).endObject();
+//
+// Commas and quoting are handled by the writer; strings are escaped.
+// ============================================================================
+
+#define JSON_WRITER_MAX_DEPTH     16
+#define JSON_WRITER_DECIMALS      4     // Default fractional digits for float/double
+
+// Print onto a caller-provided char buffer. Always NUL-terminated; output
+// past the end is dropped and flagged.
+class PrintBuffer : public Print {
+public:
+  PrintBuffer(char* buf, size_t cap) : buf(buf), cap(cap) { if (cap) buf[0] = '\0'; }
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* data, size_t n) override;
+  const char* c_str() const { return buf; }
+  size_t length() const { return len; }
+  bool overflowed() const { return overflow; }
+  // Drop everything after the first n bytes and clear the overflow flag,
+  // e.g. to back out a record that didn't fit
+  void rewind(size_t n);
+private:
+  char* buf;
+  size_t cap;
+  size_t len = 0;
+  bool overflow = false;
+};
+
+class JsonWriter {
+public:
+  explicit JsonWriter(Print& out) : out(out) {}
+
+  // Containers. Pass a key when opening inside an object.
+  JsonWriter& beginObject(const char* key = nullptr);
+  JsonWriter& endObject();
+  JsonWriter& beginArray(const char* key = nullptr);
+  JsonWriter& endArray();
+
+  // Object member: bools, integers of any width, floats, C strings / char
+  // arrays, String and Printable (e.g. IPAddress, written as a string).
+  // A null const char* is written as null.
+  template <typename T>
+  JsonWriter& field(const char* key, const T& v) {
+    writeKey(key);
+    writeValue(v);
+    return *this;
+  }
+  JsonWriter& field(const char* key, double v, uint8_t decimals) {
+    writeKey(key);
+    writeDouble(v, decimals);
+    return *this;
+  }
+  JsonWriter& fieldNull(const char* key);
+
+  // Object member whose value the caller then prints straight to the output:
+  // exactly one complete JSON value, e.g. a file that already holds JSON
+  JsonWriter& rawField(const char* key);
+
+  // Array element — same types as field()
+  template <typename T>
+  JsonWriter& value(const T& v) {
+    separator();
+    writeValue(v);
+    return *this;
+  }
+  JsonWriter& value(double v, uint8_t decimals) {
+    separator();
+    writeDouble(v, decimals);
+    return *this;
+  }
+
+  // Write a string value in pieces: fragments are escaped and concatenated
+  // until endString(). Lets a caller format into a small stack buffer.
+  JsonWriter& beginString(const char* key = nullptr);
+  JsonWriter& stringPart(const char* s);
+  JsonWriter& endString();
+
+  // Nesting went past JSON_WRITER_MAX_DEPTH (commas are no longer tracked
+  // there) or a container was closed that was never opened
+  bool overflowed() const { return overflow; }
+
+private:
+  void separator();
+  void push();
+  void pop();
+  void writeKey(const char* key);
+  void writeEscaped(const char* s);
+  void writeString(const char* s);
+  void writeDouble(double v, uint8_t decimals);
+  void writeInt(int64_t v);
+  void writeUint(uint64_t v);
+
+  template <typename T>
+  void writeValue(const T& v) {
+    using D = typename std::decay<T>::type;
+    if constexpr (std::is_same<D, bool>::value) {
+      out.print(v ? "true" : "false");
+    } else if constexpr (std::is_floating_point<D>::value) {
+      writeDouble(v, JSON_WRITER_DECIMALS);
+    } else if constexpr (std::is_enum<D>::value) {
+      writeInt((int64_t)v);
+    } else if constexpr (std::is_integral<D>::value && std::is_signed<D>::value) {
+      writeInt(v);
+    } else if constexpr (std::is_integral<D>::value) {
+      writeUint(v);
+    } else if constexpr (std::is_convertible<const T&, const char*>::value) {
+      writeString(v);
+    } else if constexpr (std::is_same<D, String>::value) {
+      writeString(v.c_str());
+    } else if constexpr (std::is_base_of<Printable, D>::value) {
+      out.print('"');
+      v.printTo(out);
+      out.print('"');
+    } else {
+      static_assert(sizeof(T) == 0, "JsonWriter: unsupported value type");
+    }
+  }
+
+  Print& out;
+  uint16_t depth = 0;       // Real nesting depth, even past the cap
+  uint32_t needComma = 0;   // Bit d set = container at depth d already has a member
+  bool overflow = false;
+};
+
+#endif
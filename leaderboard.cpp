@@ -0,0 +1,306 @@
+#include "leaderboard.h"
+#include "config.h"
+#include "metrics.h"
+#include "heap_track.h"
+#include <ArduinoJson.h>
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include <math.h>
+
+#define LB_MAGIC    0x4C424431  // "LBD1"
+#define LB_VERSION  1
+
+// Snapshot layout: header, then cars[carCount], then top[topCount]
+struct __attribute__((packed)) LeaderboardFileHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t carCount;
+  uint16_t topCount;
+  uint16_t recordSize;    // sizeof(CarStats) — catches struct layout changes
+  uint32_t seqBase;       // raceLogSeqBase() the snapshot was built from
+  uint32_t lastSeq;       // Last race log seq folded in
+  uint32_t crc;           // CRC32 of everything after the header
+};
+
+static CarStats cars[LB_MAX_CARS];
+static uint16_t carCount = 0;
+static TopRun top[LB_TOP_K];
+static uint16_t topCount = 0;
+static uint32_t lastSeq = 0;
+static int16_t slots[LB_HASH_SLOTS];   // -1 = empty, else index into cars[]
+static bool dirty = false;
+
+// ============================================================================
+// CAR LOOKUP — FNV-1a + linear probing, O(1) expected
+// ============================================================================
+static uint32_t hashName(const char* s) {
+  uint32_t h = 2166136261u;
+  while (*s) {
+    h ^= (uint8_t)*s++;
+    h *= 16777619u;
+  }
+  return h;
+}
+
+static int findSlot(const char* name) {
+  uint32_t i = hashName(name) & (LB_HASH_SLOTS - 1);
+  for (int probe = 0; probe < LB_HASH_SLOTS; probe++) {
+    int16_t c = slots[i];
+    if (c < 0 || strcmp(cars[c].name, name) == 0) return i;
+    i = (i + 1) & (LB_HASH_SLOTS - 1);
+  }
+  return -1;
+}
+
+static int findCar(const char* name) {
+  int s = findSlot(name);
+  return (s < 0) ? -1 : slots[s];
+}
+
+static int findOrAddCar(const char* name) {
+  int s = findSlot(name);
+  if (s < 0) return -1;
+  if (slots[s] >= 0) return slots[s];
+  if (carCount >= LB_MAX_CARS) return -1;
+
+  CarStats& c = cars[carCount];
+  memset(&c, 0, sizeof(c));
+  strncpy(c.name, name, sizeof(c.name) - 1);
+  slots[s] = carCount;
+  return carCount++;
+}
+
+static void rebuildSlots() {
+  for (int i = 0; i < LB_HASH_SLOTS; i++) slots[i] = -1;
+  for (uint16_t c = 0; c < carCount; c++) {
+    int s = findSlot(cars[c].name);
+    if (s >= 0) slots[s] = c;
+  }
+}
+
+static void resetIndex() {
+  carCount = 0;
+  topCount = 0;
+  lastSeq = 0;
+  rebuildSlots();
+}
+
+// ============================================================================
+// INCREMENTAL UPDATE
+// ============================================================================
+static void insertTop(float t, uint32_t seq, uint16_t car) {
+  if (topCount == LB_TOP_K && t >= top[LB_TOP_K - 1].time_s) return;
+  int pos = (topCount < LB_TOP_K) ? topCount++ : LB_TOP_K - 1;
+  // Shift slower runs down; ties keep the earlier run ahead
+  while (pos > 0 && top[pos - 1].time_s > t) {
+    top[pos] = top[pos - 1];
+    pos--;
+  }
+  top[pos].time_s = t;
+  top[pos].seq = seq;
+  top[pos].car = car;
+}
+
+static void foldRecord(const RaceRecord& rec) {
+  if (rec.seq > lastSeq) lastSeq = rec.seq;
+  if (rec.time_s <= 0) return;
+
+  int idx = findOrAddCar(rec.car[0] ? rec.car : "Unknown");
+  if (idx < 0) {
+    LOG.printf("[STATS] Car table full (%d) — '%s' not tracked\n", LB_MAX_CARS, rec.car);
+    return;
+  }
+  CarStats& c = cars[idx];
+
+  // Welford's online mean / variance
+  c.count++;
+  double delta = rec.time_s - c.mean_s;
+  c.mean_s += delta / c.count;
+  c.m2 += delta * (rec.time_s - c.mean_s);
+
+  if (c.best_s == 0 || rec.time_s < c.best_s) {
+    c.best_s = rec.time_s;
+    c.bestSeq = rec.seq;
+  }
+  if (rec.speed_mps > c.bestSpeed_mps) c.bestSpeed_mps = rec.speed_mps;
+  if (rec.ke > c.bestKE) c.bestKE = rec.ke;
+
+  c.last[c.lastHead] = rec.time_s;
+  c.lastHead = (c.lastHead + 1) % LB_LAST_N;
+
+  insertTop(rec.time_s, rec.seq, idx);
+  dirty = true;
+}
+
+// ============================================================================
+// PERSISTENCE
+// ============================================================================
+static uint32_t snapshotCrc() {
+  uint32_t crc = esp_rom_crc32_le(0, (const uint8_t*)cars, carCount * sizeof(CarStats));
+  return esp_rom_crc32_le(crc, (const uint8_t*)top, topCount * sizeof(TopRun));
+}
+
+static void saveSnapshot() {
+  LeaderboardFileHeader hdr;
+  hdr.magic = LB_MAGIC;
+  hdr.version = LB_VERSION;
+  hdr.carCount = carCount;
+  hdr.topCount = topCount;
+  hdr.recordSize = sizeof(CarStats);
+  hdr.seqBase = raceLogSeqBase();
+  hdr.lastSeq = lastSeq;
+  hdr.crc = snapshotCrc();
+
+  File f = LittleFS.open(LEADERBOARD_FILE, "w");
+  if (!f) {
+    LOG.println("[STATS] Failed to write leaderboard snapshot");
+    return;
+  }
+  size_t written = f.write((const uint8_t*)&hdr, sizeof(hdr));
+  written += f.write((const uint8_t*)cars, carCount * sizeof(CarStats));
+  written += f.write((const uint8_t*)top, topCount * sizeof(TopRun));
+  metricInc(MET_FS_BYTES_WRITTEN, written);
+  f.close();
+  dirty = false;
+}
+
+static bool loadSnapshot() {
+  File f = LittleFS.open(LEADERBOARD_FILE, "r");
+  if (!f) return false;
+
+  LeaderboardFileHeader hdr;
+  bool ok = f.read((uint8_t*)&hdr, sizeof(hdr)) == sizeof(hdr) &&
+            hdr.magic == LB_MAGIC && hdr.version == LB_VERSION &&
+            hdr.recordSize == sizeof(CarStats) &&
+            hdr.carCount <= LB_MAX_CARS && hdr.topCount <= LB_TOP_K &&
+            hdr.seqBase == raceLogSeqBase() && hdr.lastSeq <= raceLogLastSeq();
+  if (ok) {
+    size_t carBytes = hdr.carCount * sizeof(CarStats);
+    size_t topBytes = hdr.topCount * sizeof(TopRun);
+    ok = f.read((uint8_t*)cars, carBytes) == carBytes &&
+         f.read((uint8_t*)top, topBytes) == topBytes;
+  }
+  f.close();
+  if (!ok) return false;
+
+  carCount = hdr.carCount;
+  topCount = hdr.topCount;
+  if (snapshotCrc() != hdr.crc) {
+    resetIndex();
+    return false;
+  }
+  lastSeq = hdr.lastSeq;
+  rebuildSlots();
+  return true;
+}
+
+// ============================================================================
+// PUBLIC API
+// ============================================================================
+void leaderboardRecord(const RaceRecord& rec) {
+  foldRecord(rec);
+  if (dirty) saveSnapshot();
+}
+
+void leaderboardRebuild() {
+  unsigned long t0 = millis();
+  resetIndex();
+  raceLogForEach(0, foldRecord);
+  lastSeq = raceLogLastSeq();
+  saveSnapshot();
+  LOG.printf("[STATS] Rebuilt from race log: %u car(s), %u top run(s) in %lu ms\n",
+                carCount, topCount, millis() - t0);
+}
+
+void leaderboardInit() {
+  if (!loadSnapshot()) {
+    leaderboardRebuild();
+    return;
+  }
+  uint32_t snapSeq = lastSeq;
+  raceLogForEach(snapSeq, foldRecord);
+  if (dirty) saveSnapshot();
+  LOG.printf("[STATS] Leaderboard loaded: %u car(s), caught up seq %u → %u\n",
+                carCount, snapSeq, lastSeq);
+}
+
+static float carStdDev(const CarStats& c) {
+  return (c.count > 1) ? sqrt(c.m2 / (c.count - 1)) : 0;
+}
+
+void leaderboardWriteJson(Print& out, uint16_t k) {
+  HEAP_TAG(JSON);
+  if (k == 0) k = LB_DEFAULT_K;
+  uint16_t carLimit = (k < LB_MAX_CARS) ? k : LB_MAX_CARS;
+  uint16_t topLimit = (k < LB_TOP_K) ? k : LB_TOP_K;
+
+  // Rank cars by best time — at most LB_MAX_CARS entries, insertion sort is fine
+  uint8_t order[LB_MAX_CARS];
+  uint16_t ranked = 0;
+  for (uint16_t c = 0; c < carCount; c++) {
+    if (cars[c].best_s <= 0) continue;
+    int pos = ranked++;
+    while (pos > 0 && cars[order[pos - 1]].best_s > cars[c].best_s) {
+      order[pos] = order[pos - 1];
+      pos--;
+    }
+    order[pos] = c;
+  }
+
+  DynamicJsonDocument doc(512 + (carLimit + topLimit) * 192);
+  doc["last_seq"] = lastSeq;
+  doc["car_count"] = carCount;
+  JsonArray carArr = doc.createNestedArray("cars");
+  for (uint16_t i = 0; i < ranked && i < carLimit; i++) {
+    const CarStats& c = cars[order[i]];
+    JsonObject o = carArr.createNestedObject();
+    o["rank"] = i + 1;
+    o["name"] = c.name;
+    o["runs"] = c.count;
+    o["best"] = c.best_s;
+    o["mean"] = c.mean_s;
+    o["stddev"] = carStdDev(c);
+    o["best_speed_mps"] = c.bestSpeed_mps;
+    o["best_ke"] = c.bestKE;
+  }
+  JsonArray topArr = doc.createNestedArray("top");
+  for (uint16_t i = 0; i < topCount && i < topLimit; i++) {
+    JsonObject o = topArr.createNestedObject();
+    o["car"] = cars[top[i].car].name;
+    o["time"] = top[i].time_s;
+    o["seq"] = top[i].seq;
+  }
+  serializeJson(doc, out);
+}
+
+bool leaderboardWriteCarJson(Print& out, const char* name) {
+  HEAP_TAG(JSON);
+  int idx = findCar(name);
+  if (idx < 0) return false;
+  const CarStats& c = cars[idx];
+
+  // Rank = 1 + number of cars with a strictly better best time
+  uint16_t rank = 1;
+  for (uint16_t i = 0; i < carCount; i++) {
+    if (cars[i].best_s > 0 && cars[i].best_s < c.best_s) rank++;
+  }
+
+  StaticJsonDocument<768> doc;
+  doc["name"] = c.name;
+  doc["runs"] = c.count;
+  doc["rank"] = rank;
+  doc["best"] = c.best_s;
+  doc["best_seq"] = c.bestSeq;
+  doc["mean"] = c.mean_s;
+  doc["variance"] = (c.count > 1) ? c.m2 / (c.count - 1) : 0;
+  doc["stddev"] = carStdDev(c);
+  doc["best_speed_mps"] = c.bestSpeed_mps;
+  doc["best_ke"] = c.bestKE;
+  JsonArray last = doc.createNestedArray("last");  // Newest first
+  uint8_t n = (c.count < LB_LAST_N) ? c.count : LB_LAST_N;
+  for (uint8_t i = 0; i < n; i++) {
+    last.add(c.last[(c.lastHead + LB_LAST_N - 1 - i) % LB_LAST_N]);
+  }
+  serializeJson(doc, out);
+  return true;
+}
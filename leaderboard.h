@@ -0,0 +1,60 @@
+#ifndef LEADERBOARD_H
+#define LEADERBOARD_H
+
+#include <Arduino.h>
+#include "race_log.h"
+
+// ============================================================================
+// LEADERBOARD — Incrementally maintained per-car statistics
+//
+// Every logged race updates its car's entry in O(1): run count, best time,
+// running mean and variance (Welford), best speed / KE and the last few
+// times. A top-K list of the fastest runs overall is kept sorted on insert.
+// The index is snapshotted to /leaderboard.bin after each update and, at
+// boot, the snapshot is topped up from the race log (or rebuilt from it
+// entirely when the snapshot is missing, corrupt or for a different log).
+// ============================================================================
+
+#define LEADERBOARD_FILE   "/leaderboard.bin"
+#define LB_MAX_CARS        64      // Cars ranked; later newcomers are logged but not ranked
+#define LB_LAST_N          8       // Recent times kept per car
+#define LB_TOP_K           20      // Fastest runs kept overall
+#define LB_HASH_SLOTS      128     // Open-addressing name → car table (power of 2)
+#define LB_DEFAULT_K       10      // /api/leaderboard rows when ?k= is absent
+
+struct CarStats {
+  char name[32];
+  uint32_t count;
+  float best_s;           // 0 = no valid run yet
+  uint32_t bestSeq;       // Race log seq of the best run
+  double mean_s;          // Welford running mean
+  double m2;              // Welford sum of squared deviations
+  float bestSpeed_mps;
+  float bestKE;
+  float last[LB_LAST_N];  // Ring of recent times, lastHead = next write slot
+  uint8_t lastHead;
+};
+
+struct TopRun {
+  float time_s;
+  uint32_t seq;
+  uint16_t car;           // Index into the car table
+};
+
+// Load the snapshot and catch up from the race log. Call after raceLogInit().
+void leaderboardInit();
+
+// Fold one newly logged race into the index and persist the snapshot
+void leaderboardRecord(const RaceRecord& rec);
+
+// Discard the index and rebuild it from the whole race log (after imports/clears)
+void leaderboardRebuild();
+
+// {"last_seq":N,"cars":[... k fastest cars ...],"top":[... k fastest runs ...]}
+// Cars are capped at LB_MAX_CARS and runs at LB_TOP_K.
+void leaderboardWriteJson(Print& out, uint16_t k);
+
+// Stats for one car. Returns false (and writes nothing) if the car is unknown.
+bool leaderboardWriteCarJson(Print& out, const char* name);
+
+#endif
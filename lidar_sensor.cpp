@@ -1,21 +1,59 @@
 #include "lidar_sensor.h"
 #include "config.h"
-
-// TF-Luna uses UART (115200 baud, 9-byte frames)
-// No external library needed — just HardwareSerial
-static HardwareSerial LidarSerial(2);  // ESP32 UART2
+#include "espnow_comm.h"
+#include "json_writer.h"
+#include "live_stream.h"
+#include <atomic>
+#include <driver/uart.h>
+
+// TF-Luna uses UART (115200 baud, 9-byte frames). The ESP-IDF driver is
+// used directly for its event queue — no external library needed.
+#define LIDAR_UART            UART_NUM_2
+#define LIDAR_BAUD            115200
+#define LIDAR_BYTE_US         87      // 10 bits at 115200 baud
+#define LIDAR_UART_RX_BUF     512     // Driver ring (min is the 128-byte FIFO + 1)
+#define LIDAR_UART_EVENTS     16
 
 static bool lidarInitialized = false;
 static LidarState currentLidarState = LIDAR_NO_CAR;
 static uint16_t lastDistance = 0;
-static unsigned long lastLidarPoll = 0;
 static unsigned long carStagedSince = 0;
+static unsigned long launchedAt = 0;
 static bool autoArmSent = false;
 
-// TF-Luna frame buffer
+// TF-Luna frame buffer (lidar task only)
 static uint8_t frameBuffer[9];
 static uint8_t frameIndex = 0;
 
+static QueueHandle_t uartQueue = nullptr;
+static TaskHandle_t lidarTaskHandle = nullptr;
+
+// Frame ring — single producer (lidar task), single consumer (lidarLoop).
+// Free-running counters: the producer owns ringHead, the consumer ringTail.
+// A full ring drops the new frame; the consumer is never overtaken.
+static LidarSample ring[LIDAR_RING_SIZE];
+static std::atomic<uint32_t> ringHead{0};
+static std::atomic<uint32_t> ringTail{0};
+
+// Filter state
+static uint16_t medianWin[LIDAR_MEDIAN_WINDOW];
+static uint8_t medianCount = 0;
+static uint8_t medianPos = 0;
+static uint8_t gatedRun = 0;
+static uint64_t gatedRunStartUs = 0;
+static LidarSample lastValid = {};   // Newest frame that passed the amplitude gate
+static uint64_t launchUs = 0;        // Interpolated departure of the last launch
+
+// Each counter has one writer: the lidar task, except `gated` (lidarLoop)
+struct LidarStats {
+  uint32_t frames;
+  uint32_t badFrames;     // Checksum failures
+  uint32_t gated;         // Below lidar.min_amp or zero distance
+  uint32_t overruns;      // Frames dropped on a full ring
+  uint32_t uartOverflows; // RX FIFO / driver buffer overflows (bytes lost)
+};
+static LidarStats stats;
+
 // Forward declaration from web_server
 extern void broadcastState();
 
@@ -48,45 +86,25 @@ static bool parseTFLunaFrame(uint16_t* distanceMM, uint16_t* amplitude) {
 }
 
 // ============================================================================
-// SETUP
+// UART → RING (lidar task)
+// The TF-Luna streams continuously. The task sleeps on the driver's event
+// queue; each checksum-valid frame is pushed with the time of its final
+// byte, back-dated from the read time by the bytes that came after it.
 // ============================================================================
-void lidarSetup() {
-  if (!cfg.lidar_enabled) return;
-
-  // Initialize UART2 on configured pins
-  // TF-Luna default baud rate: 115200
-  LidarSerial.begin(115200, SERIAL_8N1, cfg.lidar_rx_pin, cfg.lidar_tx_pin);
-
-  // Brief delay for UART to stabilize
-  delay(100);
-
-  // Flush any garbage data in the buffer
-  while (LidarSerial.available()) {
-    LidarSerial.read();
+static void ringPush(const LidarSample& s) {
+  uint32_t head = ringHead.load(std::memory_order_relaxed);
+  if (head - ringTail.load(std::memory_order_acquire) >= LIDAR_RING_SIZE) {
+    stats.overruns++;
+    return;
   }
-
-  frameIndex = 0;
-  lidarInitialized = true;
-  LOG.printf("[LIDAR] TF-Luna initialized. RX=%d, TX=%d, threshold=%dmm\n",
-                cfg.lidar_rx_pin, cfg.lidar_tx_pin, cfg.lidar_threshold_mm);
+  ring[head & (LIDAR_RING_SIZE - 1)] = s;
+  ringHead.store(head + 1, std::memory_order_release);
+  stats.frames++;
 }
 
-// ============================================================================
-// MAIN LOOP - Poll at 10Hz (every 100ms)
-// TF-Luna outputs frames at ~100Hz by default, so we process available data
-// but only run the state machine at 10Hz for consistency.
-// ============================================================================
-void lidarLoop() {
-  if (!lidarInitialized) return;
-
-  // Read available UART bytes and extract frames
-  // The TF-Luna streams data continuously, so we parse as bytes arrive
-  uint16_t distMM = 0;
-  uint16_t amp = 0;
-  bool gotValidFrame = false;
-
-  while (LidarSerial.available()) {
-    uint8_t byte = LidarSerial.read();
+static void lidarParse(const uint8_t* buf, size_t len, uint64_t readUs) {
+  for (size_t i = 0; i < len; i++) {
+    uint8_t byte = buf[i];
 
     // Frame sync: look for 0x59 0x59 header
     if (frameIndex == 0) {
@@ -110,51 +128,175 @@ void lidarLoop() {
 
     if (frameIndex == 9) {
       // Full frame received — parse it
-      if (parseTFLunaFrame(&distMM, &amp)) {
-        gotValidFrame = true;
+      LidarSample s;
+      if (parseTFLunaFrame(&s.distMM, &s.amp)) {
+        s.t_us = readUs - (uint64_t)(len - 1 - i) * LIDAR_BYTE_US;
+        ringPush(s);
+      } else {
+        stats.badFrames++;
       }
       frameIndex = 0;
     }
   }
+}
+
+static void lidarTask(void*) {
+  uart_event_t ev;
+  uint8_t buf[128];
+  for (;;) {
+    if (xQueueReceive(uartQueue, &ev, portMAX_DELAY) != pdTRUE) continue;
+    switch (ev.type) {
+      case UART_DATA: {
+        size_t pending = ev.size;
+        while (pending) {
+          int n = uart_read_bytes(LIDAR_UART, buf, pending < sizeof(buf) ? pending : sizeof(buf), 0);
+          if (n <= 0) break;
+          lidarParse(buf, n, nowUs());
+          pending -= n;
+        }
+        break;
+      }
+      case UART_FIFO_OVF:
+      case UART_BUFFER_FULL:
+        // Bytes were lost — drop the rest and resync on the next header
+        uart_flush_input(LIDAR_UART);
+        xQueueReset(uartQueue);
+        frameIndex = 0;
+        stats.uartOverflows++;
+        break;
+      default:
+        break;
+    }
+  }
+}
+
+// ============================================================================
+// SETUP
+// ============================================================================
+void lidarSetup() {
+  if (!cfg.lidar_enabled) return;
+
+  // Initialize UART2 on configured pins
+  // TF-Luna default baud rate: 115200
+  uart_config_t uc;
+  memset(&uc, 0, sizeof(uc));
+  uc.baud_rate = LIDAR_BAUD;
+  uc.data_bits = UART_DATA_8_BITS;
+  uc.parity = UART_PARITY_DISABLE;
+  uc.stop_bits = UART_STOP_BITS_1;
+  uc.flow_ctrl = UART_HW_FLOWCTRL_DISABLE;
+  uc.source_clk = UART_SCLK_DEFAULT;
+  if (uart_driver_install(LIDAR_UART, LIDAR_UART_RX_BUF, 0, LIDAR_UART_EVENTS, &uartQueue, 0) != ESP_OK ||
+      uart_param_config(LIDAR_UART, &uc) != ESP_OK ||
+      uart_set_pin(LIDAR_UART, cfg.lidar_tx_pin, cfg.lidar_rx_pin,
+                   UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE) != ESP_OK) {
+    LOG.println("[LIDAR] UART driver install failed — LiDAR disabled");
+    return;
+  }
 
-  // Run state machine at 10Hz (even though frames arrive faster)
-  if (millis() - lastLidarPoll < 100) return;
-  lastLidarPoll = millis();
+  // Raise a data event once a full frame is in the FIFO, or one byte time
+  // after the line goes quiet — each frame is read ~100 us after its last
+  // byte instead of after the default 120-byte / 10-byte-idle thresholds
+  uart_set_rx_full_threshold(LIDAR_UART, 9);
+  uart_set_rx_timeout(LIDAR_UART, 1);
 
-  if (!gotValidFrame) return;
+  // No settle delay or flush: the parser syncs on the 0x59 0x59 header
+  // and checks each frame's checksum, so power-on garbage is just dropped
+  frameIndex = 0;
+  xTaskCreatePinnedToCore(lidarTask, "lidar", LIDAR_TASK_STACK, nullptr,
+                          LIDAR_TASK_PRIORITY, &lidarTaskHandle, 0);
+  lidarInitialized = true;
+  LOG.printf("[LIDAR] TF-Luna initialized. RX=%d, TX=%d, threshold=%dmm, min_amp=%d\n",
+                cfg.lidar_rx_pin, cfg.lidar_tx_pin, cfg.lidar_threshold_mm, cfg.lidar_min_amp);
+}
 
-  // Filter out unreliable readings (low signal strength)
-  // TF-Luna amp < 100 typically means edge-of-range or reflective issues
-  if (amp < 100) {
-    distMM = 9999; // Treat as no target
+// ============================================================================
+// FILTER
+// ============================================================================
+static uint16_t medianPush(uint16_t distMM) {
+  medianWin[medianPos] = distMM;
+  medianPos = (medianPos + 1) % LIDAR_MEDIAN_WINDOW;
+  if (medianCount < LIDAR_MEDIAN_WINDOW) medianCount++;
+
+  // Insertion sort of at most LIDAR_MEDIAN_WINDOW values
+  uint16_t sorted[LIDAR_MEDIAN_WINDOW];
+  for (uint8_t i = 0; i < medianCount; i++) {
+    uint16_t v = medianWin[i];
+    uint8_t j = i;
+    while (j > 0 && sorted[j - 1] > v) {
+      sorted[j] = sorted[j - 1];
+      j--;
+    }
+    sorted[j] = v;
   }
+  return sorted[medianCount / 2];
+}
+
+// Departure time: where the distance crossed the staging threshold, linearly
+// between the last valid frame and the one that launched. A dropout launch
+// has no far reading to interpolate towards — take the middle of the gap.
+static uint64_t launchCrossingUs(uint16_t distMM, uint64_t frameUs, bool dropout) {
+  uint64_t t0 = lastValid.t_us;
+  if (t0 == 0 || frameUs <= t0) return frameUs;
+  uint64_t span = frameUs - t0;
+  if (dropout) return t0 + span / 2;
+  uint16_t threshold = cfg.lidar_threshold_mm;
+  if (lastValid.distMM >= threshold) return t0;
+  return t0 + span * (threshold - lastValid.distMM) / (distMM - lastValid.distMM);
+}
 
-  // Filter out zero or obviously invalid readings
-  if (distMM == 0) {
-    distMM = 9999;
+// ============================================================================
+// STATE MACHINE - one step per frame
+//   NO_CAR   → STAGED    median < threshold
+//   STAGED   → LAUNCHED  raw reading > 3x threshold, or a dropout run
+//   STAGED   → NO_CAR    median >= threshold + hysteresis (car lifted away)
+//   LAUNCHED → NO_CAR    after LIDAR_LAUNCH_HOLD_MS, once the median clears
+// ============================================================================
+static void lidarProcessFrame(const LidarSample& s) {
+  uint16_t distMM = s.distMM;
+  uint64_t frameUs = s.t_us;
+  bool valid = true;
+
+  // Gate low-confidence readings. TF-Luna amp below ~100 typically means
+  // edge-of-range or a reflective surface; one bad frame is noise, a run
+  // of them means the target has gone.
+  if (s.amp < cfg.lidar_min_amp || distMM == 0) {
+    stats.gated++;
+    if (gatedRun == 0) gatedRunStartUs = s.t_us;
+    if (gatedRun < LIDAR_DROPOUT_FRAMES) gatedRun++;
+    if (gatedRun < LIDAR_DROPOUT_FRAMES) return;
+    distMM = LIDAR_NO_TARGET_MM;
+    frameUs = gatedRunStartUs;
+    valid = false;
+  } else {
+    gatedRun = 0;
   }
 
-  lastDistance = distMM;
+  uint16_t filtered = medianPush(distMM);
+  lastDistance = filtered;
 
-  // State machine
+  uint16_t threshold = cfg.lidar_threshold_mm;
   LidarState newState = currentLidarState;
 
   switch (currentLidarState) {
     case LIDAR_NO_CAR:
-      if (distMM < cfg.lidar_threshold_mm) {
+      if (filtered < threshold) {
         newState = LIDAR_CAR_STAGED;
         carStagedSince = millis();
         autoArmSent = false;
-        LOG.printf("[LIDAR] Car detected at %dmm\n", distMM);
+        LOG.printf("[LIDAR] Car detected at %dmm\n", filtered);
       }
       break;
 
     case LIDAR_CAR_STAGED:
-      if (distMM > cfg.lidar_threshold_mm * 3) {
-        // Car removed or launched (distance jumped way up)
+      if (distMM > threshold * 3) {
+        // Distance jumped way up in a single frame — launched (or snatched)
         newState = LIDAR_CAR_LAUNCHED;
-        LOG.printf("[LIDAR] Car launched! Distance jumped to %dmm\n", distMM);
-      } else if (distMM >= cfg.lidar_threshold_mm) {
+        launchedAt = millis();
+        launchUs = launchCrossingUs(distMM, frameUs, !valid);
+        LOG.printf("[LIDAR] Car launched! Distance jumped to %dmm, departed at %llu us\n",
+                   distMM, (unsigned long long)launchUs);
+      } else if (filtered >= threshold + LIDAR_HYSTERESIS_MM) {
         // Car slowly moved away — back to no car
         newState = LIDAR_NO_CAR;
         LOG.println("[LIDAR] Car removed");
@@ -163,12 +305,15 @@ void lidarLoop() {
 
     case LIDAR_CAR_LAUNCHED:
       // Auto-reset back to NO_CAR after sensor clears
-      if (distMM >= cfg.lidar_threshold_mm) {
+      if (millis() - launchedAt >= LIDAR_LAUNCH_HOLD_MS &&
+          filtered >= threshold + LIDAR_HYSTERESIS_MM) {
         newState = LIDAR_NO_CAR;
       }
       break;
   }
 
+  if (valid) lastValid = s;
+
   // Broadcast state changes
   if (newState != currentLidarState) {
     currentLidarState = newState;
@@ -176,6 +321,25 @@ void lidarLoop() {
   }
 }
 
+// ============================================================================
+// MAIN LOOP
+// TF-Luna outputs frames at ~100Hz by default; every one the task queued
+// is filtered and stepped through the state machine. Decisions use the
+// frame timestamps, so how late loop() gets here does not matter.
+// ============================================================================
+void lidarLoop() {
+  if (!lidarInitialized) return;
+
+  uint32_t tail = ringTail.load(std::memory_order_relaxed);
+  uint32_t head = ringHead.load(std::memory_order_acquire);
+  while (tail != head) {
+    LidarSample s = ring[tail & (LIDAR_RING_SIZE - 1)];
+    ringTail.store(++tail, std::memory_order_release);
+    lidarProcessFrame(s);
+    streamPushLidar(s.distMM, s.amp, currentLidarState);
+  }
+}
+
 // ============================================================================
 // PUBLIC ACCESSORS
 // ============================================================================
@@ -187,6 +351,10 @@ LidarState getLidarState() {
   return currentLidarState;
 }
 
+uint64_t lidarLaunchUs() {
+  return launchUs;
+}
+
 bool lidarAutoArmReady() {
   // Returns true ONCE when car has been staged for >1 second
   // Caller should send ARM_CMD when this returns true
@@ -200,3 +368,12 @@ bool lidarAutoArmReady() {
   }
   return false;
 }
+
+void lidarWriteStats(JsonWriter& w) {
+  w.field("min_amp", cfg.lidar_min_amp)
+   .field("frames", stats.frames)
+   .field("bad_frames", stats.badFrames)
+   .field("gated", stats.gated)
+   .field("ring_overruns", stats.overruns)
+   .field("uart_overflows", stats.uartOverflows);
+}
@@ -3,24 +3,64 @@
 
 #include <Arduino.h>
 
+class JsonWriter;
+
 // Car presence states detected by LiDAR
 enum LidarState { LIDAR_NO_CAR, LIDAR_CAR_STAGED, LIDAR_CAR_LAUNCHED };
 
+// ============================================================================
+// SAMPLE PIPELINE
+// A Core 0 task waits on the UART driver's event queue, parses TF-Luna
+// frames (~100 Hz) and publishes them through a lock-free single-producer
+// ring, each stamped with nowUs() of its final byte. lidarLoop() runs every
+// frame through the filter and state machine — nothing is decimated.
+//   - Frames with amp < lidar.min_amp are gated out. A single gated frame is
+//     ignored; LIDAR_DROPOUT_FRAMES in a row count as "no target".
+//   - Staging uses a running median of the last LIDAR_MEDIAN_WINDOW valid
+//     distances, with LIDAR_HYSTERESIS_MM between staging and un-staging.
+//   - Launch uses the raw frame: the first valid reading beyond 3x threshold
+//     (or the first frame of a dropout run) launches the car. The departure
+//     time is interpolated back to where the distance crossed the threshold.
+// ============================================================================
+#define LIDAR_RING_SIZE       64     // Frames buffered (~640 ms at 100 Hz), power of 2
+#define LIDAR_MEDIAN_WINDOW   5      // Frames in the staging median (odd)
+#define LIDAR_HYSTERESIS_MM   10     // Median must rise this far past threshold to un-stage
+#define LIDAR_DROPOUT_FRAMES  3      // Consecutive gated frames that mean "no target"
+#define LIDAR_LAUNCH_HOLD_MS  100    // LAUNCHED shown at least this long before NO_CAR
+#define LIDAR_NO_TARGET_MM    9999
+#define LIDAR_TASK_STACK      3072
+#define LIDAR_TASK_PRIORITY   3      // Above audio: frame stamps are taken here
+
+struct LidarSample {
+  uint64_t t_us;        // nowUs() when the frame's last byte arrived
+  uint16_t distMM;      // 0 = checksum-valid frame with no distance
+  uint16_t amp;
+};
+
 // Initialize Benewake TF-Luna LiDAR on UART. No-op if LiDAR not enabled in config.
 void lidarSetup();
 
-// Poll sensor and update state machine. Non-blocking (10Hz via millis timer).
-// Broadcasts state changes to WebSocket clients.
+// Run each frame the LiDAR task queued through the filter and state
+// machine. Non-blocking. Broadcasts state changes to WebSocket clients.
 void lidarLoop();
 
-// Get raw distance reading in millimeters (0 = no reading).
+// Median-filtered distance in millimeters (0 = no reading yet,
+// LIDAR_NO_TARGET_MM = nothing in range).
 uint16_t getDistanceMM();
 
 // Get current LiDAR state.
 LidarState getLidarState();
 
+// nowUs() at which the last launched car left: the staging-threshold
+// crossing, interpolated between the frames either side (0 = none yet)
+uint64_t lidarLaunchUs();
+
 // Returns true ONCE when car has been staged for >1 second (for auto-arm).
 // Safe to call even if LiDAR is disabled — returns false.
 bool lidarAutoArmReady();
 
+// Write frame counters (frames, checksum errors, gated, ring overruns,
+// UART overflows) into an open JSON object (fields only).
+void lidarWriteStats(JsonWriter& w);
+
 #endif
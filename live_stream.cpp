@@ -0,0 +1,207 @@
+#include "live_stream.h"
+#include "config.h"
+#include "web_server.h"
+#include "espnow_comm.h"
+#include "metrics.h"
+
+volatile uint8_t streamTopicMask = 0;
+
+// Per-client topic bitmask, indexed by WebSocket client number
+static uint8_t clientTopics[WEBSOCKETS_SERVER_CLIENT_MAX] = {0};
+
+static const char* const TOPIC_NAMES[STREAM_TOPIC_COUNT] = {"lidar", "sensors", "sync", "log"};
+
+// The log topic is read straight from the SerialTee ring, not batched here
+static const uint8_t TOPIC_SAMPLE_SIZE[STREAM_TOPIC_COUNT] = {
+  sizeof(LidarStreamSample), sizeof(SensorStreamSample), sizeof(SyncStreamSample), 0
+};
+
+#define STREAM_MAX_SAMPLE_SIZE sizeof(SyncStreamSample)
+
+// One pending batch per topic. Producers append under streamMux (the sync
+// producer runs in the ESP-NOW callback on Core 0); streamLoop() copies the
+// batch out under the lock and sends it from Core 1.
+struct StreamBatch {
+  uint8_t data[STREAM_BATCH_SAMPLES * STREAM_MAX_SAMPLE_SIZE];
+  uint16_t count;
+  uint32_t seq;
+  unsigned long firstSampleMs;
+};
+
+static StreamBatch batches[STREAM_TOPIC_COUNT];
+static portMUX_TYPE streamMux = portMUX_INITIALIZER_UNLOCKED;
+static unsigned long lastSensorSample = 0;
+static uint32_t logCursor = 0;          // Next SerialTee byte seq to stream
+static unsigned long lastLogFlush = 0;
+
+// ============================================================================
+// SUBSCRIPTIONS
+// ============================================================================
+static void recomputeTopicMask() {
+  uint8_t mask = 0;
+  for (int i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+    mask |= clientTopics[i];
+  }
+  streamTopicMask = mask;
+}
+
+StreamTopic streamTopicFromName(const char* name) {
+  if (!name) return STREAM_TOPIC_COUNT;
+  for (uint8_t i = 0; i < STREAM_TOPIC_COUNT; i++) {
+    if (strcmp(name, TOPIC_NAMES[i]) == 0) return (StreamTopic)i;
+  }
+  return STREAM_TOPIC_COUNT;
+}
+
+const char* streamTopicName(StreamTopic topic) {
+  return (topic < STREAM_TOPIC_COUNT) ? TOPIC_NAMES[topic] : "";
+}
+
+bool streamSubscribe(uint8_t clientNum, StreamTopic topic) {
+  if (clientNum >= WEBSOCKETS_SERVER_CLIENT_MAX || topic >= STREAM_TOPIC_COUNT) return false;
+  bool wasIdle = !streamWanted(topic);
+  clientTopics[clientNum] |= (1 << topic);
+  if (wasIdle) {
+    // First subscriber — start from an empty batch so stale samples never leak out
+    portENTER_CRITICAL(&streamMux);
+    batches[topic].count = 0;
+    portEXIT_CRITICAL(&streamMux);
+    // Log subscribers fetch the backlog over HTTP; the stream carries only new lines
+    if (topic == STREAM_LOG) logCursor = serialTee.nextSeq();
+  }
+  recomputeTopicMask();
+  LOG.printf("[WEB] WS client %u subscribed to '%s' stream\n", clientNum, TOPIC_NAMES[topic]);
+  return true;
+}
+
+void streamUnsubscribe(uint8_t clientNum, StreamTopic topic) {
+  if (clientNum >= WEBSOCKETS_SERVER_CLIENT_MAX || topic >= STREAM_TOPIC_COUNT) return;
+  clientTopics[clientNum] &= ~(1 << topic);
+  recomputeTopicMask();
+}
+
+void streamClientGone(uint8_t clientNum) {
+  if (clientNum >= WEBSOCKETS_SERVER_CLIENT_MAX) return;
+  clientTopics[clientNum] = 0;
+  recomputeTopicMask();
+}
+
+// ============================================================================
+// PRODUCERS
+// ============================================================================
+static void pushSample(StreamTopic topic, const void* sample) {
+  StreamBatch& b = batches[topic];
+  uint8_t size = TOPIC_SAMPLE_SIZE[topic];
+  portENTER_CRITICAL(&streamMux);
+  if (b.count < STREAM_BATCH_SAMPLES) {
+    if (b.count == 0) b.firstSampleMs = millis();
+    memcpy(b.data + (size_t)b.count * size, sample, size);
+    b.count++;
+  }
+  // Batch full and not yet flushed: drop the sample. streamLoop() flushes
+  // full batches immediately, so this only happens if loop() stalls.
+  portEXIT_CRITICAL(&streamMux);
+}
+
+void streamPushLidar(uint16_t distanceMM, uint16_t amplitude, uint8_t state) {
+  if (!streamWanted(STREAM_LIDAR)) return;
+  LidarStreamSample s;
+  s.t_ms = millis();
+  s.distance_mm = distanceMM;
+  s.amplitude = amplitude;
+  s.state = state;
+  pushSample(STREAM_LIDAR, &s);
+}
+
+void streamPushSync(int64_t offsetUs, int64_t driftUs) {
+  if (!streamWanted(STREAM_SYNC)) return;
+  SyncStreamSample s;
+  s.t_ms = millis();
+  s.offset_us = offsetUs;
+  if (driftUs > INT32_MAX) driftUs = INT32_MAX;
+  if (driftUs < INT32_MIN) driftUs = INT32_MIN;
+  s.drift_us = (int32_t)driftUs;
+  pushSample(STREAM_SYNC, &s);
+}
+
+// ============================================================================
+// FLUSH
+// ============================================================================
+static void flushTopic(StreamTopic topic) {
+  uint8_t frame[sizeof(StreamFrameHeader) + sizeof(batches[0].data)];
+  StreamFrameHeader* hdr = (StreamFrameHeader*)frame;
+  size_t payloadLen;
+
+  portENTER_CRITICAL(&streamMux);
+  StreamBatch& b = batches[topic];
+  payloadLen = (size_t)b.count * TOPIC_SAMPLE_SIZE[topic];
+  memcpy(frame + sizeof(StreamFrameHeader), b.data, payloadLen);
+  hdr->magic = STREAM_FRAME_MAGIC;
+  hdr->topic = topic;
+  hdr->count = b.count;
+  hdr->seq = b.seq++;
+  b.count = 0;
+  portEXIT_CRITICAL(&streamMux);
+
+  size_t frameLen = sizeof(StreamFrameHeader) + payloadLen;
+  for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+    if (clientTopics[i] & (1 << topic)) {
+      if (webSocket.sendBIN(i, frame, frameLen)) metricInc(MET_WS_FRAMES_SENT);
+    }
+  }
+}
+
+// Send log records published since the last frame, formatted as text.
+// Frames always hold whole records.
+static void flushLog() {
+  uint8_t frame[sizeof(StreamFrameHeader) + STREAM_LOG_MAX_BYTES];
+  lastLogFlush = millis();
+  uint16_t records = 0;
+  size_t n = serialTee.format(logCursor, (char*)frame + sizeof(StreamFrameHeader),
+                              STREAM_LOG_MAX_BYTES, &records);
+  if (records == 0) return;
+
+  StreamFrameHeader* hdr = (StreamFrameHeader*)frame;
+  hdr->magic = STREAM_FRAME_MAGIC;
+  hdr->topic = STREAM_LOG;
+  hdr->count = records;
+  hdr->seq = logCursor - records;
+
+  for (uint8_t i = 0; i < WEBSOCKETS_SERVER_CLIENT_MAX; i++) {
+    if (clientTopics[i] & (1 << STREAM_LOG)) {
+      if (webSocket.sendBIN(i, frame, sizeof(StreamFrameHeader) + n)) metricInc(MET_WS_FRAMES_SENT);
+    }
+  }
+}
+
+void streamLoop() {
+  if (streamTopicMask == 0) return;
+
+  unsigned long now = millis();
+
+  if (streamWanted(STREAM_LOG) && serialTee.nextSeq() != logCursor &&
+      now - lastLogFlush >= STREAM_FLUSH_MS) {
+    flushLog();
+  }
+
+  // Beam / prox levels — polled rather than interrupt-driven so the stream
+  // never touches the timing ISRs.
+  if (streamWanted(STREAM_SENSORS) && now - lastSensorSample >= STREAM_SENSOR_SAMPLE_MS) {
+    lastSensorSample = now;
+    SensorStreamSample s;
+    s.t_ms = now;
+    s.levels = (digitalRead(cfg.sensor_pin) ? 0x01 : 0) |
+               (digitalRead(cfg.sensor_pin_2) ? 0x02 : 0);
+    s.raceState = (uint8_t)raceState;
+    pushSample(STREAM_SENSORS, &s);
+  }
+
+  for (uint8_t t = 0; t < STREAM_TOPIC_COUNT; t++) {
+    if (t == STREAM_LOG || !streamWanted((StreamTopic)t)) continue;
+    const StreamBatch& b = batches[t];
+    if (b.count == 0) continue;
+    if (b.count >= STREAM_BATCH_SAMPLES || now - b.firstSampleMs >= STREAM_FLUSH_MS) {
+      flushTopic((StreamTopic)t);
+    }
+  }
+}
@@ -0,0 +1,88 @@
+#ifndef LIVE_STREAM_H
+#define LIVE_STREAM_H
+
+#include <Arduino.h>
+
+// ============================================================================
+// LIVE STREAMS — Topic-subscribed binary WebSocket frames (port 81)
+//
+// The JSON state broadcast only fires on state changes, which is too coarse
+// for tuning a LiDAR threshold or watching clock drift. Clients opt in per
+// topic with {"cmd":"subscribe","topic":"lidar"} and receive batched binary
+// frames at up to 100 Hz sample rate. Nothing is sampled, buffered or sent
+// for a topic unless at least one connected client is subscribed to it.
+//
+// Frame layout (little-endian):
+//   StreamFrameHeader (8 bytes) followed by `count` samples of the topic's
+//   sample struct. `seq` increments per frame per topic, so a gap means the
+//   client missed a frame.
+//
+//   The "log" topic is the exception: `count` log records follow as
+//   formatted text (running to the end of the frame) and `seq` is the
+//   record seq of the first one — the same cursor /api/log?since= takes.
+// ============================================================================
+
+enum StreamTopic : uint8_t {
+  STREAM_LIDAR   = 0,   // Every TF-Luna frame: distance, amplitude
+  STREAM_SENSORS = 1,   // Beam / prox sensor levels sampled at 100 Hz
+  STREAM_SYNC    = 2,   // Clock sync results: offset, drift
+  STREAM_LOG     = 3,   // New serial log output (text)
+  STREAM_TOPIC_COUNT
+};
+
+#define STREAM_FRAME_MAGIC 0xB5
+
+struct __attribute__((packed)) StreamFrameHeader {
+  uint8_t  magic;       // STREAM_FRAME_MAGIC
+  uint8_t  topic;       // StreamTopic
+  uint16_t count;       // Samples following the header
+  uint32_t seq;         // Per-topic frame counter
+};  // 8 bytes
+
+struct __attribute__((packed)) LidarStreamSample {
+  uint32_t t_ms;        // millis() when the frame was parsed
+  uint16_t distance_mm; // Raw distance (before amplitude filtering)
+  uint16_t amplitude;   // TF-Luna signal strength
+  uint8_t  state;       // LidarState at the time of the sample
+};  // 9 bytes
+
+struct __attribute__((packed)) SensorStreamSample {
+  uint32_t t_ms;        // millis() at sample time
+  uint8_t  levels;      // Bit 0 = sensor_pin, bit 1 = sensor_pin_2 (1 = HIGH / clear)
+  uint8_t  raceState;   // RaceState enum value
+};  // 6 bytes
+
+struct __attribute__((packed)) SyncStreamSample {
+  uint32_t t_ms;        // millis() when the MSG_OFFSET reply was processed
+  int64_t  offset_us;   // start_gate_clock - finish_gate_clock
+  int32_t  drift_us;    // Change since the previous sync
+};  // 16 bytes
+
+// Bitmask of topics with at least one subscriber. Producers check this
+// before doing any work, so an unsubscribed topic costs one load + branch.
+extern volatile uint8_t streamTopicMask;
+
+inline bool streamWanted(StreamTopic topic) {
+  return (streamTopicMask & (1 << topic)) != 0;
+}
+
+// Map a topic name ("lidar", "sensors", "sync", "log") to its id. Returns
+// STREAM_TOPIC_COUNT for unknown names.
+StreamTopic streamTopicFromName(const char* name);
+
+// Name of a topic id, "" for an invalid one
+const char* streamTopicName(StreamTopic topic);
+
+// Subscription management — called from the WebSocket event handler.
+bool streamSubscribe(uint8_t clientNum, StreamTopic topic);
+void streamUnsubscribe(uint8_t clientNum, StreamTopic topic);
+void streamClientGone(uint8_t clientNum);
+
+// Producers. Safe to call from either core; no-ops when unsubscribed.
+void streamPushLidar(uint16_t distanceMM, uint16_t amplitude, uint8_t state);
+void streamPushSync(int64_t offsetUs, int64_t driftUs);
+
+// Sample periodic topics and flush due batches. Call from loop().
+void streamLoop();
+
+#endif
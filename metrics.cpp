@@ -0,0 +1,215 @@
+#include "metrics.h"
+#include "config.h"
+#include "storage.h"
+#include <LittleFS.h>
+
+std::atomic<uint32_t> metricCounters[MET_COUNTER_COUNT];
+
+struct CounterDef {
+  const char* name;
+  const char* help;
+};
+
+// Indexed by MetricId
+static const CounterDef COUNTER_DEFS[MET_COUNTER_COUNT] = {
+  {"mass_trap_races_completed_total",      "Races finalized by the finish gate"},
+  {"mass_trap_timing_errors_total",        "Races rejected for an impossible elapsed time"},
+  {"mass_trap_telemetry_chunks_lost_total", "Telemetry chunks missing or for a stale run"},
+  {"mass_trap_ws_frames_sent_total",       "WebSocket frames sent to clients"},
+  {"mass_trap_fs_bytes_written_total",     "Bytes written to LittleFS"},
+  {"mass_trap_espnow_rx_total",            "ESP-NOW messages received"},
+  {"mass_trap_clock_syncs_total",          "Clock sync replies processed"},
+};
+
+// ============================================================================
+// ESP-NOW TX — per destination MAC, filled in from the send callback
+// ============================================================================
+struct PeerTxCounters {
+  uint8_t mac[6];
+  std::atomic<uint32_t> ok;
+  std::atomic<uint32_t> fail;
+};
+
+static PeerTxCounters peerTx[METRIC_MAX_PEERS];
+static std::atomic<uint8_t> peerTxCount{0};
+static portMUX_TYPE peerTxMux = portMUX_INITIALIZER_UNLOCKED;
+static std::atomic<uint32_t> peerTxOverflow{0};   // Sends to MACs past the table
+
+void metricsEspNowSent(const uint8_t* mac, bool ok) {
+  if (!mac) return;
+  uint8_t n = peerTxCount.load(std::memory_order_acquire);
+  int idx = -1;
+  for (uint8_t i = 0; i < n; i++) {
+    if (memcmp(peerTx[i].mac, mac, 6) == 0) { idx = i; break; }
+  }
+  if (idx < 0) {
+    // New destination — claim a slot (re-check under the lock)
+    portENTER_CRITICAL(&peerTxMux);
+    n = peerTxCount.load(std::memory_order_relaxed);
+    for (uint8_t i = 0; i < n; i++) {
+      if (memcmp(peerTx[i].mac, mac, 6) == 0) { idx = i; break; }
+    }
+    if (idx < 0 && n < METRIC_MAX_PEERS) {
+      idx = n;
+      memcpy(peerTx[idx].mac, mac, 6);
+      peerTxCount.store(n + 1, std::memory_order_release);
+    }
+    portEXIT_CRITICAL(&peerTxMux);
+  }
+  if (idx < 0) {
+    peerTxOverflow.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  (ok ? peerTx[idx].ok : peerTx[idx].fail).fetch_add(1, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// CLOCK SYNC — last drift and a smoothed jitter (EWMA of |drift|, 1/8 weight)
+// ============================================================================
+static std::atomic<int32_t> lastDrift_us{0};
+static std::atomic<int32_t> syncJitter_us{0};
+
+void metricsClockSync(int32_t drift_us) {
+  metricInc(MET_CLOCK_SYNCS);
+  lastDrift_us.store(drift_us, std::memory_order_relaxed);
+  int32_t mag = drift_us < 0 ? -drift_us : drift_us;
+  int32_t j = syncJitter_us.load(std::memory_order_relaxed);
+  syncJitter_us.store(j + (mag - j) / 8, std::memory_order_relaxed);
+}
+
+// ============================================================================
+// HTTP REQUESTS BY ROUTE
+// ============================================================================
+struct RouteCounter {
+  char path[METRIC_ROUTE_LEN];
+  uint32_t count;
+};
+
+static RouteCounter routes[METRIC_MAX_ROUTES];
+static uint8_t routeCount = 0;
+static uint32_t routeOther = 0;
+static uint32_t routeNotFound = 0;
+
+void metricsCountRequest(const char* route) {
+  for (uint8_t i = 0; i < routeCount; i++) {
+    if (strcmp(routes[i].path, route) == 0) {
+      routes[i].count++;
+      return;
+    }
+  }
+  if (routeCount >= METRIC_MAX_ROUTES || strlen(route) >= METRIC_ROUTE_LEN) {
+    routeOther++;
+    return;
+  }
+  strcpy(routes[routeCount].path, route);
+  routes[routeCount].count = 1;
+  routeCount++;
+}
+
+void metricsCountNotFound() {
+  routeNotFound++;
+}
+
+// ============================================================================
+// EXPOSITION — Prometheus text format 0.0.4
+// ============================================================================
+static void writeHeader(Print& out, const char* name, const char* type, const char* help) {
+  out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+static void writeGauge(Print& out, const char* name, const char* help, double value) {
+  writeHeader(out, name, "gauge", help);
+  out.printf("%s %.0f\n", name, value);
+}
+
+// Label values are hostnames and URL paths; escape the three characters
+// the format reserves
+static void writeLabel(Print& out, const char* value) {
+  out.print('"');
+  for (const char* p = value; *p; p++) {
+    if (*p == '"' || *p == '\\') out.print('\\');
+    if (*p == '\n') { out.print("\\n"); continue; }
+    out.print(*p);
+  }
+  out.print('"');
+}
+
+void metricsWrite(Print& out) {
+  // Node identity as labels on a constant 1
+  writeHeader(out, "mass_trap_info", "gauge", "Node identity");
+  out.print("mass_trap_info{role=");
+  writeLabel(out, cfg.role);
+  out.print(",hostname=");
+  writeLabel(out, cfg.hostname);
+  out.print(",firmware=\"" FIRMWARE_VERSION "\"} 1\n");
+
+  writeGauge(out, "mass_trap_uptime_seconds", "Seconds since boot", millis() / 1000);
+
+  for (int i = 0; i < MET_COUNTER_COUNT; i++) {
+    writeHeader(out, COUNTER_DEFS[i].name, "counter", COUNTER_DEFS[i].help);
+    out.printf("%s %u\n", COUNTER_DEFS[i].name,
+               metricCounters[i].load(std::memory_order_relaxed));
+  }
+
+  // ESP-NOW sends per destination, labelled with the peer hostname when known
+  writeHeader(out, "mass_trap_espnow_tx_total", "counter", "ESP-NOW sends by destination and delivery result");
+  uint8_t n = peerTxCount.load(std::memory_order_acquire);
+  for (uint8_t i = 0; i < n; i++) {
+    char mac[18];
+    snprintf(mac, sizeof(mac), "%02x:%02x:%02x:%02x:%02x:%02x",
+             peerTx[i].mac[0], peerTx[i].mac[1], peerTx[i].mac[2],
+             peerTx[i].mac[3], peerTx[i].mac[4], peerTx[i].mac[5]);
+    const char* host = (peerTx[i].mac[0] == 0xFF) ? "broadcast" : "";
+    for (int p = 0; p < peerCount && p < MAX_PEERS; p++) {
+      if (memcmp(peers[p].mac, peerTx[i].mac, 6) == 0) { host = peers[p].hostname; break; }
+    }
+    for (int r = 0; r < 2; r++) {
+      out.printf("mass_trap_espnow_tx_total{peer=\"%s\",hostname=", mac);
+      writeLabel(out, host);
+      out.printf(",result=\"%s\"} %u\n", r ? "fail" : "ok",
+                 (r ? peerTx[i].fail : peerTx[i].ok).load(std::memory_order_relaxed));
+    }
+  }
+  uint32_t overflow = peerTxOverflow.load(std::memory_order_relaxed);
+  if (overflow) {
+    out.printf("mass_trap_espnow_tx_total{peer=\"other\",hostname=\"\",result=\"any\"} %u\n", overflow);
+  }
+
+  writeHeader(out, "mass_trap_http_requests_total", "counter", "HTTP requests by path");
+  for (uint8_t i = 0; i < routeCount; i++) {
+    out.print("mass_trap_http_requests_total{route=");
+    writeLabel(out, routes[i].path);
+    out.printf("} %u\n", routes[i].count);
+  }
+  if (routeOther) out.printf("mass_trap_http_requests_total{route=\"other\"} %u\n", routeOther);
+  if (routeNotFound) {
+    out.printf("mass_trap_http_requests_total{route=\"not_found\"} %u\n", routeNotFound);
+  }
+
+  // Memory — min_free is the heap low-water mark since boot
+  writeGauge(out, "mass_trap_heap_free_bytes", "Free internal heap", ESP.getFreeHeap());
+  writeGauge(out, "mass_trap_heap_min_free_bytes", "Lowest free internal heap since boot", ESP.getMinFreeHeap());
+  writeGauge(out, "mass_trap_heap_max_alloc_bytes", "Largest allocatable heap block", ESP.getMaxAllocHeap());
+#ifdef BOARD_HAS_PSRAM
+  writeGauge(out, "mass_trap_psram_free_bytes", "Free PSRAM", ESP.getFreePsram());
+#endif
+  writeGauge(out, "mass_trap_fs_used_bytes", "LittleFS bytes in use", LittleFS.usedBytes());
+
+  // Storage task queue
+  StorageStats ss;
+  storageGetStats(ss);
+  writeGauge(out, "mass_trap_storage_queue_depth", "Write jobs waiting for the storage task", ss.depth);
+  writeGauge(out, "mass_trap_storage_queue_max", "Deepest the storage queue has been since boot", ss.depthMax);
+  writeHeader(out, "mass_trap_storage_dropped_total", "counter", "Write jobs dropped because the queue was full");
+  out.printf("mass_trap_storage_dropped_total %u\n", ss.dropped);
+  writeGauge(out, "mass_trap_storage_write_max_us", "Longest single storage job", ss.writeMax_us);
+  writeGauge(out, "mass_trap_storage_wait_max_ms", "Longest a job waited in the queue", ss.waitMax_ms);
+
+  // Clock sync
+  writeGauge(out, "mass_trap_clock_offset_us", "Start gate clock minus this node's clock", (double)clockOffset_us);
+  writeGauge(out, "mass_trap_clock_sync_drift_us", "Offset change at the last sync",
+             lastDrift_us.load(std::memory_order_relaxed));
+  writeGauge(out, "mass_trap_clock_sync_jitter_us", "Smoothed absolute sync drift",
+             syncJitter_us.load(std::memory_order_relaxed));
+  writeGauge(out, "mass_trap_espnow_peers", "Peers in the registry", peerCount);
+}
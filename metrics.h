@@ -0,0 +1,58 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "espnow_comm.h"
+
+// ============================================================================
+// METRICS — Counters for the Prometheus-style /metrics endpoint
+//
+// /api/diagnostics is a one-off snapshot; these counters run from boot so a
+// Prometheus server on the event LAN can scrape every node and graph rates.
+// Counters are a static table of std::atomic<uint32_t> bumped with a relaxed
+// fetch_add — a handful of instructions on the race path, safe from the ESP-NOW
+// callback on Core 0. Gauges that already live elsewhere (heap, clock
+// offset) are read when /metrics is scraped rather than mirrored here.
+// ============================================================================
+
+#define METRIC_MAX_PEERS    (MAX_PEERS + 1)   // Registry peers + broadcast
+#define METRIC_MAX_ROUTES   48                // Distinct HTTP paths tracked; the rest count as "other"
+#define METRIC_ROUTE_LEN    40
+
+enum MetricId : uint8_t {
+  MET_RACES_COMPLETED = 0,   // Races finalized by the finish gate (incl. dry runs)
+  MET_TIMING_ERRORS,         // Races rejected for a non-positive or > 60 s elapsed time
+  MET_TELEM_CHUNKS_LOST,     // Telemetry chunks never received or arriving for a stale run
+  MET_WS_FRAMES_SENT,        // WebSocket frames (JSON state + stream) handed to clients
+  MET_FS_BYTES_WRITTEN,      // Bytes written to LittleFS
+  MET_ESPNOW_RX,             // ESP-NOW messages received
+  MET_CLOCK_SYNCS,           // MSG_OFFSET clock sync replies processed
+  MET_COUNTER_COUNT
+};
+
+extern std::atomic<uint32_t> metricCounters[MET_COUNTER_COUNT];
+
+inline void metricInc(MetricId id, uint32_t n = 1) {
+  metricCounters[id].fetch_add(n, std::memory_order_relaxed);
+}
+
+// ESP-NOW send result for one frame (call from the send callback)
+void metricsEspNowSent(const uint8_t* mac, bool ok);
+
+// Clock sync drift (change in offset since the previous sync) — feeds the
+// last-drift and jitter gauges
+void metricsClockSync(int32_t drift_us);
+
+// Count one HTTP request against a normalized path. Loop task only. Only
+// pass paths a registered handler or an existing file serves — anything
+// else goes to metricsCountNotFound(), so clients can't use up the slots.
+void metricsCountRequest(const char* route);
+
+// Count one request that nothing served (route="not_found"). Loop task only.
+void metricsCountNotFound();
+
+// Write every metric in the Prometheus text exposition format
+void metricsWrite(Print& out);
+
+#endif
@@ -0,0 +1,112 @@
+#include "profiler.h"
+
+// ============================================================================
+// STATE
+// ============================================================================
+static const char* const SECTION_NAMES[PROF_SECTION_COUNT] = {
+  "ota", "http", "websocket", "stream", "fw_update",
+  "discovery", "audio", "lidar", "role"
+};
+
+static ProfStats sections[PROF_SECTION_COUNT];
+static ProfStats loopPeriod;
+static uint64_t loopPeriodSumSq = 0;   // us^2, for the jitter (std dev)
+static uint32_t lastTickCycles = 0;
+static bool haveLastTick = false;
+static uint32_t cyclesPerUs = 0;       // Cached — CPU clock doesn't change at runtime
+static unsigned long resetAtMs = 0;
+
+static void clearStats(ProfStats& s) {
+  memset(&s, 0, sizeof(s));
+  s.min_us = UINT32_MAX;
+}
+
+static void addSample(ProfStats& s, uint32_t us) {
+  s.count++;
+  s.total_us += us;
+  if (us < s.min_us) s.min_us = us;
+  if (us > s.max_us) s.max_us = us;
+  uint8_t b = (us == 0) ? 0 : (31 - __builtin_clz(us));
+  if (b >= PROF_HIST_BUCKETS) b = PROF_HIST_BUCKETS - 1;
+  s.hist[b]++;
+}
+
+static inline uint32_t cyclesToUs(uint32_t cycles) {
+  if (cyclesPerUs == 0) {
+    cyclesPerUs = ESP.getCpuFreqMHz();
+    if (cyclesPerUs == 0) cyclesPerUs = 240;
+  }
+  return cycles / cyclesPerUs;
+}
+
+// ============================================================================
+// RECORDING
+// ============================================================================
+// The cycle counter wraps every ~17.9 s at 240 MHz, so a single section or
+// loop pass longer than that is under-reported. Anything that slow is
+// already a watchdog problem.
+void profRecord(ProfSection section, uint32_t cycles) {
+  if (section >= PROF_SECTION_COUNT) return;
+  addSample(sections[section], cyclesToUs(cycles));
+}
+
+void profLoopTick() {
+  uint32_t now = ESP.getCycleCount();
+  if (haveLastTick) {
+    uint32_t us = cyclesToUs(now - lastTickCycles);
+    addSample(loopPeriod, us);
+    loopPeriodSumSq += (uint64_t)us * us;
+  }
+  lastTickCycles = now;
+  haveLastTick = true;
+}
+
+void profReset() {
+  for (int i = 0; i < PROF_SECTION_COUNT; i++) clearStats(sections[i]);
+  clearStats(loopPeriod);
+  loopPeriodSumSq = 0;
+  haveLastTick = false;
+  resetAtMs = millis();
+}
+
+// ============================================================================
+// REPORTING
+// ============================================================================
+// Fields of one stats object; the caller opens and closes it
+static void writeStats(JsonWriter& w, const ProfStats& s) {
+  w.field("count", s.count)
+   .field("min_us", s.count ? s.min_us : 0)
+   .field("max_us", s.max_us)
+   .field("mean_us", s.count ? (uint32_t)(s.total_us / s.count) : 0)
+   .field("total_ms", (uint32_t)(s.total_us / 1000));
+
+  // Histogram trimmed after the last non-empty bucket
+  int last = PROF_HIST_BUCKETS - 1;
+  while (last >= 0 && s.hist[last] == 0) last--;
+  w.beginArray("hist");
+  for (int b = 0; b <= last; b++) w.value(s.hist[b]);
+  w.endArray();
+}
+
+void profWrite(JsonWriter& w) {
+  w.field("enabled", (bool)PROFILER_ENABLED)
+   .field("since_ms", millis() - resetAtMs);
+
+  uint32_t jitter = 0;
+  if (loopPeriod.count > 1) {
+    double mean = (double)loopPeriod.total_us / loopPeriod.count;
+    double var = (double)loopPeriodSumSq / loopPeriod.count - mean * mean;
+    jitter = (var > 0) ? (uint32_t)sqrt(var) : 0;
+  }
+  w.beginObject("loop");
+  writeStats(w, loopPeriod);
+  w.field("jitter_us", jitter).endObject();
+
+  w.beginObject("sections");
+  for (int i = 0; i < PROF_SECTION_COUNT; i++) {
+    w.beginObject(SECTION_NAMES[i]);
+    writeStats(w, sections[i]);
+    w.endObject();
+  }
+  w.endObject();
+}
@@ -0,0 +1,80 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <Arduino.h>
+#include "json_writer.h"
+
+// ============================================================================
+// LOOP PROFILER — Cycle-counter timing of loop() sections
+//
+// Each PROF_SCOPE(section) reads the CPU cycle counter on entry and exit and
+// folds the elapsed time into that section's min/max/mean and a log2
+// histogram in microseconds. profLoopTick() at the top of loop() does the
+// same for the loop period, so a blocking call anywhere (a WLED HTTP POST,
+// a LittleFS write) shows up as a long tail in both its own section and the
+// period's jitter.
+//
+// Recording is a couple of adds and a count-leading-zeros — cheap enough to
+// leave on in production. Everything runs on the loop() task, so no locking.
+// Build with -DPROFILER_ENABLED=0 to compile the scopes out entirely.
+// ============================================================================
+
+#ifndef PROFILER_ENABLED
+#define PROFILER_ENABLED 1
+#endif
+
+// Bucket b counts samples in [2^b, 2^(b+1)) us; bucket 0 also takes < 1 us,
+// the last bucket everything from ~1 s up.
+#define PROF_HIST_BUCKETS  21
+
+enum ProfSection : uint8_t {
+  PROF_OTA = 0,        // ArduinoOTA.handle()
+  PROF_HTTP,           // server.handleClient() — includes every API handler
+  PROF_WEBSOCKET,      // webSocket.loop()
+  PROF_STREAM,         // streamLoop()
+  PROF_FW_UPDATE,      // processFirmwareUpdate()
+  PROF_DISCOVERY,      // discoveryLoop()
+  PROF_AUDIO,          // audioLoop()
+  PROF_LIDAR,          // lidarLoop()
+  PROF_ROLE,           // finishGateLoop() / startGateLoop() / speedTrapLoop()
+  PROF_SECTION_COUNT
+};
+
+struct ProfStats {
+  uint32_t count;
+  uint32_t min_us;
+  uint32_t max_us;
+  uint64_t total_us;
+  uint32_t hist[PROF_HIST_BUCKETS];
+};
+
+// Fold one sample (in CPU cycles) into a section
+void profRecord(ProfSection section, uint32_t cycles);
+
+// Call once at the top of loop() — records the time since the previous call
+void profLoopTick();
+
+// Zero all sections and the loop period. Call once from setup() too.
+void profReset();
+
+// Write "loop": {...}, "sections": {"http": {...}, ...} into an open JSON object
+void profWrite(JsonWriter& w);
+
+class ProfScope {
+public:
+  explicit ProfScope(ProfSection s) : section(s), start(ESP.getCycleCount()) {}
+  ~ProfScope() { profRecord(section, ESP.getCycleCount() - start); }
+private:
+  ProfSection section;
+  uint32_t start;
+};
+
+#if PROFILER_ENABLED
+#define PROF_SCOPE(sec)  ProfScope _profScope_##sec(PROF_##sec)
+#define PROF_LOOP_TICK() profLoopTick()
+#else
+#define PROF_SCOPE(sec)  do {} while (0)
+#define PROF_LOOP_TICK() do {} while (0)
+#endif
+
+#endif
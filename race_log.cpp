@@ -0,0 +1,404 @@
+#include "race_log.h"
+#include "config.h"
+#include "metrics.h"
+#include "heap_track.h"
+#include "json_writer.h"
+#include <LittleFS.h>
+
+// File layout:
+//   {"log":"history","seq_base":N}      <- header, seq numbering floor
+//   {"seq":N+1,"run":...,"car":...}     <- one record per line, seq first
+//   ...
+// A line without a trailing '\n' is a torn write from a power cut; it is
+// left out of the index and terminated by the next append.
+
+struct RaceLogIndexEntry {
+  uint32_t seq;
+  uint32_t offset;   // Byte position of the line's '{'
+};
+
+static RaceLogIndexEntry* logIndex = nullptr;
+static uint32_t indexCount = 0;
+static uint32_t indexCap = 0;
+static uint32_t lastSeq = 0;
+static uint32_t seqBase = 0;
+static bool needsNewline = false;   // Tail is a torn line — terminate before appending
+
+// ============================================================================
+// INDEX
+// ============================================================================
+static bool indexPush(uint32_t seq, uint32_t offset) {
+  if (indexCount >= indexCap) {
+    uint32_t newCap = indexCap ? indexCap * 2 : RACE_LOG_INDEX_INITIAL;
+    size_t bytes = newCap * sizeof(RaceLogIndexEntry);
+    void* grown = psramFound() ? ps_realloc(logIndex, bytes) : realloc(logIndex, bytes);
+    if (!grown) {
+      LOG.printf("[HISTORY] Index grow to %u entries failed\n", newCap);
+      return false;
+    }
+    logIndex = (RaceLogIndexEntry*)grown;
+    indexCap = newCap;
+  }
+  logIndex[indexCount].seq = seq;
+  logIndex[indexCount].offset = offset;
+  indexCount++;
+  return true;
+}
+
+// First index position whose seq > sinceSeq (seqs are strictly increasing)
+static uint32_t indexUpperBound(uint32_t sinceSeq) {
+  uint32_t lo = 0, hi = indexCount;
+  while (lo < hi) {
+    uint32_t mid = (lo + hi) / 2;
+    if (logIndex[mid].seq <= sinceSeq) lo = mid + 1;
+    else hi = mid;
+  }
+  return lo;
+}
+
+// Parse the leading "{"seq":N" or "{"log":...,"seq_base":N" of a line
+static void parseLinePrefix(const char* prefix, uint32_t offset) {
+  uint32_t n;
+  if (sscanf(prefix, "{\"seq\":%u", &n) == 1) {
+    if (n > lastSeq) {
+      indexPush(n, offset);
+      lastSeq = n;
+    }
+  } else {
+    const char* base = strstr(prefix, "\"seq_base\":");
+    if (base && sscanf(base + 11, "%u", &n) == 1) {
+      seqBase = n;
+      if (n > lastSeq) lastSeq = n;
+    }
+  }
+}
+
+static void buildIndex() {
+  indexCount = 0;
+  needsNewline = false;
+
+  File f = LittleFS.open(RACE_LOG_FILE, "r");
+  if (!f) return;
+
+  uint8_t buf[256];
+  char prefix[48];
+  uint8_t prefixLen = 0;
+  uint32_t pos = 0;
+  uint32_t lineStart = 0;
+  bool inLine = false;
+
+  while (f.available()) {
+    int n = f.read(buf, sizeof(buf));
+    if (n <= 0) break;
+    for (int i = 0; i < n; i++, pos++) {
+      char c = (char)buf[i];
+      if (c == '\n') {
+        if (inLine) {
+          prefix[prefixLen] = '\0';
+          parseLinePrefix(prefix, lineStart);
+        }
+        inLine = false;
+        prefixLen = 0;
+        continue;
+      }
+      if (!inLine) {
+        inLine = true;
+        lineStart = pos;
+      }
+      if (prefixLen < sizeof(prefix) - 1) prefix[prefixLen++] = c;
+    }
+  }
+  f.close();
+
+  if (inLine) {
+    LOG.printf("[HISTORY] Ignoring torn record at byte %u\n", lineStart);
+    needsNewline = true;
+  }
+}
+
+// ============================================================================
+// WRITING
+// ============================================================================
+static bool writeHeader(File& f, uint32_t base) {
+  seqBase = base;
+  return f.printf("{\"log\":\"history\",\"seq_base\":%u}\n", base) > 0;
+}
+
+// Append one JSON object as a line. Caller owns the open file.
+static bool appendLine(File& f, JsonDocument& doc, uint32_t seq) {
+  uint32_t offset = f.size();
+  if (needsNewline) {
+    f.print('\n');
+    offset++;
+    needsNewline = false;
+  }
+  size_t written = serializeJson(doc, f);
+  if (written == 0 || f.print('\n') != 1) return false;
+  indexPush(seq, offset);
+  return true;
+}
+
+bool raceLogAppend(RaceRecord& rec) {
+  HEAP_TAG(JSON);
+  bool fresh = !LittleFS.exists(RACE_LOG_FILE);
+  File f = LittleFS.open(RACE_LOG_FILE, "a");
+  if (!f) {
+    LOG.println("[HISTORY] Failed to open history log for append");
+    return false;
+  }
+  size_t before = f.size();
+  if (fresh) writeHeader(f, lastSeq);
+
+  rec.seq = lastSeq + 1;
+  if (rec.timestamp_ms == 0) rec.timestamp_ms = epochMs();
+
+  StaticJsonDocument<512> doc;
+  doc["seq"] = rec.seq;             // Must stay first — buildIndex() parses it positionally
+  doc["timestamp"] = rec.timestamp_ms;
+  doc["run"] = rec.run;
+  doc["car"] = rec.car;
+  doc["weight"] = rec.weight_g;
+  doc["time"] = rec.time_s;
+  doc["elapsed_us"] = rec.elapsed_us;
+  doc["speed_mps"] = rec.speed_mps;
+  doc["speed_mph"] = rec.speed_mph;
+  doc["scale_mph"] = rec.scale_mph;
+  doc["momentum"] = rec.momentum;
+  doc["ke"] = rec.ke;
+  if (rec.midTrack_mps > 0) {
+    doc["midTrack_mps"] = rec.midTrack_mps;
+    doc["midTrack_mph"] = rec.midTrack_mps * MPS_TO_MPH;
+  }
+  if (rec.launchValid) {
+    doc["reaction_us"] = rec.reaction_us;
+    doc["launchToBeam_us"] = rec.launchToBeam_us;
+  }
+
+  bool ok = appendLine(f, doc, rec.seq);
+  metricInc(MET_FS_BYTES_WRITTEN, f.size() - before);
+  f.close();
+  if (!ok) {
+    LOG.printf("[HISTORY] Append of seq %u failed\n", rec.seq);
+    needsNewline = true;  // Whatever made it to flash is a torn line
+    return false;
+  }
+  lastSeq = rec.seq;
+  return true;
+}
+
+// ============================================================================
+// IMPORT — rebuild the log in a temp file, then swap it in with a rename so a
+// failed or interrupted import never leaves a half-written history behind
+// ============================================================================
+static File importFile;
+static uint32_t importSeq = 0;
+static uint32_t importCount = 0;
+
+bool raceLogImportBegin() {
+  if (importFile) importFile.close();
+  importFile = LittleFS.open(RACE_LOG_TMP, "w");
+  if (!importFile) {
+    LOG.println("[HISTORY] Failed to open import temp file");
+    return false;
+  }
+  importSeq = lastSeq;
+  importCount = 0;
+  importFile.printf("{\"log\":\"history\",\"seq_base\":%u}\n", lastSeq);
+  return true;
+}
+
+bool raceLogImportEntry(JsonObjectConst entry) {
+  HEAP_TAG(JSON);
+  if (!importFile || entry.isNull()) return false;
+  DynamicJsonDocument doc(1024);
+  doc["seq"] = importSeq + 1;   // Must stay first — buildIndex() parses it positionally
+  for (JsonPairConst kv : entry) {
+    if (strcmp(kv.key().c_str(), "seq") == 0) continue;
+    doc[kv.key()] = kv.value();
+  }
+  if (measureJson(doc) > RACE_LOG_LINE_MAX) {
+    LOG.printf("[HISTORY] Import entry over %u bytes, dropped\n", RACE_LOG_LINE_MAX);
+    return true;
+  }
+  if (serializeJson(doc, importFile) == 0 || importFile.print('\n') != 1) return false;
+  importSeq++;
+  importCount++;
+  return true;
+}
+
+void raceLogImportAbort() {
+  if (importFile) importFile.close();
+  LittleFS.remove(RACE_LOG_TMP);
+}
+
+bool raceLogImportCommit() {
+  if (!importFile) return false;
+  metricInc(MET_FS_BYTES_WRITTEN, importFile.size());
+  importFile.close();
+  if (!LittleFS.rename(RACE_LOG_TMP, RACE_LOG_FILE)) {
+    LOG.println("[HISTORY] Import rename failed — log unchanged");
+    LittleFS.remove(RACE_LOG_TMP);
+    return false;
+  }
+  buildIndex();
+  LOG.printf("[HISTORY] Log replaced: %u record(s), last seq %u\n", importCount, lastSeq);
+  return true;
+}
+
+bool raceLogReplace(JsonArrayConst entries) {
+  if (!raceLogImportBegin()) return false;
+  // Input is newest-first; the log is oldest-first
+  for (int i = (int)entries.size() - 1; i >= 0; i--) {
+    JsonObjectConst entry = entries[i];
+    if (entry.isNull()) continue;
+    if (!raceLogImportEntry(entry)) {
+      raceLogImportAbort();
+      return false;
+    }
+  }
+  return raceLogImportCommit();
+}
+
+void raceLogClear() {
+  File f = LittleFS.open(RACE_LOG_FILE, "w");
+  if (f) {
+    writeHeader(f, lastSeq);
+    f.close();
+  }
+  indexCount = 0;
+  needsNewline = false;
+  LOG.printf("[HISTORY] Log cleared (seq continues after %u)\n", lastSeq);
+}
+
+// ============================================================================
+// READING
+// ============================================================================
+// Copy the line starting at `offset` to out (without the newline)
+static void copyLine(File& f, uint32_t offset, Print& out) {
+  f.seek(offset);
+  uint8_t buf[128];
+  while (f.available()) {
+    int n = f.read(buf, sizeof(buf));
+    if (n <= 0) return;
+    for (int i = 0; i < n; i++) {
+      if (buf[i] == '\n') {
+        out.write(buf, i);
+        return;
+      }
+    }
+    out.write(buf, n);
+  }
+}
+
+bool raceLogWriteBatch(PrintBuffer& out, RaceLogCursor& cur) {
+  uint32_t lo = indexUpperBound(cur.after);
+  uint32_t hi = indexUpperBound(cur.upTo);
+  if (lo >= hi || cur.limit == 0) return false;
+
+  File f = LittleFS.open(RACE_LOG_FILE, "r");
+  if (!f) return false;
+  while (lo < hi && cur.limit > 0) {
+    uint32_t i = cur.newestFirst ? hi - 1 : lo;
+    size_t mark = out.length();
+    if (mark > 0) out.print(',');
+    copyLine(f, logIndex[i].offset, out);
+    if (out.overflowed()) {
+      out.rewind(mark);
+      // Stop here and let the next batch start empty; a record that doesn't
+      // fit even then is skipped rather than sent cut short
+      if (mark > 0) break;
+      LOG.printf("[HISTORY] Record seq %u too long to export, skipped\n", logIndex[i].seq);
+    } else {
+      cur.limit--;
+    }
+    if (cur.newestFirst) {
+      cur.upTo = logIndex[--hi].seq - 1;
+    } else {
+      cur.after = logIndex[lo++].seq;
+    }
+  }
+  f.close();
+  return lo < hi && cur.limit > 0;
+}
+
+void raceLogForEach(uint32_t sinceSeq, RaceLogVisitor visit) {
+  HEAP_TAG(JSON);
+  uint32_t first = indexUpperBound(sinceSeq);
+  if (first >= indexCount) return;
+  File f = LittleFS.open(RACE_LOG_FILE, "r");
+  if (!f) return;
+
+  // Only the fields a RaceRecord holds — imported rows may carry notes etc.
+  StaticJsonDocument<256> filter;
+  const char* fields[] = {"seq", "run", "timestamp", "car", "weight", "time", "elapsed_us", "speed_mps",
+                          "speed_mph", "scale_mph", "momentum", "ke", "midTrack_mps",
+                          "reaction_us", "launchToBeam_us"};
+  for (const char* k : fields) filter[k] = true;
+
+  for (uint32_t i = first; i < indexCount; i++) {
+    f.seek(logIndex[i].offset);
+    StaticJsonDocument<512> doc;
+    if (deserializeJson(doc, f, DeserializationOption::Filter(filter))) continue;
+    RaceRecord rec = {};
+    rec.seq = logIndex[i].seq;
+    rec.run = doc["run"] | 0;
+    rec.timestamp_ms = doc["timestamp"] | (uint64_t)0;
+    strncpy(rec.car, doc["car"] | "Unknown", sizeof(rec.car) - 1);
+    rec.weight_g = doc["weight"] | 0.0f;
+    rec.time_s = doc["time"] | 0.0f;
+    rec.elapsed_us = doc["elapsed_us"] | 0u;   // Absent in entries written before it was added
+    rec.speed_mps = doc["speed_mps"] | 0.0f;
+    rec.speed_mph = doc["speed_mph"] | 0.0f;
+    if (rec.speed_mps == 0 && rec.speed_mph > 0) rec.speed_mps = rec.speed_mph / MPS_TO_MPH;
+    rec.scale_mph = doc["scale_mph"] | 0.0f;
+    rec.momentum = doc["momentum"] | 0.0f;
+    rec.ke = doc["ke"] | 0.0f;
+    rec.midTrack_mps = doc["midTrack_mps"] | 0.0f;
+    rec.launchValid = doc.containsKey("reaction_us");
+    rec.reaction_us = doc["reaction_us"] | 0u;
+    rec.launchToBeam_us = doc["launchToBeam_us"] | 0;
+    visit(rec);
+  }
+  f.close();
+}
+
+uint32_t raceLogSeqBase() {
+  return seqBase;
+}
+
+uint32_t raceLogLastSeq() {
+  return lastSeq;
+}
+
+uint32_t raceLogCount() {
+  return indexCount;
+}
+
+// ============================================================================
+// INIT + MIGRATION
+// ============================================================================
+static void migrateLegacyHistory() {
+  File f = LittleFS.open(RACE_LOG_LEGACY, "r");
+  if (!f) return;
+  DynamicJsonDocument doc(f.size() * 2 + 1024);
+  DeserializationError err = deserializeJson(doc, f);
+  f.close();
+  if (err || !doc.is<JsonArray>()) {
+    LOG.printf("[HISTORY] Legacy %s unreadable (%s) — left in place\n",
+                  RACE_LOG_LEGACY, err.c_str());
+    return;
+  }
+  if (raceLogReplace(doc.as<JsonArrayConst>())) {
+    LittleFS.rename(RACE_LOG_LEGACY, RACE_LOG_LEGACY ".bak");
+    LOG.printf("[HISTORY] Migrated %u entries from %s\n", importCount, RACE_LOG_LEGACY);
+  }
+}
+
+void raceLogInit() {
+  if (!LittleFS.exists(RACE_LOG_FILE) && LittleFS.exists(RACE_LOG_LEGACY)) {
+    migrateLegacyHistory();
+  }
+  buildIndex();
+  LOG.printf("[HISTORY] %u record(s) indexed, last seq %u (%s)\n",
+                indexCount, lastSeq, psramFound() ? "PSRAM index" : "heap index");
+}
@@ -0,0 +1,99 @@
+#ifndef RACE_LOG_H
+#define RACE_LOG_H
+
+#include <Arduino.h>
+#include <ArduinoJson.h>
+
+// ============================================================================
+// RACE LOG — Append-only race history owned by the finish gate
+//
+// finishGateLoop() appends one record per finalized race. Records live in
+// /history.jsonl (one JSON object per line, "seq" always first) and are
+// never rewritten on the hot path. A byte-offset index (PSRAM when present)
+// maps seq → file position so /api/history?since=<seq> seeks straight to
+// the first new row instead of re-reading the whole file.
+//
+// Sequence numbers are strictly increasing and never reused, even across
+// imports and clears, so a client's `since` cursor is always safe.
+// ============================================================================
+
+#define RACE_LOG_FILE       "/history.jsonl"
+#define RACE_LOG_TMP        "/history.jsonl.tmp"
+#define RACE_LOG_LEGACY     "/history.json"    // Pre-log whole-array format (migrated at boot)
+
+struct RaceRecord {
+  uint32_t seq;           // Assigned by raceLogAppend()
+  uint32_t run;           // totalRuns at the time of the race
+  uint64_t timestamp_ms;  // Unix epoch ms when NTP is synced, else 0
+  char car[32];
+  float weight_g;
+  float time_s;
+  uint32_t elapsed_us;    // Finish gate's elapsed time as measured, 0 on a timing error
+  float speed_mps;
+  float speed_mph;
+  float scale_mph;
+  float momentum;
+  float ke;
+  float midTrack_mps;     // 0 = no speed trap data
+  bool launchValid;       // LiDAR launch timing below was measured
+  uint32_t reaction_us;   // Arm → LiDAR departure
+  int32_t launchToBeam_us; // LiDAR departure → start beam, negative if the beam broke first
+};
+
+// Open the log, build the seq index and migrate /history.json if present.
+// Call once after LittleFS is mounted.
+void raceLogInit();
+
+// Append a race. Assigns rec.seq. Returns false if the write failed.
+bool raceLogAppend(RaceRecord& rec);
+
+// Highest seq ever assigned (0 = nothing logged yet)
+uint32_t raceLogLastSeq();
+
+// Number of records currently in the log
+uint32_t raceLogCount();
+
+// A window of seqs to page through: after < seq <= upTo, at most `limit`
+// records. Oldest-first paging raises `after`, newest-first lowers `upTo`,
+// so seqs logged (or a replace that renumbers the log) between batches
+// stay out of the export.
+struct RaceLogCursor {
+  uint32_t after;
+  uint32_t upTo;        // Usually raceLogLastSeq() when the export starts
+  uint32_t limit;
+  bool newestFirst;
+};
+
+#define RACE_LOG_LINE_MAX     1024   // Longest record line; longer imports are dropped
+#define RACE_LOG_BATCH_BYTES  2048   // Buffer for one raceLogWriteBatch() call
+
+// Copy the cursor's next records into out as comma-separated JSON objects,
+// whole records only, until the buffer is full. Advances the cursor;
+// returns false once the window is exhausted. Call under a StorageLock and
+// release it to send each batch, as with runLogWriteCsv().
+class PrintBuffer;
+bool raceLogWriteBatch(PrintBuffer& out, RaceLogCursor& cur);
+
+// Replace the log with an array of history entries (newest first, as the
+// dashboard and system snapshots store them). Entries get fresh seqs.
+bool raceLogReplace(JsonArrayConst entries);
+
+// Streaming replace: Begin, then Entry() per record OLDEST first, then
+// Commit() to atomically swap the new log in (or Abort() to discard it).
+bool raceLogImportBegin();
+bool raceLogImportEntry(JsonObjectConst entry);
+bool raceLogImportCommit();
+void raceLogImportAbort();
+
+// Drop every record. Seq numbering continues from where it was.
+void raceLogClear();
+
+// seq_base of the current log file. Changes whenever the log is replaced or
+// cleared, so derived indexes can tell their snapshot is for another log.
+uint32_t raceLogSeqBase();
+
+// Visit every record with seq > sinceSeq, oldest first (boot-time rebuilds)
+typedef void (*RaceLogVisitor)(const RaceRecord& rec);
+void raceLogForEach(uint32_t sinceSeq, RaceLogVisitor visit);
+
+#endif
@@ -0,0 +1,342 @@
+#include "run_log.h"
+#include "config.h"
+#include "metrics.h"
+#include <LittleFS.h>
+#include <esp_rom_crc.h>
+#include <unistd.h>
+
+#define RUN_LOG_MAGIC    0x314E5552   // "RUN1"
+#define RUN_LOG_VERSION  2
+#define RUN_LOG_VFS_PATH "/littlefs" RUN_LOG_FILE   // For POSIX truncate()
+#define RUN_LOG_TMP      "/runs.bin.tmp"
+#define RUN_CSV_HEADER   "Run,Car,Weight(g),Time(s),Speed(mph),Scale(mph),Momentum,KE(J),Reaction(s),LaunchToBeam(s)"
+
+struct __attribute__((packed)) RunLogHeader {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t recordSize;    // sizeof(RunRecord) — catches struct layout changes
+  uint32_t reserved;
+  uint32_t crc;           // CRC32 of the fields above
+};
+
+// Version 1 record: RunRecord without the launch timing fields
+struct __attribute__((packed)) RunRecordV1 {
+  uint8_t fields[offsetof(RunRecord, reaction_us)];
+  uint32_t crc;
+};
+static_assert(sizeof(RunRecordV1) == 80, "v1 records are 80 bytes");
+
+static uint32_t lastSeq = 0;
+static uint32_t recordCount = 0;
+static File appendFile;
+
+// ============================================================================
+// HELPERS
+// ============================================================================
+static uint32_t recordCrc(const RunRecord& r) {
+  return esp_rom_crc32_le(0, (const uint8_t*)&r, offsetof(RunRecord, crc));
+}
+
+static uint32_t headerCrc(const RunLogHeader& h) {
+  return esp_rom_crc32_le(0, (const uint8_t*)&h, offsetof(RunLogHeader, crc));
+}
+
+static bool writeHeader(File& f) {
+  RunLogHeader h = {};
+  h.magic = RUN_LOG_MAGIC;
+  h.version = RUN_LOG_VERSION;
+  h.recordSize = sizeof(RunRecord);
+  h.crc = headerCrc(h);
+  return f.write((const uint8_t*)&h, sizeof(h)) == sizeof(h);
+}
+
+static bool writeRecord(File& f, RunRecord& r) {
+  r.crc = recordCrc(r);
+  return f.write((const uint8_t*)&r, sizeof(r)) == sizeof(r);
+}
+
+// Cut the file back to `size` bytes. POSIX truncate first; if the VFS
+// doesn't support it, copy the good prefix and swap it in.
+static bool truncateLog(size_t size) {
+  if (truncate(RUN_LOG_VFS_PATH, size) == 0) return true;
+
+  File src = LittleFS.open(RUN_LOG_FILE, "r");
+  File dst = LittleFS.open(RUN_LOG_TMP, "w");
+  bool ok = src && dst;
+  uint8_t buf[256];
+  size_t left = size;
+  while (ok && left > 0) {
+    size_t n = src.read(buf, min(left, sizeof(buf)));
+    ok = n > 0 && dst.write(buf, n) == n;
+    left -= n;
+  }
+  if (src) src.close();
+  if (dst) dst.close();
+  if (!ok) {
+    LittleFS.remove(RUN_LOG_TMP);
+    return false;
+  }
+  LittleFS.remove(RUN_LOG_FILE);
+  return LittleFS.rename(RUN_LOG_TMP, RUN_LOG_FILE);
+}
+
+// "2.3456" → 2345600, digit by digit so the time doesn't take a float
+// round trip. Anything past microseconds is dropped; junk gives 0.
+static uint32_t parseSecondsUs(const char* s) {
+  uint64_t us = 0;
+  while (*s >= '0' && *s <= '9') us = us * 10 + (*s++ - '0');
+  us *= 1000000;
+  if (*s == '.') {
+    s++;
+    uint32_t scale = 100000;
+    while (*s >= '0' && *s <= '9') {
+      us += (*s++ - '0') * scale;
+      scale /= 10;
+    }
+  }
+  return us > UINT32_MAX ? 0 : (uint32_t)us;
+}
+
+// ============================================================================
+// LEGACY CSV IMPORT — one time, run numbers reassigned 1..N in file order
+// ============================================================================
+static void importLegacyCsv() {
+  File in = LittleFS.open(RUN_LOG_LEGACY_CSV, "r");
+  if (!in) return;
+  File out = LittleFS.open(RUN_LOG_FILE, "w");
+  if (!out || !writeHeader(out)) {
+    in.close();
+    if (out) out.close();
+    LOG.println("[RUNS] Failed to create " RUN_LOG_FILE " for CSV import");
+    return;
+  }
+
+  char line[160];
+  uint32_t seq = 0;
+  while (in.available()) {
+    size_t n = in.readBytesUntil('\n', line, sizeof(line) - 1);
+    line[n] = '\0';
+    RunRecord r = {};
+    unsigned int run;
+    char time_s[16];
+    float mph;
+    if (sscanf(line, "%u,%31[^,],%f,%15[^,],%f,%f,%f,%f", &run, r.car, &r.weight_g, time_s,
+               &mph, &r.scale_mph, &r.momentum, &r.ke) != 8) {
+      continue;   // Header row or a torn line
+    }
+    r.seq = ++seq;
+    r.elapsed_us = parseSecondsUs(time_s);
+    r.flags = RUN_FLAG_IMPORTED | (r.elapsed_us > 0 ? 0 : RUN_FLAG_TIMING_ERROR);
+    r.speed_mps = mph / MPS_TO_MPH;
+    writeRecord(out, r);
+  }
+  in.close();
+  out.close();
+
+  LittleFS.remove(RUN_LOG_LEGACY_KEEP);
+  LittleFS.rename(RUN_LOG_LEGACY_CSV, RUN_LOG_LEGACY_KEEP);
+  LOG.printf("[RUNS] Imported %u run(s) from " RUN_LOG_LEGACY_CSV " (kept as " RUN_LOG_LEGACY_KEEP ")\n", seq);
+}
+
+// ============================================================================
+// VERSION 1 UPGRADE — copy every verifying record into the new layout with
+// no launch timing, then swap the file in
+// ============================================================================
+static bool isV1Header(const RunLogHeader& h) {
+  return h.magic == RUN_LOG_MAGIC && h.version == 1 &&
+         h.recordSize == sizeof(RunRecordV1) && h.crc == headerCrc(h);
+}
+
+static void upgradeV1() {
+  File in = LittleFS.open(RUN_LOG_FILE, "r");
+  File out = LittleFS.open(RUN_LOG_TMP, "w");
+  bool ok = in && out && in.seek(sizeof(RunLogHeader)) && writeHeader(out);
+  uint32_t n = 0;
+  RunRecordV1 old;
+  while (ok && in.read((uint8_t*)&old, sizeof(old)) == sizeof(old)) {
+    if (old.crc != esp_rom_crc32_le(0, old.fields, sizeof(old.fields))) continue;
+    RunRecord r = {};
+    memcpy(&r, old.fields, sizeof(old.fields));
+    ok = writeRecord(out, r);
+    n++;
+  }
+  if (in) in.close();
+  if (out) out.close();
+  if (!ok) {
+    LittleFS.remove(RUN_LOG_TMP);
+    LOG.println("[RUNS] Upgrade of v1 run log failed — left as is");
+    return;
+  }
+  LittleFS.remove(RUN_LOG_FILE);
+  LittleFS.rename(RUN_LOG_TMP, RUN_LOG_FILE);
+  LOG.printf("[RUNS] Upgraded run log to v%d (%u run(s))\n", RUN_LOG_VERSION, n);
+}
+
+// ============================================================================
+// INIT + TAIL RECOVERY
+// ============================================================================
+void runLogInit() {
+  if (!LittleFS.exists(RUN_LOG_FILE) && LittleFS.exists(RUN_LOG_LEGACY_CSV)) {
+    importLegacyCsv();
+  }
+
+  File v = LittleFS.open(RUN_LOG_FILE, "r");
+  if (v) {
+    RunLogHeader h;
+    bool v1 = v.read((uint8_t*)&h, sizeof(h)) == sizeof(h) && isV1Header(h);
+    v.close();
+    if (v1) upgradeV1();
+  }
+
+  lastSeq = 0;
+  recordCount = 0;
+  File f = LittleFS.open(RUN_LOG_FILE, "r");
+  if (!f) {
+    LOG.println("[RUNS] No run log yet — numbering starts at 1");
+    return;
+  }
+  size_t size = f.size();
+
+  RunLogHeader h;
+  bool headerOk = f.read((uint8_t*)&h, sizeof(h)) == sizeof(h) &&
+                  h.magic == RUN_LOG_MAGIC && h.version == RUN_LOG_VERSION &&
+                  h.recordSize == sizeof(RunRecord) && h.crc == headerCrc(h);
+  if (!headerOk) {
+    f.close();
+    if (size == 0) return;   // Created but never written — first append adds the header
+    LittleFS.remove(RUN_LOG_FILE ".bad");
+    LittleFS.rename(RUN_LOG_FILE, RUN_LOG_FILE ".bad");
+    LOG.println("[RUNS] Run log header invalid — moved aside to " RUN_LOG_FILE ".bad, starting fresh");
+    return;
+  }
+
+  // Walk back from the last whole record to the newest one that verifies
+  uint32_t whole = (size - sizeof(h)) / sizeof(RunRecord);
+  uint32_t valid = whole;
+  RunRecord r;
+  while (valid > 0) {
+    f.seek(sizeof(h) + (valid - 1) * sizeof(RunRecord));
+    if (f.read((uint8_t*)&r, sizeof(r)) == sizeof(r) && r.crc == recordCrc(r)) {
+      lastSeq = r.seq;
+      break;
+    }
+    valid--;
+  }
+  f.close();
+  recordCount = valid;
+
+  size_t goodSize = sizeof(h) + valid * sizeof(RunRecord);
+  if (goodSize != size) {
+    bool ok = truncateLog(goodSize);
+    LOG.printf("[RUNS] Recovered tail after power loss: dropped %u byte(s)%s\n",
+               (unsigned)(size - goodSize), ok ? "" : " — TRUNCATE FAILED");
+  }
+  LOG.printf("[RUNS] Run log: %u run(s), last run #%u\n", recordCount, lastSeq);
+}
+
+// ============================================================================
+// APPEND
+// ============================================================================
+bool runLogAppend(const RaceRecord& rec, uint16_t flags) {
+  if (!appendFile) {
+    appendFile = LittleFS.open(RUN_LOG_FILE, "a");
+    if (!appendFile) {
+      LOG.println("[RUNS] Failed to open " RUN_LOG_FILE " for append");
+      return false;
+    }
+    if (appendFile.size() == 0 && !writeHeader(appendFile)) {
+      appendFile.close();
+      return false;
+    }
+  }
+
+  RunRecord r = {};
+  r.seq = rec.run;
+  r.flags = flags | (rec.midTrack_mps > 0 ? RUN_FLAG_MIDTRACK : 0);
+  r.timestamp_ms = rec.timestamp_ms;
+  r.elapsed_us = rec.elapsed_us;
+  r.weight_g = rec.weight_g;
+  r.speed_mps = rec.speed_mps;
+  r.scale_mph = rec.scale_mph;
+  r.momentum = rec.momentum;
+  r.ke = rec.ke;
+  r.midTrack_mps = rec.midTrack_mps;
+  strncpy(r.car, rec.car, sizeof(r.car) - 1);
+  if (rec.launchValid) {
+    r.flags |= RUN_FLAG_LAUNCH;
+    r.reaction_us = rec.reaction_us;
+    r.launchToBeam_us = rec.launchToBeam_us;
+  }
+
+  // One record, then fsync — a power cut loses at most this record, and
+  // runLogInit() trims it if it landed half-written
+  bool ok = writeRecord(appendFile, r);
+  appendFile.flush();
+  metricInc(MET_FS_BYTES_WRITTEN, sizeof(r));
+  if (!ok) {
+    LOG.printf("[RUNS] Append of run #%u failed\n", r.seq);
+    return false;
+  }
+  lastSeq = r.seq;
+  recordCount++;
+  return true;
+}
+
+void runLogFlush() {
+  if (appendFile) appendFile.close();
+}
+
+uint32_t runLogLastSeq() {
+  return lastSeq;
+}
+
+uint32_t runLogCount() {
+  return recordCount;
+}
+
+void runLogClear() {
+  runLogFlush();
+  LittleFS.remove(RUN_LOG_FILE);
+  lastSeq = 0;
+  recordCount = 0;
+}
+
+// ============================================================================
+// CSV EXPORT
+// ============================================================================
+bool runLogWriteCsv(Print& out, uint32_t& next) {
+  if (next == 0) {
+    out.print(RUN_CSV_HEADER "\n");
+    next = 1;   // One past the record index from here on, so 0 is the header
+    return true;
+  }
+  File f = LittleFS.open(RUN_LOG_FILE, "r");
+  if (!f) return false;
+  if (!f.seek(sizeof(RunLogHeader) + (size_t)(next - 1) * sizeof(RunRecord))) {
+    f.close();
+    return false;
+  }
+
+  RunRecord batch[RUN_CSV_BATCH];
+  size_t n = f.read((uint8_t*)batch, sizeof(batch)) / sizeof(RunRecord);
+  f.close();
+  next += n;
+
+  for (size_t i = 0; i < n; i++) {
+    const RunRecord& r = batch[i];
+    if (r.crc != recordCrc(r)) continue;
+    char car[sizeof(r.car) + 1];
+    memcpy(car, r.car, sizeof(r.car));
+    car[sizeof(r.car)] = '\0';
+    float mph = r.speed_mps * MPS_TO_MPH;
+    out.printf("%u,%s,%.1f,%.4f,%.2f,%.1f,%.4f,%.4f,", r.seq, car, r.weight_g,
+               r.elapsed_us / 1000000.0, mph, r.scale_mph, r.momentum, r.ke);
+    // Every row ends in a bare \n, like the header
+    if (r.flags & RUN_FLAG_LAUNCH) {
+      out.printf("%.4f,%.4f\n", r.reaction_us / 1000000.0, r.launchToBeam_us / 1000000.0);
+    } else {
+      out.print(",\n");
+    }
+  }
+  return n > 0;
+}
@@ -0,0 +1,84 @@
+#ifndef RUN_LOG_H
+#define RUN_LOG_H
+
+#include <Arduino.h>
+#include "race_log.h"
+
+// ============================================================================
+// RUN LOG — Fixed-size binary record of every finished run
+//
+// /runs.bin replaces the free-form /runs.csv. It is a 16-byte header
+// followed by 88-byte records, each carrying its own CRC32. Appends are a
+// single write + fsync of one record, constant time however long the log
+// gets, and run numbers continue across reboots: runLogInit() restores the
+// last seq (totalRuns) from the tail.
+//
+// Power loss can leave a partial or torn last record. At boot the tail is
+// checked back to the last record whose CRC verifies and the file is
+// truncated there. /runs.csv is now generated on request by streaming the
+// records out as CSV (runLogWriteCsv). A legacy /runs.csv is imported once
+// and kept as /runs_legacy.csv; a version 1 log (80-byte records, no launch
+// timing) is rewritten in place at boot.
+//
+// Written only by the storage task (storage.cpp), under a StorageLock.
+// ============================================================================
+
+#define RUN_LOG_FILE        "/runs.bin"
+#define RUN_LOG_LEGACY_CSV  "/runs.csv"
+#define RUN_LOG_LEGACY_KEEP "/runs_legacy.csv"
+
+// Record flags
+#define RUN_FLAG_TIMING_ERROR  0x0001   // Elapsed time was rejected (logged as 0)
+#define RUN_FLAG_MIDTRACK      0x0002   // Speed trap data present
+#define RUN_FLAG_IMPORTED      0x0004   // Migrated from the legacy CSV
+#define RUN_FLAG_LAUNCH        0x0008   // LiDAR launch timing present
+
+struct __attribute__((packed)) RunRecord {
+  uint32_t seq;            // Run number, 1-based, never reused
+  uint16_t flags;          // RUN_FLAG_*
+  uint16_t reserved;
+  uint64_t timestamp_ms;   // Unix epoch ms at the finish, 0 if NTP wasn't synced
+  uint32_t elapsed_us;     // 0 on a timing error
+  float weight_g;
+  float speed_mps;
+  float scale_mph;
+  float momentum;
+  float ke;
+  float midTrack_mps;      // 0 = no speed trap data
+  char car[32];            // Car name as entered on the dashboard
+  uint32_t reaction_us;    // Arm → LiDAR departure, 0 = not measured
+  int32_t launchToBeam_us; // LiDAR departure → start beam
+  uint32_t crc;            // CRC32 of every field above
+};
+
+static_assert(sizeof(RunRecord) == 88, "RunRecord layout changed — bump RUN_LOG_VERSION");
+
+// Validate the header, recover the tail and restore the last seq. Imports a
+// legacy /runs.csv on first boot. Call once after LittleFS is mounted.
+void runLogInit();
+
+// Append one run (rec.run is the seq). Keeps the file open until
+// runLogFlush() so a batch of appends shares one open.
+bool runLogAppend(const RaceRecord& rec, uint16_t flags);
+void runLogFlush();
+
+// Last seq written (0 = empty log) and number of records
+uint32_t runLogLastSeq();
+uint32_t runLogCount();
+
+#define RUN_CSV_BATCH    8     // Records per runLogWriteCsv() call
+#define RUN_CSV_ROW_MAX  160   // Longest CSV row (or the header), newline included
+
+// Write the classic runs.csv, oldest first, a batch per call. Start with
+// `next` at 0: the first call writes the header, each later one up to
+// RUN_CSV_BATCH records. Advances `next`; returns false once the log is
+// exhausted.
+// Records that fail their CRC are skipped. Call under a StorageLock and
+// release it between batches so a long export doesn't stall the storage
+// task behind the network.
+bool runLogWriteCsv(Print& out, uint32_t& next);
+
+// Delete the log (factory reset). Call under a StorageLock.
+void runLogClear();
+
+#endif
@@ -0,0 +1,492 @@
+#include "serial_log.h"
+#include <time.h>
+#include <sys/time.h>
+#include <pthread.h>
+
+SerialTee serialTee;
+
+// The line a task is currently assembling. One per task (thread_local), so
+// producers on different cores or tasks never interleave inside a line.
+// Allocated on the task's first log call and registered under a pthread key
+// whose destructor frees it when the task is deleted — ESP-IDF runs key
+// destructors for plain FreeRTOS tasks too, so short-lived tasks don't leak.
+struct PendingLine {
+  uint8_t len;
+  uint8_t flags;       // LOG_REC_CONT once the line's head has been published
+  uint8_t level;
+  uint8_t subsystem;
+  char text[LOG_TEXT_MAX];
+};
+
+static thread_local PendingLine* pendingLine = nullptr;
+static pthread_key_t pendingKey;
+static pthread_once_t pendingKeyOnce = PTHREAD_ONCE_INIT;
+
+static void createPendingKey() {
+  pthread_key_create(&pendingKey, free);
+}
+
+// ============================================================================
+// CLASSIFICATION — subsystem from "[TAG]", level from keywords
+// ============================================================================
+struct LogTag {
+  const char* tag;
+  uint8_t subsystem;
+};
+
+static const LogTag LOG_TAGS[] = {
+  {"BOOT", LOG_SYS_BOOT},           {"CONFIG", LOG_SYS_CONFIG},
+  {"WIFI", LOG_SYS_WIFI},           {"NTP", LOG_SYS_WIFI},
+  {"WEB", LOG_SYS_WEB},             {"ESP-NOW", LOG_SYS_ESPNOW},
+  {"ESPNOW-RX", LOG_SYS_ESPNOW},    {"DISCOVER", LOG_SYS_ESPNOW},
+  {"PEERS", LOG_SYS_PEERS},         {"FLEET", LOG_SYS_FLEET},
+  {"START", LOG_SYS_START},         {"FINISH", LOG_SYS_FINISH},
+  {"SPEEDTRAP", LOG_SYS_SPEEDTRAP}, {"TELEM", LOG_SYS_TELEM},
+  {"LIDAR", LOG_SYS_LIDAR},         {"AUDIO", LOG_SYS_AUDIO},
+  {"DY-SV5W", LOG_SYS_AUDIO},       {"WLED", LOG_SYS_WLED},
+  {"HISTORY", LOG_SYS_HISTORY},     {"STATS", LOG_SYS_STATS},
+  {"STORAGE", LOG_SYS_HISTORY},
+  {"FW-UPDATE", LOG_SYS_FW_UPDATE}, {"OTA", LOG_SYS_FW_UPDATE},
+};
+
+LogSubsystem logSubsystemFromText(const char* text, size_t len) {
+  size_t i = 0;
+  while (i < len && text[i] == ' ') i++;
+  if (i >= len || text[i] != '[') return LOG_SYS_OTHER;
+  const char* tag = text + i + 1;
+  size_t max = len - i - 1;
+  for (size_t t = 0; t < sizeof(LOG_TAGS) / sizeof(LOG_TAGS[0]); t++) {
+    size_t n = strlen(LOG_TAGS[t].tag);
+    if (n < max && memcmp(tag, LOG_TAGS[t].tag, n) == 0 && tag[n] == ']') {
+      return (LogSubsystem)LOG_TAGS[t].subsystem;
+    }
+  }
+  return LOG_SYS_OTHER;
+}
+
+static bool containsText(const char* text, size_t len, const char* word) {
+  size_t n = strlen(word);
+  for (size_t i = 0; i + n <= len; i++) {
+    if (memcmp(text + i, word, n) == 0) return true;
+  }
+  return false;
+}
+
+// Plain LOG.printf() lines carry no explicit level — infer one from the
+// same keywords the console colours by
+static uint8_t levelFromText(const char* text, size_t len) {
+  if (containsText(text, len, "ERROR") || containsText(text, len, "FAIL") ||
+      containsText(text, len, "error")) return LOG_LVL_ERROR;
+  if (containsText(text, len, "WARN") || containsText(text, len, "warn")) return LOG_LVL_WARN;
+  return LOG_LVL_INFO;
+}
+
+// ============================================================================
+// DEFERRED RECORDS — printf at read time from the packed args (LOG_DEFER)
+// ============================================================================
+#define LOG_DEFERRED_MAX  200   // Longest line a deferred record expands to
+
+struct LogArg {
+  char type;          // Packed type, 0 = missing
+  int64_t i;
+  uint64_t u;
+  double d;
+  const char* s;
+  uint8_t slen;
+};
+
+static const uint8_t* unpackArg(const uint8_t* a, const uint8_t* end, LogArg& arg) {
+  arg.type = 0;
+  if (a >= end) return a;
+  char type = (char)*a++;
+  int32_t i32;
+  uint32_t u32;
+  const void* ptr;
+  switch (type) {
+    case 'i': if (end - a < 4) return end; memcpy(&i32, a, 4); a += 4; arg.i = i32; arg.u = (uint32_t)i32; arg.d = i32; break;
+    case 'u': if (end - a < 4) return end; memcpy(&u32, a, 4); a += 4; arg.i = u32; arg.u = u32; arg.d = u32; break;
+    case 'l': if (end - a < 8) return end; memcpy(&arg.i, a, 8); a += 8; arg.u = arg.i; arg.d = arg.i; break;
+    case 'L': if (end - a < 8) return end; memcpy(&arg.u, a, 8); a += 8; arg.i = arg.u; arg.d = arg.u; break;
+    case 'd': if (end - a < 8) return end; memcpy(&arg.d, a, 8); a += 8; arg.i = arg.d; arg.u = arg.i; break;
+    case 'p': if (end - a < (int)sizeof(ptr)) return end; memcpy(&ptr, a, sizeof(ptr)); a += sizeof(ptr); arg.u = arg.i = (uintptr_t)ptr; arg.d = 0; break;
+    case 's':
+      if (a >= end) return end;
+      arg.slen = *a++;
+      if (end - a < arg.slen) return end;
+      arg.s = (const char*)a;
+      a += arg.slen;
+      break;
+    default:
+      return end;
+  }
+  arg.type = type;
+  return a;
+}
+
+// Walk the stored format, handing each conversion and its arg to snprintf.
+// Length modifiers are rewritten to match how the arg was packed, so a
+// %d / %ld / %lld mix-up at the call site can't read garbage.
+static size_t formatDeferred(const LogRecord& rec, char* out, size_t cap) {
+  if (rec.len < sizeof(const char*) || cap == 0) return 0;
+  const char* fmt;
+  memcpy(&fmt, rec.text, sizeof(fmt));
+  const uint8_t* a = (const uint8_t*)rec.text + sizeof(fmt);
+  const uint8_t* end = (const uint8_t*)rec.text + rec.len;
+
+  size_t o = 0;
+  while (*fmt && o + 1 < cap) {
+    if (*fmt != '%') {
+      if (*fmt == '\n' && fmt[1] == '\0') break;  // Records end lines themselves
+      out[o++] = *fmt++;
+      continue;
+    }
+    char spec[20];
+    size_t sl = 0;
+    spec[sl++] = *fmt++;
+    while (*fmt && strchr("-+ #0123456789.", *fmt) && sl < 12) spec[sl++] = *fmt++;
+    while (*fmt && strchr("hlLqjzt", *fmt)) fmt++;  // Dropped — re-added below
+    char conv = *fmt;
+    if (!conv) break;
+    fmt++;
+    if (conv == '%') {
+      out[o++] = '%';
+      continue;
+    }
+
+    LogArg arg;
+    a = unpackArg(a, end, arg);
+    int n;
+    if (!arg.type) {
+      n = snprintf(out + o, cap - o, "?");
+    } else if (conv == 's') {
+      char str[LOG_TEXT_MAX + 1];
+      if (arg.type == 's') {
+        memcpy(str, arg.s, arg.slen);
+        str[arg.slen] = '\0';
+      } else {
+        snprintf(str, sizeof(str), "%lld", (long long)arg.i);
+      }
+      spec[sl++] = 's';
+      spec[sl] = '\0';
+      n = snprintf(out + o, cap - o, spec, str);
+    } else if (arg.type == 's') {
+      n = snprintf(out + o, cap - o, "%.*s", arg.slen, arg.s);
+    } else if (strchr("diuxXoc", conv)) {
+      if (conv != 'c') {
+        spec[sl++] = 'l';
+        spec[sl++] = 'l';
+      }
+      spec[sl++] = conv;
+      spec[sl] = '\0';
+      if (conv == 'c') n = snprintf(out + o, cap - o, spec, (int)arg.i);
+      else if (conv == 'd' || conv == 'i') n = snprintf(out + o, cap - o, spec, (long long)arg.i);
+      else n = snprintf(out + o, cap - o, spec, (unsigned long long)arg.u);
+    } else if (strchr("feEgGaA", conv)) {
+      spec[sl++] = conv;
+      spec[sl] = '\0';
+      n = snprintf(out + o, cap - o, spec, arg.d);
+    } else if (conv == 'p') {
+      n = snprintf(out + o, cap - o, "%p", (void*)(uintptr_t)arg.u);
+    } else {
+      n = snprintf(out + o, cap - o, "?");
+    }
+    if (n > 0) o += ((size_t)n < cap - o) ? (size_t)n : cap - o - 1;
+  }
+  out[o] = '\0';
+  return o;
+}
+
+// ============================================================================
+// PRODUCERS
+// ============================================================================
+void SerialTee::publish(uint8_t level, uint8_t subsystem, uint8_t flags, const char* text, size_t len) {
+  if (len > LOG_TEXT_MAX) len = LOG_TEXT_MAX;
+  if (!slots) {
+    // No ring (before begin() or allocation failed) — straight to the UART
+    if (flags & LOG_REC_DEFERRED) {
+      LogRecord tmp;
+      tmp.len = len;
+      memcpy(tmp.text, text, len);
+      char line[LOG_DEFERRED_MAX];
+      hw->write((const uint8_t*)line, formatDeferred(tmp, line, sizeof(line)));
+    } else {
+      hw->write((const uint8_t*)text, len);
+    }
+    if (!(flags & LOG_REC_OPEN)) hw->write('\n');
+    return;
+  }
+
+  uint32_t seq = __atomic_fetch_add(&writeSeq, 1, __ATOMIC_RELAXED);
+  LogRecord& r = slots[seq & (slotCount - 1)];
+  // Mark the slot busy before touching it so a reader mid-copy sees the change
+  __atomic_store_n(&r.stamp, 0, __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  r.t_ms = millis();
+  r.level = level;
+  r.subsystem = subsystem;
+  r.flags = flags;
+  r.len = len;
+  memcpy(r.text, text, len);
+  __atomic_store_n(&r.stamp, seq + 1, __ATOMIC_RELEASE);
+}
+
+static void publishPending(SerialTee& tee, PendingLine* p, bool open) {
+  if (!(p->flags & LOG_REC_CONT)) {
+    p->subsystem = logSubsystemFromText(p->text, p->len);
+    p->level = levelFromText(p->text, p->len);
+  }
+  tee.publish(p->level, p->subsystem, p->flags | (open ? LOG_REC_OPEN : 0), p->text, p->len);
+  p->flags = open ? LOG_REC_CONT : 0;
+  p->len = 0;
+}
+
+void SerialTee::appendByte(uint8_t c) {
+  PendingLine* p = pendingLine;
+  if (!p) {
+    p = (PendingLine*)calloc(1, sizeof(PendingLine));
+    if (!p) {
+      hw->write(c);  // Out of memory — keep the UART output at least
+      return;
+    }
+    pthread_once(&pendingKeyOnce, createPendingKey);
+    pthread_setspecific(pendingKey, p);   // Frees it when the task is deleted
+    pendingLine = p;
+  }
+
+  if (c == '\r') return;
+  if (c == '\n') {
+    publishPending(*this, p, false);
+    return;
+  }
+
+  if (p->len == LOG_TEXT_MAX) {
+    // Line longer than a slot: publish what we have and continue in the next
+    // record, carrying a partial UTF-8 sequence over rather than splitting it
+    size_t keep = p->len;
+    if ((c & 0xC0) == 0x80) {
+      while (keep > 0 && (p->text[keep - 1] & 0xC0) == 0x80) keep--;
+      if (keep > 0) keep--;
+      if (p->len - keep > 3) keep = p->len;  // Not valid UTF-8 anyway
+    }
+    char carry[3];
+    size_t carryLen = p->len - keep;
+    memcpy(carry, p->text + keep, carryLen);
+    p->len = keep;
+    publishPending(*this, p, true);
+    memcpy(p->text, carry, carryLen);
+    p->len = carryLen;
+  }
+  p->text[p->len++] = (char)c;
+}
+
+size_t SerialTee::write(uint8_t c) {
+  appendByte(c);
+  return 1;
+}
+
+size_t SerialTee::write(const uint8_t* buf, size_t size) {
+  for (size_t i = 0; i < size; i++) appendByte(buf[i]);
+  return size;
+}
+
+// ============================================================================
+// READERS
+// ============================================================================
+SerialTee::ReadResult SerialTee::readRecord(uint32_t seq, LogRecord& out) const {
+  uint32_t next = nextSeq();
+  if ((int32_t)(seq - next) >= 0) return REC_PENDING;
+  if (next - seq > slotCount) return REC_LOST;
+
+  const LogRecord& r = slots[seq & (slotCount - 1)];
+  if (__atomic_load_n(&r.stamp, __ATOMIC_ACQUIRE) != seq + 1) {
+    // Ticket taken but not published yet — or a newer lap already took the slot
+    return (nextSeq() - seq > slotCount) ? REC_LOST : REC_PENDING;
+  }
+  memcpy(&out, (const void*)&r, sizeof(out));
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+  // Seqlock check: a writer that lapped us while we copied changed the stamp
+  if (__atomic_load_n(&r.stamp, __ATOMIC_RELAXED) != seq + 1) return REC_LOST;
+  return REC_READY;
+}
+
+uint32_t SerialTee::oldestSeq() const {
+  uint32_t next = nextSeq();
+  uint32_t floor = (next > slotCount) ? next - slotCount : 0;
+  return ((int32_t)(clearedSeq - floor) > 0) ? clearedSeq : floor;
+}
+
+// Wall-clock reference taken once per format() call, not per record
+struct ReadClock {
+  bool wall;
+  int64_t epochMs;
+  uint32_t nowMs;
+};
+
+static size_t formatStamp(char* out, size_t cap, uint32_t t_ms, const ReadClock& clk) {
+  if (clk.wall) {
+    int64_t ms = clk.epochMs - (int64_t)(uint32_t)(clk.nowMs - t_ms);
+    time_t sec = ms / 1000;
+    struct tm ti;
+    localtime_r(&sec, &ti);
+    return snprintf(out, cap, "[%02d:%02d:%02d.%03u] ",
+                    ti.tm_hour, ti.tm_min, ti.tm_sec, (unsigned)(ms % 1000));
+  }
+  // Pre-NTP: use uptime with '+' prefix to distinguish from wall-clock
+  unsigned long totalSec = t_ms / 1000;
+  unsigned int frac = t_ms % 1000;
+  unsigned int sec = totalSec % 60;
+  unsigned int mins = (totalSec / 60) % 60;
+  unsigned int hrs = (totalSec / 3600);
+  if (hrs > 0) {
+    return snprintf(out, cap, "[+%u:%02u:%02u.%03u] ", hrs, mins, sec, frac);
+  }
+  return snprintf(out, cap, "[+%02u:%02u.%03u] ", mins, sec, frac);
+}
+
+size_t SerialTee::format(uint32_t& cursor, char* dst, size_t maxLen, uint16_t* records,
+                         uint8_t maxLevel, uint32_t untilSeq) {
+  if (records) *records = 0;
+  if (!slots) return 0;
+
+  uint32_t oldest = oldestSeq();
+  if ((int32_t)(cursor - oldest) < 0 || (int32_t)(cursor - nextSeq()) > 0) cursor = oldest;
+
+  ReadClock clk;
+  clk.nowMs = millis();
+  if (!ntpSynced) {
+    struct tm ti;
+    if (getLocalTime(&ti, 0)) ntpSynced = (ti.tm_year > 100);  // year > 2000 means NTP succeeded
+  }
+  clk.wall = ntpSynced;
+  clk.epochMs = 0;
+  if (clk.wall) {
+    struct timeval tv;
+    gettimeofday(&tv, nullptr);
+    clk.epochMs = (int64_t)tv.tv_sec * 1000 + tv.tv_usec / 1000;
+  }
+
+  size_t used = 0;
+  uint16_t consumed = 0;
+  LogRecord rec;
+  while (consumed < 0xFFFF) {
+    if (untilSeq && (int32_t)(untilSeq - cursor) <= 0) break;
+    ReadResult rr = readRecord(cursor, rec);
+    if (rr == REC_PENDING) break;
+    if (rr == REC_LOST) {
+      if (consumed > 0) break;   // Keep each call's records contiguous
+      cursor = oldestSeq();
+      continue;
+    }
+    if (rec.level <= maxLevel) {
+      char stamp[24];
+      size_t stampLen = (rec.flags & LOG_REC_CONT) ? 0 : formatStamp(stamp, sizeof(stamp), rec.t_ms, clk);
+      char line[LOG_DEFERRED_MAX];
+      const char* text = rec.text;
+      size_t textLen = rec.len;
+      if (rec.flags & LOG_REC_DEFERRED) {
+        textLen = formatDeferred(rec, line, sizeof(line));
+        text = line;
+      }
+      size_t need = stampLen + textLen + ((rec.flags & LOG_REC_OPEN) ? 0 : 1);
+      if (used + need > maxLen) break;
+      memcpy(dst + used, stamp, stampLen);
+      memcpy(dst + used + stampLen, text, textLen);
+      used += stampLen + textLen;
+      if (!(rec.flags & LOG_REC_OPEN)) dst[used++] = '\n';
+    }
+    cursor++;
+    consumed++;
+  }
+  if (records) *records = consumed;
+  return used;
+}
+
+void SerialTee::clear() {
+  clearedSeq = nextSeq();
+}
+
+// ============================================================================
+// UART DRAIN TASK
+// ============================================================================
+void SerialTee::drainTask(void* arg) {
+  SerialTee* self = (SerialTee*)arg;
+  LogRecord rec;
+  for (;;) {
+    uint32_t seq = self->uartSeq;
+    ReadResult rr = self->readRecord(seq, rec);
+    if (rr == REC_READY) {
+      if (rec.flags & LOG_REC_DEFERRED) {
+        char line[LOG_DEFERRED_MAX];
+        self->hw->write((const uint8_t*)line, formatDeferred(rec, line, sizeof(line)));
+      } else {
+        self->hw->write((const uint8_t*)rec.text, rec.len);
+      }
+      if (!(rec.flags & LOG_REC_OPEN)) self->hw->write('\n');
+      self->uartSeq = seq + 1;
+    } else if (rr == REC_LOST) {
+      uint32_t oldest = self->oldestSeq();
+      self->hw->printf("[LOG] UART fell behind — %u record(s) dropped\n", oldest - seq);
+      self->uartSeq = oldest;
+    } else {
+      vTaskDelay(pdMS_TO_TICKS(LOG_DRAIN_IDLE_MS));
+    }
+  }
+}
+
+uint32_t SerialTee::drainStackFree() const {
+  return drainHandle ? uxTaskGetStackHighWaterMark(drainHandle) : 0;
+}
+
+void SerialTee::flush() {
+  if (!drainHandle || xTaskGetCurrentTaskHandle() == drainHandle) return;
+  uint32_t target = nextSeq();
+  unsigned long t0 = millis();
+  while ((int32_t)(uartSeq - target) < 0 && millis() - t0 < 200) {
+    vTaskDelay(1);
+  }
+}
+
+// ============================================================================
+// SETUP
+// ============================================================================
+void SerialTee::begin(unsigned long baud) {
+  Serial.begin(baud);  // Call begin() on Serial directly (works for both HardwareSerial and HWCDC)
+
+  if (!slots) {
+    size_t bytes = 0;
+    void* mem = nullptr;
+#if SERIAL_LOG_PSRAM_KB > 0
+    if (psramFound()) {
+      bytes = (size_t)SERIAL_LOG_PSRAM_KB * 1024;
+      mem = ps_malloc(bytes);
+    }
+#endif
+    if (!mem) {
+      bytes = SERIAL_LOG_SIZE;
+      mem = malloc(bytes);
+    }
+    if (mem) {
+      uint32_t n = bytes / LOG_SLOT_SIZE;
+      while (n & (n - 1)) n &= n - 1;  // Round down to a power of two
+      memset(mem, 0, (size_t)n * LOG_SLOT_SIZE);  // stamp 0 = nothing published
+      slotCount = n;
+      slots = (LogRecord*)mem;
+    }
+  }
+  writeSeq = 0;
+  clearedSeq = 0;
+  uartSeq = 0;
+  ntpSynced = false;
+
+  if (slots && !drainHandle) {
+    // Core 0 keeps UART writes off the race-timing core
+    xTaskCreatePinnedToCore(drainTask, "log_drain", LOG_DRAIN_STACK, this,
+                            LOG_DRAIN_PRIORITY, &drainHandle, 0);
+  }
+}
+
+void SerialTee::syncNTP(const char* tz) {
+  const char* tzStr = (tz && strlen(tz) > 0) ? tz : "EST5EDT,M3.2.0,M11.1.0";
+  configTzTime(tzStr, "pool.ntp.org", "time.nist.gov");
+  // Don't block — just fire off the request. Readers check time validity when formatting.
+}
@@ -0,0 +1,264 @@
+#ifndef SERIAL_LOG_H
+#define SERIAL_LOG_H
+
+#include <Arduino.h>
+#include <type_traits>
+
+// ============================================================================
+// SERIAL LOG — Lock-free multi-producer log ring behind the LOG macro
+//
+// LOG.printf() is called from loop() on Core 1 and from the ESP-NOW receive
+// callback (WiFi task) on Core 0. Each task assembles its current line in a
+// private buffer; a finished line is published as one binary record
+// (timestamp, level, subsystem, text) into a fixed-slot ring. Publishing is
+// an atomic ticket increment plus a memcpy — no locks, no timestamp
+// formatting and no UART I/O on the caller's path.
+//
+// A low-priority task drains new records to the UART. /api/log and the
+// "log" WebSocket stream format timestamps only when someone reads.
+//
+// Every record's seq is its ticket, so readers tail the log with a cursor.
+// A slot's stamp says whether the record at a given seq is published, still
+// being written, or already overwritten by a newer lap of the ring.
+// ============================================================================
+
+#define LOG_SLOT_SIZE        128   // Bytes per record slot (header + text)
+#define LOG_TEXT_MAX         (LOG_SLOT_SIZE - 12)
+#define SERIAL_LOG_SIZE      8192  // Internal-RAM ring when PSRAM is unavailable
+
+// Ring size in PSRAM. Build with -DSERIAL_LOG_PSRAM_KB=<n> to change it, or
+// 0 to keep the ring in internal RAM (SERIAL_LOG_SIZE).
+#ifndef SERIAL_LOG_PSRAM_KB
+#define SERIAL_LOG_PSRAM_KB  64
+#endif
+
+// Deepest drain path is a deferred record with a float arg: formatDeferred()
+// into a 200-byte line, newlib's float printf, then the UART write — about
+// 2.3 KB. 3072 left well under 1 KB spare, so 4096 keeps ~1.7 KB. Check
+// log_drain_stack_free (diagnostics memory, and the soak summary) after a
+// soak; it should stay above 1024.
+#define LOG_DRAIN_STACK      4096
+#define LOG_DRAIN_PRIORITY   1     // Just above idle — never competes with race timing
+#define LOG_DRAIN_IDLE_MS    10    // Poll interval while the ring is empty
+
+enum LogLevel : uint8_t {
+  LOG_LVL_ERROR = 1,
+  LOG_LVL_WARN  = 2,
+  LOG_LVL_INFO  = 3,
+  LOG_LVL_DEBUG = 4
+};
+
+// Subsystem ids, parsed from the "[TAG]" a line starts with
+enum LogSubsystem : uint8_t {
+  LOG_SYS_OTHER = 0,
+  LOG_SYS_BOOT,
+  LOG_SYS_CONFIG,
+  LOG_SYS_WIFI,
+  LOG_SYS_WEB,
+  LOG_SYS_ESPNOW,
+  LOG_SYS_PEERS,
+  LOG_SYS_FLEET,
+  LOG_SYS_START,
+  LOG_SYS_FINISH,
+  LOG_SYS_SPEEDTRAP,
+  LOG_SYS_TELEM,
+  LOG_SYS_LIDAR,
+  LOG_SYS_AUDIO,
+  LOG_SYS_WLED,
+  LOG_SYS_HISTORY,
+  LOG_SYS_STATS,
+  LOG_SYS_FW_UPDATE,
+  LOG_SYS_COUNT
+};
+
+#define LOG_REC_CONT      0x01   // Continues the previous record's line (no timestamp)
+#define LOG_REC_OPEN      0x02   // Line continues in the next record (no newline)
+#define LOG_REC_DEFERRED  0x04   // text[] holds a format pointer + packed args (LOG_DEFER)
+
+struct LogRecord {
+  volatile uint32_t stamp;   // seq + 1 once published, 0 while being written
+  uint32_t t_ms;             // millis() when the line was published
+  uint8_t level;             // LogLevel
+  uint8_t subsystem;         // LogSubsystem
+  uint8_t flags;             // LOG_REC_*
+  uint8_t len;
+  char text[LOG_TEXT_MAX];   // Not NUL-terminated
+};
+
+static_assert(sizeof(LogRecord) == LOG_SLOT_SIZE, "LogRecord must fill exactly one slot");
+
+// Parse "[TAG] ..." into a subsystem id
+LogSubsystem logSubsystemFromText(const char* text, size_t len);
+
+class SerialTee : public Print {
+public:
+  bool ntpSynced = false;      // True once NTP provides valid wall-clock time
+
+  // Start the UART, allocate the ring and the drain task
+  void begin(unsigned long baud);
+
+  // Try NTP sync — call after WiFi is connected. Non-blocking, best-effort.
+  // Uses the POSIX TZ string from config (e.g. "EST5EDT,M3.2.0,M11.1.0")
+  void syncNTP(const char* tz = nullptr);
+
+  size_t write(uint8_t c) override;
+  size_t write(const uint8_t* buf, size_t size) override;
+
+  // Wait (briefly) for the drain task to put everything on the UART
+  void flush() override;
+
+  // Publish one complete record. Safe from any task on either core.
+  void publish(uint8_t level, uint8_t subsystem, uint8_t flags, const char* text, size_t len);
+
+  // Seq the next record will get / oldest seq still held in the ring
+  uint32_t nextSeq() const { return __atomic_load_n(&writeSeq, __ATOMIC_ACQUIRE); }
+  uint32_t oldestSeq() const;
+
+  // Format records from `cursor` on as text lines ("[HH:MM:SS.mmm] msg\n")
+  // into dst, stopping at maxLen, at a record that is not yet published, at
+  // untilSeq (0 = no bound) or at the end of the ring. Records above
+  // maxLevel are skipped. The cursor is advanced past the records consumed;
+  // one that has fallen out of the ring is first moved up to oldestSeq().
+  // Returns bytes written and, via `records`, how many records the cursor
+  // moved over (always a contiguous run ending at the new cursor).
+  size_t format(uint32_t& cursor, char* dst, size_t maxLen, uint16_t* records = nullptr,
+                uint8_t maxLevel = LOG_LVL_DEBUG, uint32_t untilSeq = 0);
+
+  // Drop the captured output. Seq numbering carries on so cursors stay valid.
+  void clear();
+
+  // Fewest bytes of the drain task's stack ever left unused (0 if no task)
+  uint32_t drainStackFree() const;
+
+private:
+  enum ReadResult : uint8_t { REC_READY, REC_PENDING, REC_LOST };
+  ReadResult readRecord(uint32_t seq, LogRecord& out) const;
+  void appendByte(uint8_t c);
+  static void drainTask(void* arg);
+
+  Print* hw = &Serial;         // Real UART
+  LogRecord* slots = nullptr;
+  uint32_t slotCount = 0;      // Power of two
+  uint32_t writeSeq = 0;       // Next ticket (atomic)
+  uint32_t clearedSeq = 0;
+  uint32_t uartSeq = 0;        // Drain task's cursor
+  TaskHandle_t drainHandle = nullptr;
+};
+
+extern SerialTee serialTee;
+
+// ============================================================================
+// DEFERRED LOGGING — capture the format pointer + raw args, format on read
+//
+//   LOG_DEFER(FINISH, DEBUG, "elapsed_us = %lld", elapsed_us);
+//
+// Only the format string's pointer is stored, so it must be a literal. Args
+// are packed by value into the record (strings copied, truncated to what
+// fits) and run through printf later — by the drain task on its way to the
+// UART, or by /api/log when someone reads. The "[SYS] " tag is prepended and
+// the line ends at the end of the format.
+//
+// Each subsystem has a compile-time ceiling, LOG_LEVEL_<SYS>. A call above it
+// compiles to nothing, and its arguments are never evaluated:
+//   build_flags = -DLOG_LEVEL_FINISH=LOG_LVL_INFO   ; drop FINISH debug dumps
+// ============================================================================
+// A subsystem needs a LOG_LEVEL_<SYS> default here before it can use LOG_DEFER.
+#ifndef LOG_LEVEL_DEFAULT
+#define LOG_LEVEL_DEFAULT    LOG_LVL_DEBUG
+#endif
+#ifndef LOG_LEVEL_FINISH
+#define LOG_LEVEL_FINISH     LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_TELEM
+#define LOG_LEVEL_TELEM      LOG_LEVEL_DEFAULT
+#endif
+#ifndef LOG_LEVEL_PEERS
+#define LOG_LEVEL_PEERS      LOG_LEVEL_DEFAULT
+#endif
+
+#define LOG_DEFER(sys, lvl, fmt, ...) do { \
+    if (LOG_LVL_##lvl <= LOG_LEVEL_##sys) \
+      logDeferred(LOG_LVL_##lvl, LOG_SYS_##sys, "[" #sys "] " fmt, ##__VA_ARGS__); \
+  } while (0)
+
+// Packed layout: format pointer, then per arg a type byte + payload
+//   'i' int32  'u' uint32  'l' int64  'L' uint64  'd' double  'p' pointer
+//   's' length byte + chars (no NUL)
+struct LogArgPacker {
+  uint8_t buf[LOG_TEXT_MAX];
+  uint8_t len;
+
+  explicit LogArgPacker(const char* fmt) {
+    memcpy(buf, &fmt, sizeof(fmt));
+    len = sizeof(fmt);
+  }
+  void put(char type, const void* v, uint8_t n) {
+    if (len + 1 + n > LOG_TEXT_MAX) {
+      len = LOG_TEXT_MAX;  // Out of room: later args print as '?'
+      return;
+    }
+    buf[len++] = type;
+    memcpy(buf + len, v, n);
+    len += n;
+  }
+  void putStr(const char* s) {
+    if (!s) s = "(null)";
+    if (len + 2 > LOG_TEXT_MAX) {
+      len = LOG_TEXT_MAX;
+      return;
+    }
+    size_t room = LOG_TEXT_MAX - len - 2;
+    size_t n = strnlen(s, room + 1);
+    if (n > room) {
+      n = room;
+      while (n > 0 && ((uint8_t)s[n] & 0xC0) == 0x80) n--;  // Don't cut a UTF-8 char
+    }
+    buf[len++] = 's';
+    buf[len++] = (uint8_t)n;
+    memcpy(buf + len, s, n);
+    len += n;
+  }
+};
+
+template <typename T>
+inline void logPackArg(LogArgPacker& p, const T& v) {
+  if constexpr (std::is_floating_point<T>::value) {
+    double d = v;
+    p.put('d', &d, sizeof(d));
+  } else if constexpr (std::is_enum<T>::value) {
+    int32_t i = (int32_t)v;
+    p.put('i', &i, sizeof(i));
+  } else if constexpr (std::is_integral<T>::value && sizeof(T) > 4) {
+    if constexpr (std::is_signed<T>::value) {
+      int64_t l = v;
+      p.put('l', &l, sizeof(l));
+    } else {
+      uint64_t l = v;
+      p.put('L', &l, sizeof(l));
+    }
+  } else if constexpr (std::is_integral<T>::value && std::is_signed<T>::value) {
+    int32_t i = v;
+    p.put('i', &i, sizeof(i));
+  } else if constexpr (std::is_integral<T>::value) {
+    uint32_t u = v;
+    p.put('u', &u, sizeof(u));
+  } else if constexpr (std::is_convertible<const T&, const char*>::value) {
+    p.putStr(v);
+  } else if constexpr (std::is_same<T, String>::value) {
+    p.putStr(v.c_str());
+  } else if constexpr (std::is_pointer<T>::value) {
+    const void* ptr = v;
+    p.put('p', &ptr, sizeof(ptr));
+  } else {
+    static_assert(sizeof(T) == 0, "LOG_DEFER: unsupported argument type");
+  }
+}
+
+template <typename... Args>
+inline void logDeferred(uint8_t level, uint8_t subsystem, const char* fmt, const Args&... args) {
+  LogArgPacker p(fmt);
+  (logPackArg(p, args), ...);
+  serialTee.publish(level, subsystem, LOG_REC_DEFERRED, (const char*)p.buf, p.len);
+}
+
+#endif
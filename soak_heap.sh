@@ -0,0 +1,97 @@
+#!/bin/bash
+# =============================================================
+# M.A.S.S. Trap — Heap Soak Benchmark
+# Hammers the status/diagnostic endpoints and tracks heap
+# fragmentation over time
+#
+# Every request round hits the endpoints the dashboard and
+# console poll. Every SAMPLE_EVERY rounds the script records
+# free heap, min free heap, largest allocatable block and
+# heap_frag_pct from /api/diagnostics into a CSV. A healthy
+# build keeps max_alloc_heap flat. A build that fragments
+# shows max_alloc_heap drifting down while free_heap holds.
+#
+# Usage:
+#   ./soak_heap.sh <device_ip> [minutes] [api_key]
+#
+# Output: soak_<ip>_<timestamp>.csv plus a start/end summary
+# =============================================================
+
+set -e
+
+DEVICE_IP="${1:?usage: $0 <device_ip> [minutes] [api_key]}"
+MINUTES="${2:-60}"
+API_KEY="${3:-admin}"
+SAMPLE_EVERY=20
+BASE="http://${DEVICE_IP}"
+OUT="soak_${DEVICE_IP}_$(date +%Y%m%d_%H%M%S).csv"
+
+ENDPOINTS=(
+  /api/info
+  /api/wifi-status
+  /api/version
+  /api/peers
+  /api/mac
+  /api/auth/info
+  /api/lidar/status
+  /api/firmware/status
+  /api/telemetry/info
+  /api/leaderboard
+  "/api/history?since=0&limit=20"
+  "/api/log?since=0&level=2"
+  /metrics
+)
+
+sample() {
+  curl -s -m 5 -H "X-API-Key: ${API_KEY}" "${BASE}/api/diagnostics" | python3 -c "
+import sys, json
+m = json.load(sys.stdin)['memory']
+print('%d,%d,%d,%d' % (m['free_heap'], m['min_free_heap'], m['max_alloc_heap'], m.get('heap_frag_pct', 0)))
+" 2>/dev/null || echo ",,,"
+}
+
+echo "========================================"
+echo "M.A.S.S. Trap — Heap Soak (${MINUTES} min)"
+echo "Device: ${DEVICE_IP}   Output: ${OUT}"
+echo "========================================"
+
+echo "elapsed_s,requests,free_heap,min_free_heap,max_alloc_heap,heap_frag_pct" > "$OUT"
+START=$(date +%s)
+END=$((START + MINUTES * 60))
+REQUESTS=0
+ROUND=0
+
+FIRST="$(sample)"
+echo "0,0,${FIRST}" >> "$OUT"
+echo "Start: free,min_free,max_alloc,frag% = ${FIRST}"
+
+while [ "$(date +%s)" -lt "$END" ]; do
+  for ep in "${ENDPOINTS[@]}"; do
+    curl -s -m 5 -o /dev/null -H "X-API-Key: ${API_KEY}" "${BASE}${ep}" || true
+    REQUESTS=$((REQUESTS + 1))
+  done
+  ROUND=$((ROUND + 1))
+  if [ $((ROUND % SAMPLE_EVERY)) -eq 0 ]; then
+    NOW=$(( $(date +%s) - START ))
+    S="$(sample)"
+    echo "${NOW},${REQUESTS},${S}" >> "$OUT"
+    printf "\r  %5ds  %7d requests  heap: %s   " "$NOW" "$REQUESTS" "$S"
+  fi
+done
+
+LAST="$(sample)"
+ELAPSED=$(( $(date +%s) - START ))
+echo "${ELAPSED},${REQUESTS},${LAST}" >> "$OUT"
+echo ""
+echo "End:   free,min_free,max_alloc,frag% = ${LAST}"
+
+python3 -c "
+a = '${FIRST}'.split(','); b = '${LAST}'.split(',')
+if '' in a or '' in b:
+    print('Device unreachable at start or end — no summary'); raise SystemExit
+hours = max(${ELAPSED}, 1) / 3600.0
+print('Requests: ${REQUESTS} in %.2f h' % hours)
+print('free_heap      %+d bytes/h' % ((int(b[0]) - int(a[0])) / hours))
+print('max_alloc_heap %+d bytes/h' % ((int(b[2]) - int(a[2])) / hours))
+print('heap_frag_pct  %s%% -> %s%%' % (a[3], b[3]))
+"
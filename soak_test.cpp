@@ -0,0 +1,284 @@
+#include "soak_test.h"
+#include "config.h"
+#include "espnow_comm.h"
+#include "finish_gate.h"
+#include "heap_track.h"
+#include "storage.h"
+#include <WiFi.h>
+
+// Rotated through by the loopback client — the endpoints the dashboard and
+// console poll (same list as soak_heap.sh)
+static const char* const SOAK_PATHS[] = {
+  "/api/info",
+  "/api/wifi-status",
+  "/api/version",
+  "/api/peers",
+  "/api/mac",
+  "/api/lidar/status",
+  "/api/firmware/status",
+  "/api/telemetry/info",
+  "/api/leaderboard",
+  "/api/history?since=0&limit=20",
+  "/api/log?since=0&level=2",
+  "/metrics",
+};
+#define SOAK_PATH_COUNT  (sizeof(SOAK_PATHS) / sizeof(SOAK_PATHS[0]))
+
+// ============================================================================
+// STATE
+// ============================================================================
+// Sampled series: the three heap figures, then one per tracked tag
+enum SoakSeries : uint8_t {
+  SERIES_FREE = 0,
+  SERIES_MAX_ALLOC,
+  SERIES_MIN_FREE,
+  SERIES_TAG0,                                        // HEAP_TAG_ESPNOW ...
+  SERIES_COUNT = SERIES_TAG0 + HEAP_TAG_COUNT - 1
+};
+
+static const char* const SERIES_NAMES[SERIES_TAG0] = {
+  "free_heap", "max_alloc_heap", "min_free_heap"
+};
+
+// Running sums for an ordinary least-squares slope (t in hours)
+struct SeriesFit {
+  double sy;
+  double sty;
+  uint32_t first;
+  uint32_t last;
+};
+
+static bool running = false;
+static bool savedDryRun = false;
+static bool withStorage = false;        // Races reach the storage task
+static uint32_t storageDropsAtStart = 0;
+static uint32_t syncWritesAtStart = 0;
+static unsigned long startedAt = 0;
+static unsigned long stoppedAt = 0;
+static uint32_t durationMs = 0;
+static uint32_t raceIntervalMs = 0;
+static uint32_t httpIntervalMs = 0;
+
+static uint32_t races = 0;
+static uint32_t requests = 0;
+static uint32_t httpErrors = 0;
+
+static uint32_t samples = 0;
+static double st = 0, stt = 0;
+static SeriesFit fits[SERIES_COUNT];
+static unsigned long lastSampleAt = 0;
+static unsigned long lastRaceAt = 0;
+
+static WiFiClient client;
+static bool reqActive = false;
+static unsigned long reqStartedAt = 0;
+static unsigned long lastReqAt = 0;
+static uint8_t pathIdx = 0;
+static char statusLine[13];     // "HTTP/1.1 200"
+static uint8_t statusLen = 0;
+
+// ============================================================================
+// SAMPLING
+// ============================================================================
+static uint32_t seriesValue(uint8_t s) {
+  switch (s) {
+    case SERIES_FREE:      return ESP.getFreeHeap();
+    case SERIES_MAX_ALLOC: return ESP.getMaxAllocHeap();
+    case SERIES_MIN_FREE:  return ESP.getMinFreeHeap();
+    default:               return heapTrackLiveBytes((HeapTag)(s - SERIES_TAG0 + 1));
+  }
+}
+
+static void takeSample(unsigned long now) {
+  double t = (now - startedAt) / 3600000.0;
+  samples++;
+  st += t;
+  stt += t * t;
+  for (uint8_t s = 0; s < SERIES_COUNT; s++) {
+    uint32_t v = seriesValue(s);
+    if (samples == 1) fits[s].first = v;
+    fits[s].last = v;
+    fits[s].sy += v;
+    fits[s].sty += t * v;
+  }
+  lastSampleAt = now;
+}
+
+// Bytes per hour; NaN (written as null) until there are two samples
+static double slope(uint8_t s) {
+  double den = samples * stt - st * st;
+  if (samples < 2 || den <= 0) return NAN;
+  return (samples * fits[s].sty - st * fits[s].sy) / den;
+}
+
+// ============================================================================
+// SYNTHETIC TRAFFIC
+// ============================================================================
+// Hand finishGateLoop() a finished race exactly as the ISR and MSG_START would
+static void injectRace(unsigned long now) {
+  if (raceState != IDLE || now - lastRaceAt < raceIntervalMs) return;
+  uint64_t elapsed_us = random(2000, 4500) * 1000ULL;
+  uint64_t t = nowUs();
+  portENTER_CRITICAL(&finishTimerMux);
+  startTime_us = t - elapsed_us;
+  finishTime_us = t;
+  raceState = FINISHED;
+  portEXIT_CRITICAL(&finishTimerMux);
+  races++;
+  lastRaceAt = now;
+}
+
+// One loopback request at a time: connect and send on one pass, drain the
+// reply over the following passes while server.handleClient() answers it
+static void httpStep(unsigned long now) {
+  if (!reqActive) {
+    if (now - lastReqAt < httpIntervalMs) return;
+    lastReqAt = now;
+    if (!client.connect(IPAddress(127, 0, 0, 1), 80, 200)) {
+      httpErrors++;
+      return;
+    }
+    char req[192];
+    int n = snprintf(req, sizeof(req),
+                     "GET %s HTTP/1.1\r\nHost: 127.0.0.1\r\nX-API-Key: %s\r\nConnection: close\r\n\r\n",
+                     SOAK_PATHS[pathIdx], cfg.ota_password);
+    pathIdx = (pathIdx + 1) % SOAK_PATH_COUNT;
+    client.write((const uint8_t*)req, min(n, (int)sizeof(req) - 1));
+    reqActive = true;
+    reqStartedAt = now;
+    statusLen = 0;
+    return;
+  }
+
+  uint8_t buf[256];
+  while (client.available()) {
+    int n = client.read(buf, sizeof(buf));
+    if (n <= 0) break;
+    for (int i = 0; i < n && statusLen < sizeof(statusLine) - 1; i++) {
+      statusLine[statusLen++] = buf[i];
+    }
+  }
+  statusLine[statusLen] = '\0';
+
+  if (!client.connected()) {
+    // "HTTP/1.1 2xx"
+    if (statusLen < 10 || statusLine[9] != '2') httpErrors++;
+    requests++;
+    client.stop();
+    reqActive = false;
+  } else if (now - reqStartedAt > SOAK_HTTP_TIMEOUT_MS) {
+    httpErrors++;
+    client.stop();
+    reqActive = false;
+  }
+}
+
+// ============================================================================
+// CONTROL
+// ============================================================================
+bool soakStart(uint32_t minutes, uint32_t raceIntervalS, uint32_t httpMs, bool storage) {
+  if (running) return false;
+  if (minutes == 0 || minutes > SOAK_MAX_MINUTES) return false;
+  if (raceIntervalS < 10 || httpMs < 50) return false;
+
+  durationMs = minutes * 60000UL;
+  raceIntervalMs = raceIntervalS * 1000UL;
+  httpIntervalMs = httpMs;
+  races = requests = httpErrors = 0;
+  samples = 0;
+  st = stt = 0;
+  memset(fits, 0, sizeof(fits));
+  reqActive = false;
+  pathIdx = 0;
+
+  savedDryRun = dryRunMode;
+  dryRunMode = !storage;
+  withStorage = storage;
+  StorageStats ss;
+  storageGetStats(ss);
+  storageDropsAtStart = ss.dropped;
+  syncWritesAtStart = ss.syncWrites;
+  startedAt = millis();
+  stoppedAt = 0;
+  lastRaceAt = lastReqAt = startedAt;
+  takeSample(startedAt);
+  running = true;
+
+  LOG.printf("[SOAK] Started: %u min, race every %us, request every %ums, storage %s\n",
+             minutes, raceIntervalS, httpMs, storage ? "on" : "off");
+  return true;
+}
+
+void soakStop() {
+  if (!running) return;
+  if (reqActive) client.stop();
+  reqActive = false;
+  unsigned long now = millis();
+  if (now - lastSampleAt > 1000) takeSample(now);
+  stoppedAt = now;
+  running = false;
+  dryRunMode = savedDryRun;
+
+  LOG.printf("[SOAK] Stopped after %lus: %u races, %u requests (%u errors), "
+             "free_heap %+.0f B/h, max_alloc_heap %+.0f B/h, log drain stack %u B free\n",
+             (now - startedAt) / 1000, races, requests, httpErrors,
+             slope(SERIES_FREE), slope(SERIES_MAX_ALLOC), serialTee.drainStackFree());
+}
+
+bool soakRunning() {
+  return running;
+}
+
+void soakLoop() {
+  if (!running) return;
+  unsigned long now = millis();
+  if (now - startedAt >= durationMs) {
+    soakStop();
+    return;
+  }
+  if (now - lastSampleAt >= SOAK_SAMPLE_MS) takeSample(now);
+  if (strcmp(cfg.role, "finish") == 0) injectRace(now);
+  httpStep(now);
+}
+
+// ============================================================================
+// JSON
+// ============================================================================
+void soakWrite(JsonWriter& w) {
+  unsigned long end = running ? millis() : stoppedAt;
+  w.field("running", running)
+   .field("elapsed_s", samples ? (end - startedAt) / 1000 : 0)
+   .field("duration_s", durationMs / 1000)
+   .field("races", races)
+   .field("requests", requests)
+   .field("http_errors", httpErrors)
+   .field("samples", samples)
+   .field("storage", withStorage)
+   .field("log_drain_stack_free", serialTee.drainStackFree());
+  if (withStorage) {
+    // Races the storage task couldn't queue during the run
+    StorageStats ss;
+    storageGetStats(ss);
+    w.field("storage_dropped", ss.dropped - storageDropsAtStart)
+     .field("storage_sync_writes", ss.syncWrites - syncWritesAtStart);
+  }
+
+  w.beginObject("start");
+  for (uint8_t s = 0; s < SERIES_TAG0; s++) w.field(SERIES_NAMES[s], fits[s].first);
+  w.endObject();
+  w.beginObject("last");
+  for (uint8_t s = 0; s < SERIES_TAG0; s++) w.field(SERIES_NAMES[s], fits[s].last);
+  w.endObject();
+
+  // Bytes per hour
+  w.beginObject("growth_bph");
+  for (uint8_t s = 0; s < SERIES_TAG0; s++) w.field(SERIES_NAMES[s], slope(s), 0);
+#if HEAP_TRACK_ENABLED
+  w.beginObject("tags");
+  for (uint8_t s = SERIES_TAG0; s < SERIES_COUNT; s++) {
+    w.field(heapTagName((HeapTag)(s - SERIES_TAG0 + 1)), slope(s), 0);
+  }
+  w.endObject();
+#endif
+  w.endObject();
+}
@@ -0,0 +1,47 @@
+#ifndef SOAK_TEST_H
+#define SOAK_TEST_H
+
+#include <Arduino.h>
+#include "json_writer.h"
+
+// ============================================================================
+// SOAK TEST — Hours of synthetic races and HTTP traffic on the device itself
+//
+// Started from POST /api/diagnostics/heap/soak. While it runs:
+//   - a finish gate injects a race every race_interval_s (random 2.0-4.5 s
+//     elapsed) through the normal finishGateLoop() path. Dry-run is forced
+//     on for the duration so nothing reaches the run log, the history or the
+//     leaderboard — unless the soak is started with storage on, which forces
+//     dry-run off instead so every race goes through the storage task. Use
+//     that on a bench node: the synthetic races stay in its logs.
+//   - every node requests one of the polled status endpoints from its own
+//     web server over loopback every http_interval_ms.
+// Free heap, largest block, low-water mark and each heap_track.h tag's live
+// bytes are sampled once a minute. A least-squares slope over all samples
+// gives the growth rate in bytes per hour; a negative max_alloc_heap slope
+// with a flat free_heap slope is fragmentation, not a leak.
+//
+// soak_heap.sh drives the same endpoints from a laptop instead.
+// ============================================================================
+
+#define SOAK_MAX_MINUTES        1440    // 24 h cap
+#define SOAK_DEFAULT_MINUTES    240
+#define SOAK_DEFAULT_RACE_S     30
+#define SOAK_DEFAULT_HTTP_MS    500
+#define SOAK_SAMPLE_MS          60000   // Heap sample period
+#define SOAK_HTTP_TIMEOUT_MS    5000    // Give up on a loopback request after this
+
+// Returns false if already running or the arguments are out of range
+bool soakStart(uint32_t minutes, uint32_t raceIntervalS, uint32_t httpIntervalMs,
+               bool storage = false);
+void soakStop();
+bool soakRunning();
+
+// Call every loop() pass — returns immediately when no soak is running
+void soakLoop();
+
+// Write the current or last soak run's counters and growth rates into an
+// open JSON object
+void soakWrite(JsonWriter& w);
+
+#endif
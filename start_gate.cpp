@@ -16,6 +16,12 @@ static unsigned long triggeredTime = 0;
 static unsigned long finishedAt = 0;
 static bool waitingToReset = false;
 
+// LiDAR launch timing: when the gate armed, and a triggered START waiting
+// for the LiDAR to time the departure (see sendStartWhenReady)
+static uint64_t armTime_us = 0;
+static bool startPending = false;
+static uint64_t pendingTrigger_us = 0;
+
 // Proximity arm sensor (HW-870 / TCRT5000 on sensor_pin_2)
 // DO pin goes LOW when reflective surface detected (car present)
 static bool proxArmEnabled = false;       // Set true if sensor_pin_2 is configured
@@ -67,6 +73,36 @@ static void breatheLED() {
   analogWrite(cfg.led_pin, brightness);
 }
 
+// ============================================================================
+// START MESSAGE
+// MSG_START carries the beam-break timestamp and, when the LiDAR saw the car
+// leave after arming, reaction (arm → departure) and launch-to-beam times.
+// A car the LiDAR still shows as staged has left but its far frame hasn't
+// been processed yet, so START is held up to START_LIDAR_WAIT_MS for it.
+// Elapsed time is unaffected — it comes from the trigger timestamp.
+// ============================================================================
+static void sendStartWhenReady() {
+  if (!startPending) return;
+  uint64_t launch = lidarLaunchUs();
+  bool launched = armTime_us > 0 && launch > armTime_us;
+  if (!launched && getLidarState() == LIDAR_CAR_STAGED &&
+      millis() - triggeredTime < START_LIDAR_WAIT_MS) {
+    return;
+  }
+
+  StartTiming t = {};
+  if (launched) {
+    int64_t toBeam = (int64_t)pendingTrigger_us - (int64_t)launch;
+    t.reaction_us = (uint32_t)min(launch - armTime_us, (uint64_t)UINT32_MAX);
+    t.launchToBeam_us = (int32_t)constrain(toBeam, (int64_t)INT32_MIN, (int64_t)INT32_MAX);
+    t.valid = true;
+    LOG.printf("[START] Reaction %.3f s, launch to beam %.1f ms\n",
+               t.reaction_us / 1000000.0, t.launchToBeam_us / 1000.0);
+  }
+  sendToPeer(MSG_START, pendingTrigger_us, packStartTiming(t));
+  startPending = false;
+}
+
 // ============================================================================
 // MAIN LOOP
 // ============================================================================
@@ -139,6 +175,7 @@ void startGateLoop() {
         if (proxArmEligible && proxCarPresent && proxDetectStart > 0 &&
             (millis() - proxDetectStart >= PROX_ARM_DWELL_MS)) {
           raceState = ARMED;
+          armTime_us = nowUs();
           triggerDetected = false;
           portENTER_CRITICAL(&startMux);
           triggerTime_us = 0;
@@ -158,6 +195,7 @@ void startGateLoop() {
       // LiDAR auto-arm: if car has been staged for >1 second, auto-arm
       if (lidarAutoArmReady()) {
         raceState = ARMED;
+        armTime_us = nowUs();
         triggerDetected = false;
         portENTER_CRITICAL(&startMux);
         triggerTime_us = 0;
@@ -188,10 +226,12 @@ void startGateLoop() {
         // Send START with our LOCAL precise timestamp to finish gate.
         // The finish gate will convert this to its timebase using clockOffset.
         LOG.printf("[START] TRIGGERED at %llu us\n", safeTrigger);
-        sendToPeer(MSG_START, safeTrigger, 0);
+        pendingTrigger_us = safeTrigger;
+        startPending = true;
+        sendStartWhenReady();
 
         // Play "go" sound on start gate speaker
-        playSound("go.wav");
+        playSound("go.wav", AUDIO_PRIO_HIGH);
 
         // Detach interrupt to prevent re-trigger
         detachInterrupt(digitalPinToInterrupt(cfg.sensor_pin));
@@ -201,6 +241,8 @@ void startGateLoop() {
       break;
 
     case RACING:
+      sendStartWhenReady();
+
       // Flash LED rapidly while racing
       digitalWrite(cfg.led_pin, (millis() / 100) % 2);
 
@@ -208,6 +250,7 @@ void startGateLoop() {
       if (millis() - triggeredTime > RACE_TIMEOUT_MS) {
         LOG.println("[START] Race timeout - no finish confirmation");
         raceState = IDLE;
+        startPending = false;
         // Reset prox sensor — require clear→detect cycle
         proxCarPresent = false;
         proxDetectStart = 0;
@@ -257,6 +300,7 @@ void onStartGateESPNow(const ESPMessage& msg, uint64_t receiveTime) {
       // Finish gate says to arm
       if (raceState == IDLE) {
         raceState = ARMED;
+        armTime_us = nowUs();
         triggerDetected = false;
         portENTER_CRITICAL(&startMux);
         triggerTime_us = 0;
@@ -273,6 +317,7 @@ void onStartGateESPNow(const ESPMessage& msg, uint64_t receiveTime) {
       // Finish gate says to reset
       raceState = IDLE;
       triggerDetected = false;
+      startPending = false;
       detachInterrupt(digitalPinToInterrupt(cfg.sensor_pin));
       // Reset prox sensor — require clear→detect cycle before next arm
       proxCarPresent = false;
@@ -0,0 +1,243 @@
+#include "storage.h"
+#include "config.h"
+#include "finish_gate.h"
+#include "leaderboard.h"
+#include "run_log.h"
+#include "metrics.h"
+#include "heap_track.h"
+#include <LittleFS.h>
+
+enum StorageJobType : uint8_t {
+  STORE_RACE = 0,
+  STORE_TELEMETRY,
+  STORE_PEERS
+};
+
+struct TelemetryJob {
+  IMUSample* samples;
+  uint16_t count;
+  uint32_t runId;
+  uint32_t duration_ms;
+};
+
+struct StorageJob {
+  StorageJobType type;
+  bool appendHistory;       // STORE_RACE
+  uint32_t enqueuedAt;      // millis()
+  union {
+    RaceRecord race;
+    TelemetryJob telem;
+  };
+};
+
+// ============================================================================
+// STATE
+// ============================================================================
+static QueueHandle_t jobQueue = nullptr;
+static SemaphoreHandle_t dataMutex = nullptr;
+static TaskHandle_t taskHandle = nullptr;
+static volatile uint32_t lastEnqueueAt = 0;
+static volatile bool peersSaveQueued = false;
+
+static StorageStats stats;
+static portMUX_TYPE statsMux = portMUX_INITIALIZER_UNLOCKED;
+
+// ============================================================================
+// LOCK
+// ============================================================================
+StorageLock::StorageLock() {
+  if (dataMutex) xSemaphoreTakeRecursive(dataMutex, portMAX_DELAY);
+}
+
+StorageLock::~StorageLock() {
+  if (dataMutex) xSemaphoreGiveRecursive(dataMutex);
+}
+
+// ============================================================================
+// JOBS (storage task, or the caller before storageBegin())
+// ============================================================================
+static void writeRace(const StorageJob& job) {
+  RaceRecord rec = job.race;
+  StorageLock lock;
+  runLogAppend(rec, job.appendHistory ? 0 : RUN_FLAG_TIMING_ERROR);
+  if (job.appendHistory) {
+    if (raceLogAppend(rec)) leaderboardRecord(rec);
+  }
+}
+
+static void runJob(const StorageJob& job) {
+  switch (job.type) {
+    case STORE_RACE:
+      writeRace(job);
+      break;
+    case STORE_TELEMETRY: {
+      HEAP_TAG(TELEMETRY);
+      telemetryWriteCsv(job.telem.samples, job.telem.count, job.telem.runId, job.telem.duration_ms);
+      free(job.telem.samples);
+      break;
+    }
+    case STORE_PEERS:
+      peersSaveQueued = false;
+      savePeers();
+      break;
+  }
+}
+
+static void endBatch() {
+  StorageLock lock;
+  runLogFlush();
+}
+
+// ============================================================================
+// TASK
+// ============================================================================
+// Hold the head job until the node is quiet, unless the backlog or the head
+// job's age says to write now
+static void waitForIdle(const StorageJob& head) {
+  for (;;) {
+    uint32_t now = millis();
+    if (uxQueueMessagesWaiting(jobQueue) >= STORAGE_BATCH_MAX) return;
+    if (now - head.enqueuedAt >= STORAGE_MAX_DEFER_MS) return;
+    if (raceState != RACING && now - lastEnqueueAt >= STORAGE_IDLE_MS) return;
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+}
+
+static void storageTask(void*) {
+  StorageJob job;
+  for (;;) {
+    if (xQueuePeek(jobQueue, &job, portMAX_DELAY) != pdTRUE) continue;
+    waitForIdle(job);
+
+    uint32_t batch = 0;
+    while (xQueueReceive(jobQueue, &job, 0) == pdTRUE) {
+      uint32_t waited = millis() - job.enqueuedAt;
+      uint32_t t0 = micros();
+      runJob(job);
+      uint32_t took = micros() - t0;
+      batch++;
+
+      portENTER_CRITICAL(&statsMux);
+      stats.written++;
+      stats.waitTotal_ms += waited;
+      if (waited > stats.waitMax_ms) stats.waitMax_ms = waited;
+      stats.writeTotal_us += took;
+      if (took > stats.writeMax_us) stats.writeMax_us = took;
+      portEXIT_CRITICAL(&statsMux);
+    }
+    endBatch();
+
+    portENTER_CRITICAL(&statsMux);
+    stats.batches++;
+    portEXIT_CRITICAL(&statsMux);
+  }
+}
+
+void storageBegin() {
+  if (jobQueue) return;
+  dataMutex = xSemaphoreCreateRecursiveMutex();
+  jobQueue = xQueueCreate(STORAGE_QUEUE_DEPTH, sizeof(StorageJob));
+  if (!jobQueue || !dataMutex) {
+    LOG.println("[STORAGE] Failed to create queue — writes stay synchronous");
+    jobQueue = nullptr;
+    return;
+  }
+  // Core 0, below the WiFi task — flash stalls land off the loop() core
+  xTaskCreatePinnedToCore(storageTask, "storage", STORAGE_TASK_STACK, nullptr,
+                          STORAGE_TASK_PRIORITY, &taskHandle, 0);
+  LOG.printf("[STORAGE] Write-behind task started (queue %d jobs)\n", STORAGE_QUEUE_DEPTH);
+}
+
+// ============================================================================
+// SUBMIT
+// ============================================================================
+// syncOnFull: write the job on the caller's task rather than drop it when
+// the queue is full (races — a result must never be lost)
+static bool submit(StorageJob& job, bool syncOnFull = false) {
+  job.enqueuedAt = millis();
+  if (!jobQueue) {
+    runJob(job);
+    endBatch();
+    return true;
+  }
+  bool ok = xQueueSend(jobQueue, &job, 0) == pdTRUE;
+  lastEnqueueAt = job.enqueuedAt;
+
+  portENTER_CRITICAL(&statsMux);
+  if (ok) {
+    stats.queued++;
+    uint8_t depth = uxQueueMessagesWaiting(jobQueue);
+    if (depth > stats.depthMax) stats.depthMax = depth;
+  } else if (syncOnFull) {
+    stats.syncWrites++;
+  } else {
+    stats.dropped++;
+  }
+  portEXIT_CRITICAL(&statsMux);
+
+  if (!ok && syncOnFull) {
+    LOG.println("[STORAGE] Queue full — writing synchronously");
+    runJob(job);
+    endBatch();
+    return true;
+  }
+  return ok;
+}
+
+bool storageSubmitRace(const RaceRecord& rec, bool appendHistory) {
+  StorageJob job;
+  job.type = STORE_RACE;
+  job.appendHistory = appendHistory;
+  job.race = rec;
+  return submit(job, true);
+}
+
+bool storageSubmitTelemetry(IMUSample* samples, uint16_t count, uint32_t runId, uint32_t duration_ms) {
+  StorageJob job;
+  job.type = STORE_TELEMETRY;
+  job.appendHistory = false;
+  job.telem = {samples, count, runId, duration_ms};
+  if (submit(job)) return true;
+  free(samples);
+  LOG.printf("[STORAGE] Queue full — telemetry run %u not saved\n", runId);
+  return false;
+}
+
+void storageRequestPeersSave() {
+  if (peersSaveQueued) return;
+  peersSaveQueued = true;
+  StorageJob job;
+  job.type = STORE_PEERS;
+  job.appendHistory = false;
+  if (!submit(job)) peersSaveQueued = false;   // Next request retries
+}
+
+// ============================================================================
+// STATS
+// ============================================================================
+void storageGetStats(StorageStats& out) {
+  portENTER_CRITICAL(&statsMux);
+  out = stats;
+  portEXIT_CRITICAL(&statsMux);
+  out.depth = jobQueue ? uxQueueMessagesWaiting(jobQueue) : 0;
+}
+
+void storageWrite(JsonWriter& w) {
+  StorageStats s;
+  storageGetStats(s);
+  w.field("async", jobQueue != nullptr)
+   .field("queue_depth", s.depth)
+   .field("queue_max", s.depthMax)
+   .field("queue_capacity", STORAGE_QUEUE_DEPTH)
+   .field("queued", s.queued)
+   .field("written", s.written)
+   .field("dropped", s.dropped)
+   .field("sync_writes", s.syncWrites)
+   .field("batches", s.batches)
+   .field("wait_max_ms", s.waitMax_ms)
+   .field("wait_mean_ms", s.written ? (uint32_t)(s.waitTotal_ms / s.written) : 0)
+   .field("write_max_us", s.writeMax_us)
+   .field("write_mean_us", s.written ? (uint32_t)(s.writeTotal_us / s.written) : 0)
+   .field("run_log_records", runLogCount())
+   .field("run_log_last_seq", runLogLastSeq());
+}
@@ -0,0 +1,80 @@
+#ifndef STORAGE_H
+#define STORAGE_H
+
+#include <Arduino.h>
+#include "espnow_comm.h"
+#include "race_log.h"
+#include "json_writer.h"
+
+// ============================================================================
+// STORAGE TASK — Write-behind queue for LittleFS writes on the race path
+//
+// A LittleFS write that has to erase a sector stalls for 10-100 ms. That
+// used to happen inside finishGateLoop() (run log, history, leaderboard
+// snapshot), inside the ESP-NOW callback (telemetry CSV) and in
+// discoveryLoop() (peers.json). Those paths now hand a fixed-size job to a
+// bounded queue and return; a low-priority task on Core 0 does the writes.
+//
+// Flush-on-idle: the task holds queued jobs until nothing new has arrived
+// for STORAGE_IDLE_MS and no race is running, then writes everything
+// waiting as one batch (the run log stays open across the batch). A backlog of
+// STORAGE_BATCH_MAX jobs or a job older than STORAGE_MAX_DEFER_MS is
+// written straight away regardless.
+//
+// The run log, race log and leaderboard indexes are now updated from the
+// storage task. Anything else that reads or replaces them holds a StorageLock.
+// ============================================================================
+
+#define STORAGE_QUEUE_DEPTH     16
+#define STORAGE_BATCH_MAX       8       // Backlog that triggers an immediate flush
+#define STORAGE_IDLE_MS         250     // Quiet time before a batch is written
+#define STORAGE_MAX_DEFER_MS    10000   // Oldest a queued job may get, race or not
+#define STORAGE_TASK_STACK      6144
+#define STORAGE_TASK_PRIORITY   1       // Below WiFi/ESP-NOW, same as the log drain
+
+// Create the queue and task. Call after raceLogInit()/leaderboardInit().
+// Until then (and in setup mode) submissions are written synchronously.
+void storageBegin();
+
+// Queue a finished race: a run log record, plus a history append and
+// leaderboard update when appendHistory (timing errors are not results).
+// If the queue is full the race is written synchronously on the caller's
+// task instead of being dropped.
+bool storageSubmitRace(const RaceRecord& rec, bool appendHistory);
+
+// Queue the telemetry CSV export. Takes ownership of samples (PSRAM,
+// ps_malloc'd) and frees it after writing, or at once if the queue is full.
+bool storageSubmitTelemetry(IMUSample* samples, uint16_t count, uint32_t runId, uint32_t duration_ms);
+
+// Queue a peers.json rewrite. Repeated requests before it runs coalesce.
+void storageRequestPeersSave();
+
+// Write "storage": queue depth/high-water, job counts, wait and write latency
+// into an open JSON object (fields only)
+void storageWrite(JsonWriter& w);
+
+struct StorageStats {
+  uint8_t  depth;
+  uint8_t  depthMax;
+  uint32_t queued;
+  uint32_t written;
+  uint32_t dropped;
+  uint32_t syncWrites;        // Races written on the caller's task (queue full)
+  uint32_t batches;
+  uint32_t waitMax_ms;        // Enqueue → write start
+  uint64_t waitTotal_ms;
+  uint32_t writeMax_us;       // Time spent writing one job
+  uint64_t writeTotal_us;
+};
+void storageGetStats(StorageStats& out);
+
+// Serializes access to the run log, race log and leaderboard with the
+// storage task.
+// No-op before storageBegin().
+class StorageLock {
+public:
+  StorageLock();
+  ~StorageLock();
+};
+
+#endif
@@ -0,0 +1,148 @@
+// ============================================================================
+// Host benchmark for audio_convert.cpp — output samples per second
+//
+//   g++ -O2 -std=c++17 -I. tools/audio_convert_bench.cpp audio_convert.cpp -o /tmp/acbench
+//   /tmp/acbench [seconds-of-audio]
+//
+// Feeds synthetic clips in the formats the firmware accepts through the same
+// block path the I2S mixer uses (decode into a FIFO, resample 256-sample
+// output blocks) and reports throughput and the margin over real time at
+// the 16 kHz output rate. Host numbers are not ESP32 numbers, but the ratio
+// between formats carries over and a regression shows up here first.
+//
+// Not part of the firmware build (excluded in platformio.ini).
+// ============================================================================
+#include "audio_convert.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+static const uint32_t OUT_RATE = 16000;
+static const size_t BLOCK = 256;
+static const size_t FIFO = BLOCK * 2;
+
+struct Format {
+  const char* name;
+  uint32_t rate;
+  uint8_t bits;       // 4 = IMA-ADPCM
+  uint8_t channels;
+};
+
+static const uint16_t ADPCM_BLOCK = 256;   // radio_filter.sh --adpcm
+
+static const Format FORMATS[] = {
+  { "8-bit mono 16 kHz",      16000,  8, 1 },
+  { "16-bit mono 16 kHz",     16000, 16, 1 },
+  { "16-bit mono 8 kHz",       8000, 16, 1 },
+  { "16-bit mono 22.05 kHz",  22050, 16, 1 },
+  { "16-bit stereo 44.1 kHz", 44100, 16, 2 },
+  { "24-bit stereo 48 kHz",   48000, 24, 2 },
+  { "IMA-ADPCM mono 16 kHz",  16000,  4, 1 },
+  { "IMA-ADPCM mono 22.05 kHz", 22050, 4, 1 },
+};
+
+static std::vector<uint8_t> makeClip(const Format& f, uint32_t frames) {
+  if (f.bits == 4) {
+    // Random nibbles behind valid block headers — decode cost does not
+    // depend on the signal
+    std::vector<uint8_t> buf((frames / 2 / ADPCM_BLOCK + 1) * ADPCM_BLOCK);
+    for (size_t i = 0; i < buf.size(); i++) {
+      buf[i] = (i % ADPCM_BLOCK) < 4 ? 0 : (uint8_t)rand();
+    }
+    return buf;
+  }
+  size_t frameBytes = (f.bits / 8) * f.channels;
+  std::vector<uint8_t> buf(frames * frameBytes);
+  uint8_t* p = buf.data();
+  for (uint32_t i = 0; i < frames; i++) {
+    int32_t s = (int32_t)(20000 * sin(2 * M_PI * 440.0 * i / f.rate));
+    for (uint8_t c = 0; c < f.channels; c++) {
+      if (f.bits == 8) {
+        *p++ = (uint8_t)((s >> 8) + 128);
+      } else if (f.bits == 16) {
+        *p++ = s & 0xFF;
+        *p++ = (s >> 8) & 0xFF;
+      } else {
+        *p++ = 0;
+        *p++ = s & 0xFF;
+        *p++ = (s >> 8) & 0xFF;
+      }
+    }
+  }
+  return buf;
+}
+
+// Mirrors voiceStreamBlock() in audio_manager.cpp. Returns output samples.
+static size_t convertClip(const Format& f, const std::vector<uint8_t>& clip, int64_t& checksum) {
+  bool adpcm = f.bits == 4;
+  size_t frameBytes = adpcm ? 1 : (f.bits / 8) * f.channels;
+  size_t totalFrames = clip.size() / frameBytes;
+  AudioAdpcm ima;
+  audioAdpcmInit(ima, ADPCM_BLOCK);
+  size_t readFrames = 0;
+  int16_t fifo[FIFO];
+  size_t fifoCount = 0;
+  int16_t out[BLOCK];
+  AudioResampler rs;
+  audioResamplerInit(rs, f.rate, OUT_RATE);
+  bool direct = f.rate == OUT_RATE;
+  size_t total = 0;
+
+  for (;;) {
+    size_t produced = 0;
+    while (produced < BLOCK) {
+      size_t used;
+      if (direct) {
+        used = fifoCount < BLOCK - produced ? fifoCount : BLOCK - produced;
+        memcpy(out + produced, fifo, used * 2);
+        produced += used;
+      } else {
+        produced += audioResample(rs, fifo, fifoCount, &used, out + produced, BLOCK - produced);
+      }
+      if (used) {
+        fifoCount -= used;
+        memmove(fifo, fifo + used, fifoCount * 2);
+      }
+      if (produced < BLOCK) {
+        size_t n = FIFO - fifoCount;
+        if (adpcm) n /= 2;
+        if (n > totalFrames - readFrames) n = totalFrames - readFrames;
+        if (n == 0) break;
+        const uint8_t* in = clip.data() + readFrames * frameBytes;
+        if (adpcm) {
+          fifoCount += audioAdpcmDecode(ima, in, n, fifo + fifoCount);
+        } else {
+          fifoCount += audioDecodeFrames(in, n, f.bits, f.channels, fifo + fifoCount);
+        }
+        readFrames += n;
+      }
+    }
+    if (produced == 0) break;
+    checksum += out[produced / 2];
+    total += produced;
+  }
+  return total;
+}
+
+int main(int argc, char** argv) {
+  double seconds = argc > 1 ? atof(argv[1]) : 600.0;
+  printf("%-24s %14s %12s\n", "format", "samples/s", "x realtime");
+
+  for (const Format& f : FORMATS) {
+    std::vector<uint8_t> clip = makeClip(f, (uint32_t)(f.rate * seconds));
+    int64_t checksum = 0;
+
+    auto t0 = std::chrono::steady_clock::now();
+    size_t samples = convertClip(f, clip, checksum);
+    auto t1 = std::chrono::steady_clock::now();
+
+    double secs = std::chrono::duration<double>(t1 - t0).count();
+    double rate = samples / secs;
+    printf("%-24s %14.0f %12.0f   (checksum %lld)\n", f.name, rate, rate / OUT_RATE,
+           (long long)checksum);
+  }
+  return 0;
+}
@@ -6,6 +6,18 @@
 #include "wled_integration.h"
 #include "audio_manager.h"
 #include "lidar_sensor.h"
+#include "live_stream.h"
+#include "race_log.h"
+#include "run_log.h"
+#include "leaderboard.h"
+#include "json_stream.h"
+#include "profiler.h"
+#include "metrics.h"
+#include "json_writer.h"
+#include "heap_track.h"
+#include "soak_test.h"
+#include "storage.h"
+#include "boot_timing.h"
 #include "html_index.h"
 #include "html_config.h"
 #include "html_console.h"
@@ -21,10 +33,11 @@
 #include <Update.h>
 #include <esp_mac.h>
 #include <Wire.h>
+#include <StreamString.h>
+#include <uri/UriBraces.h>
 
 WebServer server(80);
 WebSocketsServer webSocket(81);
-SerialTee serialTee;
 
 // ============================================================================
 // FIRMWARE UPDATE — Root CA certs for GitHub TLS verification
@@ -133,6 +146,75 @@ static void serveFile(const String& path, const String& contentType) {
   }
 }
 
+// ============================================================================
+// ZERO-ALLOCATION RESPONSES
+// Status and diagnostic handlers render with JsonWriter (json_writer.h) into a
+// stack PrintBuffer, or into a ChunkedResponse when the size is open-ended,
+// so a request never leaves String fragments behind in internal RAM.
+// ============================================================================
+class ChunkedResponse : public Print {
+public:
+  void begin(int code, const char* contentType) {
+    server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    server.send(code, contentType, "");
+    len = 0;
+  }
+  size_t write(uint8_t c) override {
+    buf[len++] = c;
+    if (len == sizeof(buf)) flush();
+    return 1;
+  }
+  size_t write(const uint8_t* data, size_t n) override {
+    for (size_t i = 0; i < n; i++) write(data[i]);
+    return n;
+  }
+  void flush() override {
+    if (len) server.sendContent((const char*)buf, len);
+    len = 0;
+  }
+  void end() {
+    flush();
+    server.sendContent("");  // Zero-length chunk terminates the response
+  }
+private:
+  uint8_t buf[512];
+  size_t len = 0;
+};
+
+// Send a small JSON body rendered into a stack buffer
+static void sendJsonBuffer(const PrintBuffer& pb) {
+  if (pb.overflowed()) {
+    server.send(500, "application/json", "{\"error\":\"Response too large\"}");
+    return;
+  }
+  server.send_P(200, "application/json", pb.c_str(), pb.length());
+}
+
+// Send the records in the cursor's window as comma-separated JSON objects
+// (the caller writes the brackets). Each batch is copied out of the log
+// under the lock and sent with it released, so a slow client doesn't hold
+// up the storage task for the whole download. Returns the records sent.
+static uint32_t sendHistoryBatches(ChunkedResponse& out, RaceLogCursor cur) {
+  char batch[RACE_LOG_BATCH_BYTES];
+  uint32_t budget = cur.limit;
+  bool first = true;
+  for (;;) {
+    PrintBuffer pb(batch, sizeof(batch));
+    bool more;
+    {
+      StorageLock lock;   // The storage task appends races
+      more = raceLogWriteBatch(pb, cur);
+    }
+    if (pb.length() > 0) {
+      if (!first) out.print(',');
+      out.write((const uint8_t*)pb.c_str(), pb.length());
+      first = false;
+    }
+    if (!more) break;
+  }
+  return budget - cur.limit;
+}
+
 // ============================================================================
 // WEBSOCKET HANDLER
 // ============================================================================
@@ -142,7 +224,12 @@ static void webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t
       broadcastState();
       break;
 
+    case WStype_DISCONNECTED:
+      streamClientGone(num);
+      break;
+
     case WStype_TEXT: {
+      HEAP_TAG(JSON);
       StaticJsonDocument<512> doc;  // 512 to fit Google Sheets URLs
       DeserializationError error = deserializeJson(doc, payload);
       if (error) return;
@@ -150,7 +237,29 @@ static void webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t
       const char* cmd = doc["cmd"];
       if (!cmd) return;
 
-      if (strcmp(cmd, "arm") == 0) {
+      if (strcmp(cmd, "subscribe") == 0 || strcmp(cmd, "unsubscribe") == 0) {
+        // Live binary streams — per-client, so reply only to this client
+        const char* topicName = doc["topic"];
+        StreamTopic topic = streamTopicFromName(topicName);
+        char reply[96];
+        PrintBuffer pb(reply, sizeof(reply));
+        JsonWriter w(pb);
+        w.beginObject();
+        if (topic == STREAM_TOPIC_COUNT) {
+          // Client-supplied — JsonWriter escapes it
+          w.field("stream", topicName ? topicName : "").field("error", "unknown topic");
+        } else {
+          bool sub = (cmd[0] == 's');
+          if (sub) streamSubscribe(num, topic);
+          else streamUnsubscribe(num, topic);
+          w.field("stream", streamTopicName(topic)).field("subscribed", sub);
+        }
+        w.endObject();
+        // Only an overlong unknown name can overflow; drop the echo then
+        if (pb.overflowed()) strlcpy(reply, "{\"error\":\"unknown topic\"}", sizeof(reply));
+        if (webSocket.sendTXT(num, reply)) metricInc(MET_WS_FRAMES_SENT);
+      }
+      else if (strcmp(cmd, "arm") == 0) {
         raceState = ARMED;
         portENTER_CRITICAL(&finishTimerMux);
         startTime_us = 0;
@@ -210,6 +319,7 @@ static void webSocketEvent(uint8_t num, WStype_t type, uint8_t *payload, size_t
 // BROADCAST STATE
 // ============================================================================
 void broadcastState() {
+  HEAP_TAG(JSON);
   StaticJsonDocument<1024> doc;
 
   const char* stateStr;
@@ -240,6 +350,12 @@ void broadcastState() {
     doc["midTrack_scale_mph"] = midTrackSpeed_mps * MPS_TO_MPH * (double)cfg.scale_factor;
   }
 
+  // LiDAR launch timing from the start gate (if measured)
+  if (startTiming.valid) {
+    doc["reaction_s"] = startTiming.reaction_us / 1000000.0;
+    doc["launchToBeam_s"] = startTiming.launchToBeam_us / 1000000.0;
+  }
+
   // LiDAR sensor data (if enabled)
   if (cfg.lidar_enabled) {
     JsonObject lidar = doc.createNestedObject("lidar");
@@ -298,9 +414,37 @@ void broadcastState() {
     }
   }
 
-  String output;
-  serializeJson(doc, output);
-  webSocket.broadcastTXT(output);
+  if (doc.overflowed()) {
+    LOG.println("[WEB] State document overflowed, broadcast skipped");
+    return;
+  }
+
+  // Serialize into a stack buffer rather than a heap String — this runs on
+  // every state change. A finished race is ~420 bytes; with every optional
+  // field, a full Sheets URL and a 31-char car name it is ~940. Only a
+  // longer car name needs the heap.
+  char output[1024];
+  size_t need = measureJson(doc);
+  if (need < sizeof(output)) {
+    size_t len = serializeJson(doc, output, sizeof(output));
+    webSocket.broadcastTXT((uint8_t*)output, len);
+  } else {
+    static size_t warnedLen = 0;
+    if (need > warnedLen) {
+      warnedLen = need;
+      LOG.printf("[WEB] State is %u bytes, over the %u-byte buffer — using the heap\n",
+                 (unsigned)need, (unsigned)sizeof(output));
+    }
+    char* big = (char*)malloc(need + 1);
+    if (!big) {
+      LOG.println("[WEB] No heap for the state broadcast, skipped");
+      return;
+    }
+    size_t len = serializeJson(doc, big, need + 1);
+    webSocket.broadcastTXT((uint8_t*)big, len);
+    free(big);
+  }
+  metricInc(MET_WS_FRAMES_SENT, webSocket.connectedClients());
 }
 
 // ============================================================================
@@ -392,20 +536,17 @@ static void handleApiScan() {
 }
 
 static void handleApiMac() {
-  StaticJsonDocument<128> doc;
-
   // WiFi.macAddress() returns STA MAC which may be 00:00:00:00:00:00 in AP-only mode
   // Use esp_efuse_mac_get_default() to always get the base MAC burned into the chip
   uint8_t baseMac[6];
   esp_efuse_mac_get_default(baseMac);
   char macStr[18];
-  snprintf(macStr, sizeof(macStr), "%02X:%02X:%02X:%02X:%02X:%02X",
-           baseMac[0], baseMac[1], baseMac[2], baseMac[3], baseMac[4], baseMac[5]);
-  doc["mac"] = macStr;
+  formatMac(baseMac, macStr);
 
-  String output;
-  serializeJson(doc, output);
-  server.send(200, "application/json", output);
+  char buf[48];
+  PrintBuffer pb(buf, sizeof(buf));
+  JsonWriter(pb).beginObject().field("mac", macStr).endObject();
+  sendJsonBuffer(pb);
 }
 
 static void handleApiBackup() {
@@ -418,51 +559,46 @@ static void handleApiBackup() {
 // SYSTEM SNAPSHOT API - Full backup/restore of config + garage + history
 // ============================================================================
 static void handleApiSystemBackup() {
-  // Read all three data files from LittleFS
-  String configJson = configToJson();
-
-  String garageJson = "[]";
-  if (LittleFS.exists("/garage.json")) {
-    File f = LittleFS.open("/garage.json", "r");
-    garageJson = f.readString();
-    f.close();
-  }
-
-  String historyJson = "[]";
-  if (LittleFS.exists("/history.json")) {
-    File f = LittleFS.open("/history.json", "r");
-    historyJson = f.readString();
-    f.close();
-  }
-
-  // Build the unified snapshot envelope
-  DynamicJsonDocument doc(16384);
-  doc["snapshot_version"] = 1;
-  doc["firmware_version"] = FIRMWARE_VERSION;
-  doc["hostname"] = cfg.hostname;
-  doc["role"] = cfg.role;
-
-  // Parse config into nested object
-  DynamicJsonDocument configDoc(1536);
-  deserializeJson(configDoc, configJson);
-  doc["config"] = configDoc.as<JsonObject>();
-
-  // Parse garage into nested array
-  DynamicJsonDocument garageDoc(4096);
-  deserializeJson(garageDoc, garageJson);
-  doc["garage"] = garageDoc.as<JsonArray>();
-
-  // Parse history into nested array
-  DynamicJsonDocument historyDoc(8192);
-  deserializeJson(historyDoc, historyJson);
-  doc["history"] = historyDoc.as<JsonArray>();
-
-  String output;
-  serializeJsonPretty(doc, output);
-
+  // Streamed straight into the response: config and garage are copied as
+  // the JSON they already are, and the history goes out a batch at a time,
+  // so a long race log never has to fit in RAM
   server.sendHeader("Content-Disposition", "attachment; filename=masstrap-system-backup.json");
-  server.send(200, "application/json", output);
-  LOG.printf("[WEB] System snapshot exported (%d bytes)\n", output.length());
+  ChunkedResponse out;
+  out.begin(200, "application/json");
+  JsonWriter w(out);
+  w.beginObject()
+   .field("snapshot_version", 1)
+   .field("firmware_version", FIRMWARE_VERSION)
+   .field("hostname", cfg.hostname)
+   .field("role", cfg.role);
+
+  w.rawField("config");
+  out.print(configToJson());
+
+  w.rawField("garage");
+  File f;
+  if (LittleFS.exists("/garage.json")) f = LittleFS.open("/garage.json", "r");
+  if (f && f.size() > 0) {
+    uint8_t buf[256];
+    size_t n;
+    while ((n = f.read(buf, sizeof(buf))) > 0) out.write(buf, n);
+  } else {
+    out.print("[]");
+  }
+  if (f) f.close();
+
+  w.rawField("history");
+  RaceLogCursor cur = { 0, 0, UINT32_MAX, true };
+  {
+    StorageLock lock;
+    cur.upTo = raceLogLastSeq();
+  }
+  out.print('[');
+  uint32_t entries = sendHistoryBatches(out, cur);
+  out.print(']');
+  w.endObject();
+  out.end();
+  LOG.printf("[WEB] System snapshot exported (%u history entries)\n", entries);
 }
 
 static void handleApiSystemRestore() {
@@ -474,7 +610,7 @@ static void handleApiSystemRestore() {
     return;
   }
 
-  DynamicJsonDocument doc(16384);
+  DynamicJsonDocument doc(16384 + body.length() * 2);
   DeserializationError err = deserializeJson(doc, body);
   if (err) {
     server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
@@ -500,7 +636,8 @@ static void handleApiSystemRestore() {
     String configStr;
     serializeJson(configObj, configStr);
     File f = LittleFS.open(CONFIG_FILE, "w");
-    if (f) { f.print(configStr); f.close(); }
+    if (f) { metricInc(MET_FS_BYTES_WRITTEN, f.print(configStr)); f.close(); }
+    configInvalidateImage();
   }
 
   // 2. Restore garage
@@ -509,16 +646,14 @@ static void handleApiSystemRestore() {
     String garageStr;
     serializeJson(garageArr, garageStr);
     File f = LittleFS.open("/garage.json", "w");
-    if (f) { f.print(garageStr); f.close(); }
+    if (f) { metricInc(MET_FS_BYTES_WRITTEN, f.print(garageStr)); f.close(); }
   }
 
   // 3. Restore history
   JsonArray historyArr = doc["history"];
   if (!historyArr.isNull()) {
-    String historyStr;
-    serializeJson(historyArr, historyStr);
-    File f = LittleFS.open("/history.json", "w");
-    if (f) { f.print(historyStr); f.close(); }
+    StorageLock lock;
+    raceLogReplace(historyArr);
   }
 
   LOG.printf("[WEB] System snapshot restored (skip_network=%s). Rebooting...\n",
@@ -560,8 +695,9 @@ static void handleApiRestore() {
     server.send(500, "application/json", "{\"error\":\"Failed to write config\"}");
     return;
   }
-  f.print(body);
+  metricInc(MET_FS_BYTES_WRITTEN, f.print(body));
   f.close();
+  configInvalidateImage();
 
   server.send(200, "application/json", "{\"status\":\"ok\",\"message\":\"Config restored. Rebooting...\"}");
   server.client().flush();
@@ -582,25 +718,26 @@ static void handleApiReset() {
 }
 
 static void handleApiInfo() {
-  StaticJsonDocument<512> doc;
-  doc["project"] = PROJECT_NAME;
-  doc["firmware"] = FIRMWARE_VERSION;
-  doc["role"] = cfg.role;
-  doc["hostname"] = cfg.hostname;
-  doc["uptime_s"] = millis() / 1000;
-  doc["free_heap"] = ESP.getFreeHeap();
-  doc["wifi_rssi"] = WiFi.RSSI();
-  doc["wifi_channel"] = WiFi.channel();
-  doc["peer_connected"] = peerConnected;
-  doc["peer_count"] = peerCount;
-  doc["ip"] = WiFi.localIP().toString();
-  doc["audio_enabled"] = cfg.audio_enabled;
-  doc["lidar_enabled"] = cfg.lidar_enabled;
-  doc["clock_offset_us"] = (double)clockOffset_us;
-
-  String output;
-  serializeJson(doc, output);
-  server.send(200, "application/json", output);
+  char buf[512];
+  PrintBuffer pb(buf, sizeof(buf));
+  JsonWriter w(pb);
+  w.beginObject()
+   .field("project", PROJECT_NAME)
+   .field("firmware", FIRMWARE_VERSION)
+   .field("role", cfg.role)
+   .field("hostname", cfg.hostname)
+   .field("uptime_s", millis() / 1000)
+   .field("free_heap", ESP.getFreeHeap())
+   .field("wifi_rssi", WiFi.RSSI())
+   .field("wifi_channel", WiFi.channel())
+   .field("peer_connected", peerConnected)
+   .field("peer_count", peerCount)
+   .field("ip", WiFi.localIP())
+   .field("audio_enabled", cfg.audio_enabled)
+   .field("lidar_enabled", cfg.lidar_enabled)
+   .field("clock_offset_us", clockOffset_us)
+   .endObject();
+  sendJsonBuffer(pb);
 }
 
 // WiFi diagnostic status — extern from MASS_Trap.ino
@@ -608,41 +745,43 @@ extern bool wifiConnected;
 extern char wifiFailReason[64];
 
 static void handleApiWifiStatus() {
-  StaticJsonDocument<256> doc;
-  doc["connected"] = (WiFi.status() == WL_CONNECTED);
-  doc["ssid"] = cfg.wifi_ssid;
-  doc["ip"] = WiFi.localIP().toString();
-  doc["rssi"] = WiFi.RSSI();
-  doc["channel"] = WiFi.channel();
-  doc["mode"] = (WiFi.getMode() == WIFI_AP) ? "AP" :
-                (WiFi.getMode() == WIFI_STA) ? "STA" :
-                (WiFi.getMode() == WIFI_AP_STA) ? "AP_STA" : "OFF";
+  char buf[384];
+  PrintBuffer pb(buf, sizeof(buf));
+  JsonWriter w(pb);
+  w.beginObject()
+   .field("connected", WiFi.status() == WL_CONNECTED)
+   .field("ssid", cfg.wifi_ssid)
+   .field("ip", WiFi.localIP())
+   .field("rssi", WiFi.RSSI())
+   .field("channel", WiFi.channel())
+   .field("mode", (WiFi.getMode() == WIFI_AP) ? "AP" :
+                  (WiFi.getMode() == WIFI_STA) ? "STA" :
+                  (WiFi.getMode() == WIFI_AP_STA) ? "AP_STA" : "OFF");
   if (strlen(wifiFailReason) > 0) {
-    doc["fail_reason"] = wifiFailReason;
+    w.field("fail_reason", wifiFailReason);
   }
-
-  String output;
-  serializeJson(doc, output);
-  server.send(200, "application/json", output);
+  w.endObject();
+  sendJsonBuffer(pb);
 }
 
 static void handleApiVersion() {
-  StaticJsonDocument<256> doc;
-  doc["firmware"] = FIRMWARE_VERSION;
-  doc["web_ui"] = WEB_UI_VERSION;
-  doc["build_date"] = BUILD_DATE;
-  doc["build_time"] = BUILD_TIME;
+  char buf[256];
+  PrintBuffer pb(buf, sizeof(buf));
+  JsonWriter w(pb);
+  w.beginObject()
+   .field("firmware", FIRMWARE_VERSION)
+   .field("web_ui", WEB_UI_VERSION)
+   .field("build_date", BUILD_DATE)
+   .field("build_time", BUILD_TIME);
 #if CONFIG_IDF_TARGET_ESP32S3
-  doc["board"] = "ESP32-S3";
+  w.field("board", "ESP32-S3");
 #elif CONFIG_IDF_TARGET_ESP32
-  doc["board"] = "ESP32";
+  w.field("board", "ESP32");
 #else
-  doc["board"] = "Unknown";
+  w.field("board", "Unknown");
 #endif
-
-  String output;
-  serializeJson(doc, output);
-  server.send(200, "application/json", output);
+  w.endObject();
+  sendJsonBuffer(pb);
 }
 
 // ============================================================================
@@ -653,165 +792,208 @@ static void handleApiVersion() {
 // Available in BOTH normal mode and setup mode — helps builders verify wiring
 // before and after configuration.
 static void handleApiDiagnostics() {
-  DynamicJsonDocument doc(4096);
+  // Streamed straight into the chunked response — no document, no String
+  ChunkedResponse out;
+  out.begin(200, "application/json");
+  JsonWriter w(out);
+  w.beginObject();
 
   // ---- SYSTEM INFO ----
-  JsonObject sys = doc.createNestedObject("system");
-  sys["firmware"] = FIRMWARE_VERSION;
-  sys["role"] = cfg.role;
-  sys["hostname"] = cfg.hostname;
-  sys["uptime_s"] = millis() / 1000;
-  sys["uptime_str"] = String(millis() / 3600000) + "h " +
-                      String((millis() / 60000) % 60) + "m " +
-                      String((millis() / 1000) % 60) + "s";
+  unsigned long ms = millis();
+  char uptimeStr[24];
+  snprintf(uptimeStr, sizeof(uptimeStr), "%luh %lum %lus",
+           ms / 3600000, (ms / 60000) % 60, (ms / 1000) % 60);
+  w.beginObject("system")
+   .field("firmware", FIRMWARE_VERSION)
+   .field("role", cfg.role)
+   .field("hostname", cfg.hostname)
+   .field("uptime_s", ms / 1000)
+   .field("uptime_str", uptimeStr);
 #if CONFIG_IDF_TARGET_ESP32S3
-  sys["board"] = "ESP32-S3";
+  w.field("board", "ESP32-S3");
 #elif CONFIG_IDF_TARGET_ESP32
-  sys["board"] = "ESP32";
+  w.field("board", "ESP32");
 #else
-  sys["board"] = "Unknown";
+  w.field("board", "Unknown");
 #endif
-  sys["cpu_freq_mhz"] = ESP.getCpuFreqMHz();
-  sys["flash_size"] = ESP.getFlashChipSize();
-  sys["flash_speed"] = ESP.getFlashChipSpeed();
-  sys["sdk"] = ESP.getSdkVersion();
+  w.field("cpu_freq_mhz", ESP.getCpuFreqMHz())
+   .field("flash_size", ESP.getFlashChipSize())
+   .field("flash_speed", ESP.getFlashChipSpeed())
+   .field("sdk", ESP.getSdkVersion())
+   .endObject();
+
+  // ---- BOOT ----
+  // When each bring-up phase finished (boot_timing.h)
+  w.beginObject("boot");
+  bootTimingWrite(w);
+  w.endObject();
 
   // ---- MEMORY ----
-  JsonObject mem = doc.createNestedObject("memory");
-  mem["free_heap"] = ESP.getFreeHeap();
-  mem["min_free_heap"] = ESP.getMinFreeHeap();
-  mem["max_alloc_heap"] = ESP.getMaxAllocHeap();
-  mem["total_heap"] = ESP.getHeapSize();
-  mem["heap_pct_free"] = (ESP.getHeapSize() > 0)
-    ? (int)(100.0 * ESP.getFreeHeap() / ESP.getHeapSize()) : 0;
+  // heap_frag_pct: how much of the free heap is unusable for one allocation
+  uint32_t freeHeap = ESP.getFreeHeap();
+  uint32_t maxAlloc = ESP.getMaxAllocHeap();
+  w.beginObject("memory")
+   .field("free_heap", freeHeap)
+   .field("min_free_heap", ESP.getMinFreeHeap())
+   .field("max_alloc_heap", maxAlloc)
+   .field("total_heap", ESP.getHeapSize())
+   .field("heap_pct_free", (ESP.getHeapSize() > 0)
+     ? (int)(100.0 * freeHeap / ESP.getHeapSize()) : 0)
+   .field("heap_frag_pct", heapFragPct(freeHeap, maxAlloc))
+   .field("log_drain_stack_free", serialTee.drainStackFree());
 #ifdef BOARD_HAS_PSRAM
-  mem["psram_total"] = ESP.getPsramSize();
-  mem["psram_free"] = ESP.getFreePsram();
-  mem["psram_pct_free"] = (ESP.getPsramSize() > 0)
-    ? (int)(100.0 * ESP.getFreePsram() / ESP.getPsramSize()) : 0;
+  w.field("psram_total", ESP.getPsramSize())
+   .field("psram_free", ESP.getFreePsram())
+   .field("psram_pct_free", (ESP.getPsramSize() > 0)
+     ? (int)(100.0 * ESP.getFreePsram() / ESP.getPsramSize()) : 0);
 #else
-  mem["psram_total"] = 0;
-  mem["psram_free"] = 0;
+  w.field("psram_total", 0)
+   .field("psram_free", 0);
 #endif
+  w.endObject();
 
   // ---- FILESYSTEM ----
-  JsonObject fs = doc.createNestedObject("filesystem");
-  fs["total_bytes"] = LittleFS.totalBytes();
-  fs["used_bytes"] = LittleFS.usedBytes();
-  fs["free_bytes"] = LittleFS.totalBytes() - LittleFS.usedBytes();
-  fs["pct_used"] = (LittleFS.totalBytes() > 0)
-    ? (int)(100.0 * LittleFS.usedBytes() / LittleFS.totalBytes()) : 0;
+  size_t fsTotal = LittleFS.totalBytes();
+  size_t fsUsed = LittleFS.usedBytes();
+  w.beginObject("filesystem")
+   .field("total_bytes", fsTotal)
+   .field("used_bytes", fsUsed)
+   .field("free_bytes", fsTotal - fsUsed)
+   .field("pct_used", (fsTotal > 0) ? (int)(100.0 * fsUsed / fsTotal) : 0)
+   .endObject();
+
+  // ---- STORAGE QUEUE ----
+  // Write-behind jobs (storage.cpp): depth, drops, wait and write latency
+  w.beginObject("storage");
+  storageWrite(w);
+  w.endObject();
 
   // ---- WIFI ----
-  JsonObject wifi = doc.createNestedObject("wifi");
-  wifi["mode"] = (WiFi.getMode() == WIFI_AP) ? "AP" :
-                 (WiFi.getMode() == WIFI_STA) ? "STA" :
-                 (WiFi.getMode() == WIFI_AP_STA) ? "AP_STA" : "OFF";
-  wifi["sta_connected"] = (WiFi.status() == WL_CONNECTED);
-  wifi["sta_ip"] = WiFi.localIP().toString();
-  wifi["sta_ssid"] = cfg.wifi_ssid;
-  wifi["rssi"] = WiFi.RSSI();
-  wifi["signal_quality"] = constrain(2 * (WiFi.RSSI() + 100), 0, 100);  // -100=0%, -50=100%
-  wifi["channel"] = WiFi.channel();
-  wifi["mac_sta"] = WiFi.macAddress();
-  wifi["ap_ip"] = WiFi.softAPIP().toString();
-  wifi["ap_clients"] = WiFi.softAPgetStationNum();
+  uint8_t staMac[6];
+  char staMacStr[18];
+  WiFi.macAddress(staMac);
+  formatMac(staMac, staMacStr);
+  w.beginObject("wifi")
+   .field("mode", (WiFi.getMode() == WIFI_AP) ? "AP" :
+                  (WiFi.getMode() == WIFI_STA) ? "STA" :
+                  (WiFi.getMode() == WIFI_AP_STA) ? "AP_STA" : "OFF")
+   .field("sta_connected", WiFi.status() == WL_CONNECTED)
+   .field("sta_ip", WiFi.localIP())
+   .field("sta_ssid", cfg.wifi_ssid)
+   .field("rssi", WiFi.RSSI())
+   .field("signal_quality", constrain(2 * (WiFi.RSSI() + 100), 0, 100))  // -100=0%, -50=100%
+   .field("channel", WiFi.channel())
+   .field("mac_sta", staMacStr)
+   .field("ap_ip", WiFi.softAPIP())
+   .field("ap_clients", WiFi.softAPgetStationNum())
+   .endObject();
 
   // ---- ESP-NOW / PEERS ----
-  JsonObject radio = doc.createNestedObject("espnow");
-  radio["peer_connected"] = peerConnected;
-  radio["peer_count"] = peerCount;
-  radio["clock_offset_us"] = (double)clockOffset_us;  // Cast for JSON precision
-  JsonArray peerList = radio.createNestedArray("peers");
+  w.beginObject("espnow")
+   .field("peer_connected", peerConnected)
+   .field("peer_count", peerCount)
+   .field("clock_offset_us", clockOffset_us)
+   .beginArray("peers");
   for (int i = 0; i < peerCount && i < MAX_PEERS; i++) {
-    JsonObject p = peerList.createNestedObject();
-    p["role"] = peers[i].role;
-    p["hostname"] = peers[i].hostname;
-    p["mac"] = formatMac(peers[i].mac);
-    p["paired"] = peers[i].paired;
+    char mac[18];
+    formatMac(peers[i].mac, mac);
     unsigned long ago = millis() - peers[i].lastSeen;
-    p["last_seen_ms"] = ago;
-    p["status"] = (ago < PEER_ONLINE_THRESH_MS) ? "ONLINE" :
-                  (ago < PEER_STALE_THRESH_MS) ? "STALE" : "OFFLINE";
-  }
+    w.beginObject()
+     .field("role", peers[i].role)
+     .field("hostname", peers[i].hostname)
+     .field("mac", mac)
+     .field("paired", peers[i].paired)
+     .field("last_seen_ms", ago)
+     .field("status", (ago < PEER_ONLINE_THRESH_MS) ? "ONLINE" :
+                      (ago < PEER_STALE_THRESH_MS) ? "STALE" : "OFFLINE")
+     .endObject();
+  }
+  w.endArray().endObject();
 
   // ---- RACE STATE ----
-  JsonObject race = doc.createNestedObject("race");
   const char* stateNames[] = {"IDLE", "ARMED", "RACING", "FINISHED"};
-  race["state"] = stateNames[(int)raceState];
-  race["dry_run"] = dryRunMode;
-  race["total_runs"] = totalRuns;
-  race["current_car"] = currentCar;
-  race["current_weight"] = currentWeight;
+  w.beginObject("race")
+   .field("state", stateNames[(int)raceState])
+   .field("dry_run", dryRunMode)
+   .field("total_runs", totalRuns)
+   .field("current_car", currentCar)
+   .field("current_weight", currentWeight)
+   .endObject();
 
   // ---- PIN CONFIGURATION ----
-  JsonObject pins = doc.createNestedObject("pins");
+  w.beginObject("pins");
 
   // IR Sensor (primary)
-  JsonObject irPin = pins.createNestedObject("ir_sensor");
-  irPin["gpio"] = cfg.sensor_pin;
-  irPin["configured"] = (cfg.sensor_pin > 0);
+  w.beginObject("ir_sensor")
+   .field("gpio", cfg.sensor_pin)
+   .field("configured", cfg.sensor_pin > 0);
   if (cfg.sensor_pin > 0) {
     pinMode(cfg.sensor_pin, INPUT);
-    irPin["state"] = digitalRead(cfg.sensor_pin) ? "HIGH" : "LOW";
-    irPin["expected_idle"] = "HIGH (beam unbroken)";
-    irPin["ok"] = (digitalRead(cfg.sensor_pin) == HIGH);
+    w.field("state", digitalRead(cfg.sensor_pin) ? "HIGH" : "LOW")
+     .field("expected_idle", "HIGH (beam unbroken)")
+     .field("ok", digitalRead(cfg.sensor_pin) == HIGH);
   }
+  w.endObject();
 
   // IR Sensor 2 (speed trap)
   if (cfg.sensor_pin_2 > 0) {
-    JsonObject ir2Pin = pins.createNestedObject("ir_sensor_2");
-    ir2Pin["gpio"] = cfg.sensor_pin_2;
     pinMode(cfg.sensor_pin_2, INPUT);
-    ir2Pin["state"] = digitalRead(cfg.sensor_pin_2) ? "HIGH" : "LOW";
-    ir2Pin["expected_idle"] = "HIGH (beam unbroken)";
-    ir2Pin["ok"] = (digitalRead(cfg.sensor_pin_2) == HIGH);
+    w.beginObject("ir_sensor_2")
+     .field("gpio", cfg.sensor_pin_2)
+     .field("state", digitalRead(cfg.sensor_pin_2) ? "HIGH" : "LOW")
+     .field("expected_idle", "HIGH (beam unbroken)")
+     .field("ok", digitalRead(cfg.sensor_pin_2) == HIGH)
+     .endObject();
   }
 
   // LED pin
-  JsonObject ledPin = pins.createNestedObject("led");
-  ledPin["gpio"] = cfg.led_pin;
-  ledPin["configured"] = (cfg.led_pin > 0);
+  w.beginObject("led")
+   .field("gpio", cfg.led_pin)
+   .field("configured", cfg.led_pin > 0)
+   .endObject();
 
   // Audio pins
   if (cfg.audio_enabled) {
-    JsonObject audio = pins.createNestedObject("audio");
-    audio["enabled"] = true;
-    audio["bclk_gpio"] = cfg.i2s_bclk_pin;
-    audio["lrc_gpio"] = cfg.i2s_lrc_pin;
-    audio["dout_gpio"] = cfg.i2s_dout_pin;
-    audio["volume"] = cfg.audio_volume;
-    audio["playing"] = isPlaying();
+    w.beginObject("audio")
+     .field("enabled", true)
+     .field("bclk_gpio", cfg.i2s_bclk_pin)
+     .field("lrc_gpio", cfg.i2s_lrc_pin)
+     .field("dout_gpio", cfg.i2s_dout_pin)
+     .field("volume", cfg.audio_volume)
+     .field("playing", isPlaying())
+     .field("cues_scheduled", audioCuesScheduled());
+    audioWriteStats(w);
+    w.endObject();
   }
 
   // LiDAR pins
   if (cfg.lidar_enabled) {
-    JsonObject lidar = pins.createNestedObject("lidar");
-    lidar["enabled"] = true;
-    lidar["rx_gpio"] = cfg.lidar_rx_pin;
-    lidar["tx_gpio"] = cfg.lidar_tx_pin;
-    lidar["threshold_mm"] = cfg.lidar_threshold_mm;
-    lidar["distance_mm"] = getDistanceMM();
     const char* lidarStates[] = {"NO_CAR", "CAR_STAGED", "CAR_LAUNCHED"};
-    lidar["state"] = lidarStates[(int)getLidarState()];
-    lidar["ok"] = (getDistanceMM() > 0);  // 0 = no reading = possible wiring issue
-  }
+    w.beginObject("lidar")
+     .field("enabled", true)
+     .field("rx_gpio", cfg.lidar_rx_pin)
+     .field("tx_gpio", cfg.lidar_tx_pin)
+     .field("threshold_mm", cfg.lidar_threshold_mm)
+     .field("distance_mm", getDistanceMM())
+     .field("state", lidarStates[(int)getLidarState()])
+     .field("ok", getDistanceMM() > 0);  // 0 = no reading = possible wiring issue
+    lidarWriteStats(w);
+    w.endObject();
+  }
+  w.endObject();  // pins
 
   // ---- I2C BUS SCAN ----
   // Scans the default I2C bus (SDA/SCL from board defaults) for connected devices.
   // This catches BNO055, OLED displays, BME280, or any other I2C peripheral.
-  JsonObject i2c = doc.createNestedObject("i2c");
+  w.beginObject("i2c").beginArray("devices");
   Wire.begin();  // Initialize with default SDA/SCL for the board
-  JsonArray devices = i2c.createNestedArray("devices");
   int deviceCount = 0;
   for (uint8_t addr = 1; addr < 127; addr++) {
     Wire.beginTransmission(addr);
     uint8_t err = Wire.endTransmission();
     if (err == 0) {
-      JsonObject dev = devices.createNestedObject();
       char addrHex[8];
       snprintf(addrHex, sizeof(addrHex), "0x%02X", addr);
-      dev["address"] = addrHex;
       // Identify well-known addresses
       const char* name = "Unknown";
       if (addr == 0x28 || addr == 0x29) name = "BNO055 IMU";
@@ -823,93 +1005,178 @@ static void handleApiDiagnostics() {
       else if (addr == 0x27 || addr == 0x3F) name = "PCF8574 I/O Expander";
       else if (addr == 0x5A) name = "MLX90614 IR Temp";
       else if (addr == 0x20) name = "PCF8574A I/O Expander";
-      dev["device"] = name;
+      w.beginObject().field("address", addrHex).field("device", name).endObject();
       deviceCount++;
     }
   }
   Wire.end();  // Release I2C bus
-  i2c["device_count"] = deviceCount;
+  w.endArray().field("device_count", deviceCount).endObject();
 
   // ---- WLED INTEGRATION ----
   if (strlen(cfg.wled_host) > 0) {
-    JsonObject wled = doc.createNestedObject("wled");
-    wled["host"] = cfg.wled_host;
-    // Quick reachability check (50ms timeout — don't block long)
+    // Quick reachability check (500ms timeout — don't block long)
+    char url[96];
+    snprintf(url, sizeof(url), "http://%s/json/info", cfg.wled_host);
     HTTPClient http;
-    http.begin("http://" + String(cfg.wled_host) + "/json/info");
+    http.begin(url);
     http.setTimeout(500);
     int code = http.GET();
-    wled["reachable"] = (code == 200);
-    wled["http_code"] = code;
     http.end();
+    w.beginObject("wled")
+     .field("host", cfg.wled_host)
+     .field("reachable", code == 200)
+     .field("http_code", code)
+     .endObject();
   }
 
   // ---- CONFIG SUMMARY ----
-  JsonObject config = doc.createNestedObject("config");
-  config["configured"] = cfg.configured;
-  config["version"] = cfg.version;
-  config["network_mode"] = cfg.network_mode;
-  config["track_length_m"] = cfg.track_length_m;
-  config["scale_factor"] = cfg.scale_factor;
-  config["units"] = cfg.units;
-  config["audio_enabled"] = cfg.audio_enabled;
-  config["lidar_enabled"] = cfg.lidar_enabled;
-  config["has_wled"] = (strlen(cfg.wled_host) > 0);
-  config["has_viewer_auth"] = (strlen(cfg.viewer_password) > 0);
+  w.beginObject("config")
+   .field("configured", cfg.configured)
+   .field("version", cfg.version)
+   .field("network_mode", cfg.network_mode)
+   .field("track_length_m", cfg.track_length_m)
+   .field("scale_factor", cfg.scale_factor)
+   .field("units", cfg.units)
+   .field("audio_enabled", cfg.audio_enabled)
+   .field("lidar_enabled", cfg.lidar_enabled)
+   .field("has_wled", strlen(cfg.wled_host) > 0)
+   .field("has_viewer_auth", strlen(cfg.viewer_password) > 0)
+   .endObject();
+
+  // ---- LOOP PROFILE ----
+  // Per-section timing of loop() since boot or the last /api/diagnostics/reset
+  w.beginObject("profile");
+  profWrite(w);
+  w.endObject();
 
   // ---- VERDICT ----
   // Quick pass/fail summary for the wiring wizard "Verify Connection" button
-  JsonObject verdict = doc.createNestedObject("verdict");
+  w.beginObject("verdict").beginArray("issues");
   int issues = 0;
-  JsonArray problems = verdict.createNestedArray("issues");
+  char problem[128];
 
   // Check IR sensor
   if (cfg.sensor_pin > 0) {
     pinMode(cfg.sensor_pin, INPUT);
     if (digitalRead(cfg.sensor_pin) == LOW) {
-      problems.add("IR sensor (GPIO " + String(cfg.sensor_pin) + ") reads LOW — beam blocked or disconnected");
+      snprintf(problem, sizeof(problem),
+               "IR sensor (GPIO %d) reads LOW — beam blocked or disconnected", cfg.sensor_pin);
+      w.value(problem);
       issues++;
     }
   }
 
   // Check memory health
   if (ESP.getFreeHeap() < 50000) {
-    problems.add("Low heap memory: " + String(ESP.getFreeHeap()) + " bytes free");
+    snprintf(problem, sizeof(problem), "Low heap memory: %u bytes free", (unsigned)ESP.getFreeHeap());
+    w.value(problem);
     issues++;
   }
 
   // Check filesystem
-  if (LittleFS.totalBytes() - LittleFS.usedBytes() < 100000) {
-    problems.add("Low filesystem space: " + String(LittleFS.totalBytes() - LittleFS.usedBytes()) + " bytes free");
+  if (fsTotal - fsUsed < 100000) {
+    snprintf(problem, sizeof(problem), "Low filesystem space: %u bytes free", (unsigned)(fsTotal - fsUsed));
+    w.value(problem);
     issues++;
   }
 
   // Check WiFi signal
   if (WiFi.status() == WL_CONNECTED && WiFi.RSSI() < -80) {
-    problems.add("Weak WiFi signal: " + String(WiFi.RSSI()) + " dBm");
+    snprintf(problem, sizeof(problem), "Weak WiFi signal: %d dBm", (int)WiFi.RSSI());
+    w.value(problem);
     issues++;
   }
 
   // Check LiDAR if enabled
   if (cfg.lidar_enabled && getDistanceMM() == 0) {
-    problems.add("LiDAR enabled but no reading — check RX/TX wiring (GPIO " +
-                 String(cfg.lidar_rx_pin) + "/" + String(cfg.lidar_tx_pin) + ")");
+    snprintf(problem, sizeof(problem),
+             "LiDAR enabled but no reading — check RX/TX wiring (GPIO %d/%d)",
+             cfg.lidar_rx_pin, cfg.lidar_tx_pin);
+    w.value(problem);
     issues++;
   }
 
-  verdict["issue_count"] = issues;
-  verdict["status"] = (issues == 0) ? "ALL CLEAR" : "ISSUES DETECTED";
+  w.endArray()
+   .field("issue_count", issues)
+   .field("status", (issues == 0) ? "ALL CLEAR" : "ISSUES DETECTED")
+   .endObject();
 
-  String output;
-  serializeJson(doc, output);
-  server.send(200, "application/json", output);
+  w.endObject();
+  out.end();
+}
+
+// Restart the loop profile so a test run is measured on its own
+static void handleApiDiagnosticsReset() {
+  if (!requireAuth()) return;
+  profReset();
+  server.send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// ============================================================================
+// HEAP DIAGNOSTICS — Per-subsystem allocation counters and the soak test
+// ============================================================================
+static void handleApiHeap() {
+  ChunkedResponse out;
+  out.begin(200, "application/json");
+  JsonWriter w(out);
+  w.beginObject();
+  heapTrackWrite(w);
+  w.beginObject("soak");
+  soakWrite(w);
+  w.endObject();
+  w.endObject();
+  out.end();
+}
+
+static void handleApiHeapReset() {
+  if (!requireAuth()) return;
+  heapTrackReset();
+  server.send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// POST {"minutes":240,"race_interval_s":30,"http_interval_ms":500} starts
+// a soak run (all fields optional); DELETE stops it early
+static void handleApiHeapSoak() {
+  if (!requireAuth()) return;
+  if (server.method() == HTTP_DELETE) {
+    soakStop();
+    server.send(200, "application/json", "{\"status\":\"stopped\"}");
+    return;
+  }
+  StaticJsonDocument<128> doc;
+  if (server.hasArg("plain") && server.arg("plain").length() > 0) {
+    if (deserializeJson(doc, server.arg("plain"))) {
+      server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
+      return;
+    }
+  }
+  uint32_t minutes = doc["minutes"] | SOAK_DEFAULT_MINUTES;
+  uint32_t raceS = doc["race_interval_s"] | SOAK_DEFAULT_RACE_S;
+  uint32_t httpMs = doc["http_interval_ms"] | SOAK_DEFAULT_HTTP_MS;
+  bool storage = doc["storage"] | false;   // Races go to the real logs
+  if (soakRunning()) {
+    server.send(409, "application/json", "{\"error\":\"Soak test already running\"}");
+    return;
+  }
+  if (!soakStart(minutes, raceS, httpMs, storage)) {
+    char err[112];
+    snprintf(err, sizeof(err),
+             "{\"error\":\"minutes must be 1-%d, race_interval_s >= 10, http_interval_ms >= 50\"}",
+             SOAK_MAX_MINUTES);
+    server.send(400, "application/json", err);
+    return;
+  }
+  server.send(200, "application/json", "{\"status\":\"started\"}");
 }
 
 // ============================================================================
 // PEER DISCOVERY API — Brother's Six Protocol
 // ============================================================================
 static void handleApiPeers() {
-  server.send(200, "application/json", getPeersJson());
+  ChunkedResponse out;
+  out.begin(200, "application/json");
+  writePeersJson(out);
+  out.end();
 }
 
 static void handleApiPeersForget() {
@@ -1037,178 +1304,349 @@ static void handleApiPeerCommand() {
 }
 
 // ============================================================================
-// GARAGE API - Persistent car storage on ESP32 filesystem
-// POST validation: must be JSON array of car objects with valid types
+// STREAMED JSON BODIES
+// GET responses are written to the socket in chunks as they are produced
+// (ChunkedResponse, above), and POST bodies are validated by a SAX parser (json_stream.h) as they arrive and
+// spooled to a temp file. Peak heap is a few hundred bytes regardless of how
+// many cars or races the document holds.
 // ============================================================================
-static void handleApiGarage() {
-  if (server.method() == HTTP_GET) {
-    if (LittleFS.exists("/garage.json")) {
-      File f = LittleFS.open("/garage.json", "r");
-      String content = f.readString();
-      f.close();
-      server.send(200, "application/json", content);
-    } else {
-      server.send(200, "application/json", "[]");
+static bool postAuthorized = false;
+static bool postWriteFailed = false;
+static File postSpool;
+
+// Raw upload callback shared by the streamed POST endpoints: auth is checked
+// once the headers are in, then every chunk goes through the validator and,
+// while it is still valid, into the spool file.
+static void spoolPostBody(JsonStreamParser& parser, const char* spoolPath) {
+  HTTPRaw& raw = server.raw();
+  if (raw.status == RAW_START) {
+    parser.reset();
+    postWriteFailed = false;
+    postAuthorized = strlen(cfg.ota_password) == 0 ||
+                     server.header("X-API-Key") == cfg.ota_password;
+    if (postAuthorized) {
+      postSpool = LittleFS.open(spoolPath, "w");
+      if (!postSpool) postWriteFailed = true;
     }
-  }
-  else if (server.method() == HTTP_POST) {
-    if (!requireAuth()) return;
-    String body = server.arg("plain");
-    if (body.length() == 0) {
-      server.send(400, "application/json", "{\"error\":\"Empty body\"}");
-      return;
+  } else if (raw.status == RAW_WRITE) {
+    if (!postAuthorized || !parser.feed(raw.buf, raw.currentSize)) return;
+    if (postSpool) {
+      size_t written = postSpool.write(raw.buf, raw.currentSize);
+      metricInc(MET_FS_BYTES_WRITTEN, written);
+      if (written != raw.currentSize) postWriteFailed = true;
     }
+  } else if (raw.status == RAW_END || raw.status == RAW_ABORTED) {
+    if (postSpool) postSpool.close();
+    if (raw.status == RAW_ABORTED) LittleFS.remove(spoolPath);
+  }
+}
 
-    // Validate JSON structure
-    DynamicJsonDocument doc(8192);
-    DeserializationError err = deserializeJson(doc, body);
-    if (err) {
-      server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
-      return;
+// Completion side of a streamed POST. Sends the error response and removes
+// the spool file unless the body was authorized, complete and valid.
+static bool finishPostBody(JsonStreamParser& parser, const char* spoolPath) {
+  bool ok = false;
+  if (!requireAuth()) {
+    // 401 already sent
+  } else if (!parser.finish()) {
+    String msg = String("{\"error\":\"") + parser.error() + "\"}";
+    server.send(400, "application/json", msg);
+  } else if (postWriteFailed) {
+    server.send(500, "application/json", "{\"error\":\"Failed to store upload\"}");
+  } else {
+    ok = true;
+  }
+  if (!ok) LittleFS.remove(spoolPath);
+  parser.reset();
+  return ok;
+}
+
+static inline bool keyIs(const char* key, const char* name) {
+  return key && strcmp(key, name) == 0;
+}
+
+// ============================================================================
+// GARAGE API - Persistent car storage on ESP32 filesystem
+// POST validation: must be JSON array of car objects with valid types
+// ============================================================================
+#define GARAGE_FILE       "/garage.json"
+#define GARAGE_SPOOL      "/garage.json.tmp"
+
+class GarageSchema : public JsonSaxHandler {
+public:
+  bool onStart(uint8_t depth, bool isArray, const char* key, uint32_t offset) override {
+    if (depth == 1 && !isArray) return reject("Must be array");
+    if (depth == 2 && isArray) return reject("Array items must be objects");
+    if (depth == 3) {
+      if (keyIs(key, "name")) return reject("name must be string");
+      if (keyIs(key, "weight")) return reject("weight must be numeric");
+      inStats = !isArray && keyIs(key, "stats");
     }
-    if (!doc.is<JsonArray>()) {
-      server.send(400, "application/json", "{\"error\":\"Must be array\"}");
-      return;
+    if (depth == 4 && inStats) {
+      if (keyIs(key, "bestTime")) return reject("bestTime must be numeric or null");
+      if (keyIs(key, "bestSpeed")) return reject("bestSpeed must be numeric");
     }
-    JsonArray arr = doc.as<JsonArray>();
-    if (arr.size() > 50) {
-      server.send(400, "application/json", "{\"error\":\"Max 50 cars\"}");
-      return;
+    return true;
+  }
+  bool onEnd(uint8_t depth, bool isArray) override {
+    if (depth == 3) inStats = false;
+    return true;
+  }
+  bool onScalar(uint8_t depth, const char* key, JsonTokenType type, double number) override {
+    if (depth == 0) return reject("Must be array");
+    if (depth == 1) return reject("Array items must be objects");
+    if (depth == 2) {
+      if (keyIs(key, "name") && type != JSON_TOK_STRING) return reject("name must be string");
+      if (keyIs(key, "weight") && type != JSON_TOK_NUMBER) return reject("weight must be numeric");
     }
-
-    // Validate each car object
-    for (JsonVariant item : arr) {
-      if (!item.is<JsonObject>()) {
-        server.send(400, "application/json", "{\"error\":\"Array items must be objects\"}");
-        return;
-      }
-      JsonObject car = item.as<JsonObject>();
-      // name must be string
-      if (car.containsKey("name") && !car["name"].is<const char*>()) {
-        server.send(400, "application/json", "{\"error\":\"name must be string\"}");
-        return;
-      }
-      // weight must be numeric if present
-      if (car.containsKey("weight") && !car["weight"].is<float>() && !car["weight"].is<int>()) {
-        server.send(400, "application/json", "{\"error\":\"weight must be numeric\"}");
-        return;
-      }
-      // Validate stats sub-object if present
-      if (car.containsKey("stats") && car["stats"].is<JsonObject>()) {
-        JsonObject stats = car["stats"].as<JsonObject>();
-        // bestTime: must be null or numeric
-        if (stats.containsKey("bestTime") && !stats["bestTime"].isNull()
-            && !stats["bestTime"].is<float>() && !stats["bestTime"].is<int>()) {
-          server.send(400, "application/json", "{\"error\":\"bestTime must be numeric or null\"}");
-          return;
-        }
-        // bestSpeed: must be numeric if present
-        if (stats.containsKey("bestSpeed") && !stats["bestSpeed"].isNull()
-            && !stats["bestSpeed"].is<float>() && !stats["bestSpeed"].is<int>()) {
-          server.send(400, "application/json", "{\"error\":\"bestSpeed must be numeric\"}");
-          return;
-        }
-      }
+    if (depth == 3 && inStats && type != JSON_TOK_NUMBER && type != JSON_TOK_NULL) {
+      if (keyIs(key, "bestTime")) return reject("bestTime must be numeric or null");
+      if (keyIs(key, "bestSpeed")) return reject("bestSpeed must be numeric");
     }
+    return true;
+  }
+private:
+  bool reject(const char* why) {
+    error = why;
+    return false;
+  }
+  bool inStats = false;
+};
 
-    // Valid — write to filesystem
-    File f = LittleFS.open("/garage.json", "w");
-    if (!f) {
-      server.send(500, "application/json", "{\"error\":\"Failed to write garage\"}");
-      return;
-    }
-    serializeJson(doc, f);
-    f.close();
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
+static GarageSchema garageSchema;
+static JsonStreamParser garageParser(garageSchema);
+
+static void handleApiGarage() {
+  if (LittleFS.exists(GARAGE_FILE)) {
+    serveFile(GARAGE_FILE, "application/json");
+  } else {
+    server.send(200, "application/json", "[]");
+  }
+}
+
+static void handleApiGarageUpload() {
+  spoolPostBody(garageParser, GARAGE_SPOOL);
+}
+
+static void handleApiGaragePost() {
+  if (!finishPostBody(garageParser, GARAGE_SPOOL)) return;
+  // Valid — rename over the old garage so a failed upload never truncates it
+  if (!LittleFS.rename(GARAGE_SPOOL, GARAGE_FILE)) {
+    LittleFS.remove(GARAGE_SPOOL);
+    server.send(500, "application/json", "{\"error\":\"Failed to write garage\"}");
+    return;
   }
+  server.send(200, "application/json", "{\"status\":\"ok\"}");
 }
 
 // ============================================================================
 // HISTORY API - Persistent race history on ESP32 filesystem
+// The finish gate appends each result itself (race_log.cpp).
+//   GET                      → whole log as an array, newest first (legacy shape)
+//   GET ?since=<seq>&limit=N → {"last_seq":N,"entries":[...]} oldest first
+//   POST                     → replace the log (imports, history page edits)
+//   DELETE                   → clear the log
 // POST validation: must be JSON array with valid numeric timing fields
 // ============================================================================
-static void handleApiHistory() {
-  if (server.method() == HTTP_GET) {
-    if (LittleFS.exists("/history.json")) {
-      File f = LittleFS.open("/history.json", "r");
-      String content = f.readString();
-      f.close();
-      server.send(200, "application/json", content);
-    } else {
-      server.send(200, "application/json", "[]");
+#define HISTORY_SPOOL     "/history.post.tmp"
+
+// Validates history entries and records where each one starts in the body,
+// so the import can re-read them one at a time (oldest = last in the array).
+class HistorySchema : public JsonSaxHandler {
+public:
+  uint32_t* offsets = nullptr;
+  uint32_t count = 0;
+
+  void release() {
+    free(offsets);
+    offsets = nullptr;
+    count = capacity = 0;
+  }
+  bool onStart(uint8_t depth, bool isArray, const char* key, uint32_t offset) override {
+    if (depth == 1) {
+      release();
+      return isArray ? true : reject("Must be array");
     }
-  }
-  else if (server.method() == HTTP_POST) {
-    if (!requireAuth()) return;
-    String body = server.arg("plain");
-    if (body.length() == 0) {
-      server.send(400, "application/json", "{\"error\":\"Empty body\"}");
-      return;
+    if (depth == 2) {
+      if (isArray) return reject("Array items must be objects");
+      return push(offset);
     }
-
-    // Validate JSON structure
-    DynamicJsonDocument doc(8192);
-    DeserializationError err = deserializeJson(doc, body);
-    if (err) {
-      server.send(400, "application/json", "{\"error\":\"Invalid JSON\"}");
-      return;
+    if (depth == 3) return checkField(key, JSON_TOK_STRING, 0, true);
+    return true;
+  }
+  bool onScalar(uint8_t depth, const char* key, JsonTokenType type, double number) override {
+    if (depth == 0) return reject("Must be array");
+    if (depth == 1) return reject("Array items must be objects");
+    if (depth == 2) return checkField(key, type, number, false);
+    return true;
+  }
+private:
+  bool reject(const char* why) {
+    error = why;
+    return false;
+  }
+  bool push(uint32_t offset) {
+    if (count == capacity) {
+      uint32_t cap = capacity ? capacity * 2 : RACE_LOG_INDEX_INITIAL;
+      size_t bytes = cap * sizeof(uint32_t);
+      void* p = psramFound() ? ps_realloc(offsets, bytes) : realloc(offsets, bytes);
+      if (!p) return reject("Too many entries for memory");
+      offsets = (uint32_t*)p;
+      capacity = cap;
     }
-    if (!doc.is<JsonArray>()) {
-      server.send(400, "application/json", "{\"error\":\"Must be array\"}");
-      return;
+    offsets[count++] = offset;
+    return true;
+  }
+  // Containers are passed in with isContainer so {"time":{...}} is rejected too
+  bool checkField(const char* key, JsonTokenType type, double number, bool isContainer) {
+    if (!key) return true;
+    if (strcmp(key, "time") == 0) {
+      if (isContainer || type != JSON_TOK_NUMBER) return reject("time must be numeric");
+      if (number <= 0 || number > 60.0) return reject("time out of range (0-60s)");
+      return true;
     }
-    JsonArray arr = doc.as<JsonArray>();
-    if (arr.size() > 100) {
-      server.send(400, "application/json", "{\"error\":\"Max 100 entries\"}");
-      return;
+    if (strcmp(key, "car") == 0) {
+      if (isContainer || type != JSON_TOK_STRING) return reject("car must be string");
+      return true;
+    }
+    static const char* const numFields[] = {"speed_mph", "speed_mps", "scale_mph", "momentum", "ke", "weight"};
+    static const char* const numErrors[] = {
+      "speed_mph must be numeric", "speed_mps must be numeric", "scale_mph must be numeric",
+      "momentum must be numeric", "ke must be numeric", "weight must be numeric"
+    };
+    for (int i = 0; i < 6; i++) {
+      if (strcmp(key, numFields[i]) != 0) continue;
+      if (isContainer || (type != JSON_TOK_NUMBER && type != JSON_TOK_NULL)) return reject(numErrors[i]);
+      return true;
     }
+    return true;
+  }
+  uint32_t capacity = 0;
+};
 
-    // Validate each history entry
-    for (JsonVariant item : arr) {
-      if (!item.is<JsonObject>()) {
-        server.send(400, "application/json", "{\"error\":\"Array items must be objects\"}");
-        return;
-      }
-      JsonObject entry = item.as<JsonObject>();
-      // time must be numeric and sane
-      if (entry.containsKey("time")) {
-        if (!entry["time"].is<float>() && !entry["time"].is<int>()) {
-          server.send(400, "application/json", "{\"error\":\"time must be numeric\"}");
-          return;
-        }
-        float t = entry["time"].as<float>();
-        if (t <= 0 || t > 60.0) {
-          server.send(400, "application/json", "{\"error\":\"time out of range (0-60s)\"}");
-          return;
-        }
-      }
-      // car must be string
-      if (entry.containsKey("car") && !entry["car"].is<const char*>()) {
-        server.send(400, "application/json", "{\"error\":\"car must be string\"}");
-        return;
-      }
-      // Numeric fields: reject strings
-      const char* numFields[] = {"speed_mph", "speed_mps", "scale_mph", "momentum", "ke", "weight"};
-      for (int i = 0; i < 6; i++) {
-        if (entry.containsKey(numFields[i]) && !entry[numFields[i]].isNull()
-            && !entry[numFields[i]].is<float>() && !entry[numFields[i]].is<int>()) {
-          String errMsg = "{\"error\":\"" + String(numFields[i]) + " must be numeric\"}";
-          server.send(400, "application/json", errMsg);
-          return;
-        }
+static HistorySchema historySchema;
+static JsonStreamParser historyParser(historySchema);
+
+static void handleApiHistory() {
+  if (server.method() == HTTP_GET) {
+    // Pin the window to what is logged now; sendHistoryBatches() takes the
+    // lock per batch
+    RaceLogCursor cur = { 0, 0, UINT32_MAX, true };
+    {
+      StorageLock lock;
+      cur.upTo = raceLogLastSeq();
+    }
+    ChunkedResponse out;
+    out.begin(200, "application/json");
+    if (server.hasArg("since")) {
+      cur.after = strtoul(server.arg("since").c_str(), nullptr, 10);
+      cur.limit = HISTORY_PAGE_DEFAULT;
+      if (server.hasArg("limit")) {
+        cur.limit = strtoul(server.arg("limit").c_str(), nullptr, 10);
+        if (cur.limit > HISTORY_PAGE_MAX) cur.limit = HISTORY_PAGE_MAX;
       }
+      cur.newestFirst = false;
+      out.printf("{\"last_seq\":%u,\"entries\":[", cur.upTo);
+      sendHistoryBatches(out, cur);
+      out.print("]}");
+    } else {
+      out.print('[');
+      sendHistoryBatches(out, cur);
+      out.print(']');
     }
+    out.end();
+  }
+  else if (server.method() == HTTP_DELETE) {
+    if (!requireAuth()) return;
+    StorageLock lock;   // The storage task appends races
+    raceLogClear();
+    leaderboardRebuild();
+    server.send(200, "application/json", "{\"status\":\"ok\"}");
+  }
+}
 
-    // Valid — write to filesystem
-    File f = LittleFS.open("/history.json", "w");
-    if (!f) {
-      server.send(500, "application/json", "{\"error\":\"Failed to write history\"}");
-      return;
+static void handleApiHistoryUpload() {
+  spoolPostBody(historyParser, HISTORY_SPOOL);
+}
+
+static void handleApiHistoryPost() {
+  if (!finishPostBody(historyParser, HISTORY_SPOOL)) {
+    historySchema.release();
+    return;
+  }
+
+  // Valid — rebuild the log from the spooled body, one entry in memory at a
+  // time. The array is newest first, so walk the recorded offsets backwards.
+  StorageLock lock;
+  File body = LittleFS.open(HISTORY_SPOOL, "r");
+  bool written = body && raceLogImportBegin();
+  for (uint32_t i = historySchema.count; written && i-- > 0;) {
+    DynamicJsonDocument entry(1024);
+    written = body.seek(historySchema.offsets[i]) &&
+              deserializeJson(entry, body) == DeserializationError::Ok &&
+              raceLogImportEntry(entry.as<JsonObjectConst>());
+  }
+  if (body) body.close();
+  LittleFS.remove(HISTORY_SPOOL);
+  historySchema.release();
+
+  if (written) {
+    written = raceLogImportCommit();
+  } else {
+    raceLogImportAbort();
+  }
+  if (written) leaderboardRebuild();
+  if (!written) {
+    server.send(500, "application/json", "{\"error\":\"Failed to write history\"}");
+    return;
+  }
+  server.send(200, "application/json", "{\"status\":\"ok\"}");
+}
+
+// ============================================================================
+// LEADERBOARD API - Server-maintained per-car stats (leaderboard.cpp)
+// ============================================================================
+static void handleApiLeaderboard() {
+  uint16_t k = server.hasArg("k") ? (uint16_t)server.arg("k").toInt() : LB_DEFAULT_K;
+  StreamString body;
+  {
+    StorageLock lock;
+    leaderboardWriteJson(body, k);
+  }
+  server.send(200, "application/json", body);
+}
+
+// Decode %XX and '+' in a path segment (WebServer only decodes query args)
+static String decodePathSegment(const String& in) {
+  String out;
+  out.reserve(in.length());
+  for (unsigned int i = 0; i < in.length(); i++) {
+    char c = in[i];
+    if (c == '%' && i + 2 < in.length()) {
+      char hex[3] = {in[i + 1], in[i + 2], '\0'};
+      out += (char)strtol(hex, nullptr, 16);
+      i += 2;
+    } else if (c == '+') {
+      out += ' ';
+    } else {
+      out += c;
     }
-    serializeJson(doc, f);
-    f.close();
-    server.send(200, "application/json", "{\"status\":\"ok\"}");
   }
+  return out;
+}
+
+static void handleApiCarStats() {
+  String name = decodePathSegment(server.pathArg(0));
+  StreamString body;
+  bool found;
+  {
+    StorageLock lock;
+    found = leaderboardWriteCarJson(body, name.c_str());
+  }
+  if (!found) {
+    server.send(404, "application/json", "{\"error\":\"Unknown car\"}");
+    return;
+  }
+  server.send(200, "application/json", body);
 }
 
 // ============================================================================
@@ -1220,6 +1658,7 @@ static void handleApiAudioList() {
     return;
   }
   String json = "{\"enabled\":true,\"playing\":" + String(isPlaying() ? "true" : "false") +
+                ",\"scheduled\":" + String(audioCuesScheduled()) +
                 ",\"volume\":" + String(cfg.audio_volume) +
                 ",\"files\":" + getAudioFileList() + "}";
   server.send(200, "application/json", json);
@@ -1231,15 +1670,45 @@ static void handleApiAudioTest() {
     return;
   }
   String body = server.arg("plain");
-  StaticJsonDocument<128> doc;
+  StaticJsonDocument<192> doc;
   deserializeJson(doc, body);
   const char* file = doc["file"] | "finish.wav";
-  playSound(file);
-  server.send(200, "application/json", "{\"status\":\"ok\",\"playing\":\"" + String(file) + "\"}");
+  uint8_t priority = doc["priority"] | (uint8_t)AUDIO_PRIO_NORMAL;
+  if (priority > AUDIO_PRIO_HIGH) priority = AUDIO_PRIO_HIGH;
+  int8_t voice = doc["voice"] | (int8_t)AUDIO_VOICE_ANY;
+
+  // Scheduled: at_us (fleet clock) or delay_ms from now; fleet=true also
+  // schedules it on every paired peer. The reply carries at_us, so a client
+  // can lay out a countdown as at_us + n * interval.
+  uint64_t atUs = doc["at_us"] | (uint64_t)0;
+  uint32_t delayMs = doc["delay_ms"] | (uint32_t)0;
+  bool fleet = doc["fleet"] | false;
+  if (atUs == 0 && (delayMs > 0 || fleet)) atUs = fleetNowUs() + (uint64_t)delayMs * 1000;
+  if (atUs == 0) {
+    playSound(file, (AudioPriority)priority, voice);
+    server.send(200, "application/json", "{\"status\":\"ok\",\"playing\":\"" + String(file) + "\"}");
+    return;
+  }
+
+  playSoundAt(file, atUs, (AudioPriority)priority, voice);
+  int sent = fleet ? sendAudioCueAll(file, atUs, priority, voice) : 0;
+  char buf[160];
+  PrintBuffer pb(buf, sizeof(buf));
+  JsonWriter w(pb);
+  w.beginObject()
+   .field("status", "ok")
+   .field("scheduled", file)
+   .field("at_us", atUs)
+   .field("peers", sent)
+   .field("synced", fleetClockSynced())
+   .endObject();
+  server.send(200, "application/json", buf);
 }
 
 static void handleApiAudioStop() {
-  stopSound();
+  StaticJsonDocument<64> doc;
+  deserializeJson(doc, server.arg("plain"));
+  stopSound(doc["voice"] | (int8_t)AUDIO_VOICE_ANY);
   server.send(200, "application/json", "{\"status\":\"ok\"}");
 }
 
@@ -1259,26 +1728,60 @@ static void handleApiAudioVolume() {
 // LIDAR SENSOR API - Live readout for config page
 // ============================================================================
 static void handleApiLidarStatus() {
-  StaticJsonDocument<128> doc;
-  doc["enabled"] = cfg.lidar_enabled;
+  char buf[128];
+  PrintBuffer pb(buf, sizeof(buf));
+  JsonWriter w(pb);
+  w.beginObject().field("enabled", cfg.lidar_enabled);
   if (cfg.lidar_enabled) {
     LidarState ls = getLidarState();
-    doc["state"] = (ls == LIDAR_NO_CAR) ? "empty" :
-                   (ls == LIDAR_CAR_STAGED) ? "staged" : "launched";
-    doc["distance_mm"] = getDistanceMM();
-    doc["threshold_mm"] = cfg.lidar_threshold_mm;
+    w.field("state", (ls == LIDAR_NO_CAR) ? "empty" :
+                     (ls == LIDAR_CAR_STAGED) ? "staged" : "launched")
+     .field("distance_mm", getDistanceMM())
+     .field("threshold_mm", cfg.lidar_threshold_mm);
   }
-  String output;
-  serializeJson(doc, output);
-  server.send(200, "application/json", output);
+  w.endObject();
+  sendJsonBuffer(pb);
 }
 
 // ============================================================================
 // SERIAL LOG API - Web-viewable serial monitor
+//   GET                → everything still in the ring
+//   GET ?since=<seq>   → only records logged after the client's cursor
+//   GET ?level=<1-4>   → only records at or above that severity (1 = errors)
+// X-Log-Start is the seq of the first record returned (> since means records
+// were dropped) and X-Log-Seq is the cursor to send next time.
 // ============================================================================
 static void handleApiLog() {
   if (server.method() == HTTP_GET) {
-    server.send(200, "text/plain", serialTee.getLog());
+    uint32_t cursor = server.hasArg("since") ? strtoul(server.arg("since").c_str(), nullptr, 10) : 0;
+    uint8_t maxLevel = LOG_LVL_DEBUG;
+    if (server.hasArg("level")) {
+      maxLevel = constrain(server.arg("level").toInt(), LOG_LVL_ERROR, LOG_LVL_DEBUG);
+    }
+    uint32_t end = serialTee.nextSeq();
+    // Formatting nothing just clamps the cursor to what the ring still holds
+    serialTee.format(cursor, nullptr, 0);
+    server.sendHeader("X-Log-Start", String(cursor));
+    server.sendHeader("X-Log-Seq", String(end));
+    server.sendHeader("Cache-Control", "no-store");
+    ChunkedResponse out;
+    out.begin(200, "text/plain");
+    // Timestamps are formatted here, on the reader's time, not the logger's
+    char chunk[512];
+    uint8_t waits = 0;
+    while ((int32_t)(end - cursor) > 0) {
+      uint16_t records = 0;
+      size_t n = serialTee.format(cursor, chunk, sizeof(chunk), &records, maxLevel, end);
+      if (records == 0) {
+        // A producer holds a ticket below `end` but hasn't published yet —
+        // that takes microseconds, so give it a moment rather than skip it
+        if (++waits > 5) break;
+        delay(1);
+        continue;
+      }
+      out.write((const uint8_t*)chunk, n);
+    }
+    out.end();
   }
   else if (server.method() == HTTP_DELETE) {
     if (!requireAuth()) return;
@@ -1287,6 +1790,63 @@ static void handleApiLog() {
   }
 }
 
+// ============================================================================
+// RUN LOG CSV — /runs.csv rendered from /runs.bin on request
+// ============================================================================
+static void handleRunsCsv() {
+  server.sendHeader("Content-Disposition", "attachment; filename=\"runs.csv\"");
+  server.sendHeader("Cache-Control", "no-store");
+  ChunkedResponse out;
+  out.begin(200, "text/csv");
+
+  // Format a batch under the lock, then send it with the lock released, so
+  // a slow client doesn't hold up the storage task for the whole download
+  char rows[RUN_CSV_BATCH * RUN_CSV_ROW_MAX];
+  uint32_t next = 0;
+  for (;;) {
+    PrintBuffer pb(rows, sizeof(rows));
+    bool more;
+    {
+      StorageLock lock;
+      more = runLogWriteCsv(pb, next);
+    }
+    if (pb.overflowed()) LOG.println("[WEB] runs.csv batch overflowed its buffer, rows cut");
+    out.write((const uint8_t*)pb.c_str(), pb.length());
+    if (!more) break;
+  }
+  out.end();
+}
+
+// ============================================================================
+// METRICS — Prometheus text exposition for fleet scraping
+// ============================================================================
+static void handleMetrics() {
+  ChunkedResponse out;
+  out.begin(200, "text/plain; version=0.0.4");
+  metricsWrite(out);
+  out.end();
+}
+
+// Counts requests for registered routes by path for /metrics. Added ahead
+// of every route and never claims a request: WebServer asks each handler in
+// turn until one accepts, so this one sees each request exactly once. A path
+// no handler after it accepts is left to the onNotFound catch-all to count,
+// so arbitrary URLs can't take route slots.
+class RequestCounter : public RequestHandler {
+public:
+  bool canHandle(HTTPMethod method, const String& uri) override {
+    bool routed = false;
+    for (RequestHandler* h = next(); h && !routed; h = h->next()) {
+      routed = h->canHandle(method, uri);
+    }
+    if (!routed) return false;
+    // Per-car stats URLs would otherwise each get their own series
+    if (uri.startsWith("/api/cars/")) metricsCountRequest("/api/cars/{}/stats");
+    else metricsCountRequest(uri.c_str());
+    return false;
+  }
+};
+
 // ============================================================================
 // FILESYSTEM API - Browse, read, and write LittleFS files from the web
 // ============================================================================
@@ -1351,8 +1911,10 @@ static void handleApiFiles() {
       server.send(500, "application/json", "{\"error\":\"Failed to open file for writing\"}");
       return;
     }
-    f.print(body);
+    metricInc(MET_FS_BYTES_WRITTEN, f.print(body));
     f.close();
+    if (path == CONFIG_FILE) configInvalidateImage();   // Hand-edited config wins at next boot
+    if (path.endsWith(".wav")) audioInvalidateClip(path.c_str());
     server.send(200, "application/json", "{\"status\":\"ok\",\"size\":" + String(body.length()) + "}");
   }
   else if (server.method() == HTTP_DELETE) {
@@ -1368,6 +1930,7 @@ static void handleApiFiles() {
       return;
     }
     if (LittleFS.remove(path)) {
+      if (path.endsWith(".wav")) audioInvalidateClip(path.c_str());
       server.send(200, "application/json", "{\"status\":\"ok\"}");
     } else {
       server.send(404, "application/json", "{\"error\":\"File not found or delete failed\"}");
@@ -1382,12 +1945,13 @@ static void handleApiFiles() {
 // ============================================================================
 static void handleApiAuthInfo() {
   // No auth required — client uses this to decide which gates to show
-  String json = "{\"hasViewerPassword\":";
-  json += (strlen(cfg.viewer_password) > 0) ? "true" : "false";
-  json += ",\"hasAdminPassword\":";
-  json += (strlen(cfg.ota_password) > 0) ? "true" : "false";
-  json += "}";
-  server.send(200, "application/json", json);
+  char buf[64];
+  PrintBuffer pb(buf, sizeof(buf));
+  JsonWriter(pb).beginObject()
+    .field("hasViewerPassword", strlen(cfg.viewer_password) > 0)
+    .field("hasAdminPassword", strlen(cfg.ota_password) > 0)
+    .endObject();
+  sendJsonBuffer(pb);
 }
 
 static void handleApiAuthCheck() {
@@ -1430,13 +1994,14 @@ static void handleApiAuthCheck() {
 
 // GET /api/firmware/status — Current update status
 static void handleFirmwareStatus() {
-  StaticJsonDocument<256> doc;
-  doc["updating"] = (bool)firmwareUpdateInProgress;
-  doc["scheduled"] = (bool)firmwareUpdateScheduled;
-  doc["message"] = firmwareUpdateStatus;
-  String json;
-  serializeJson(doc, json);
-  server.send(200, "application/json", json);
+  char buf[256];
+  PrintBuffer pb(buf, sizeof(buf));
+  JsonWriter(pb).beginObject()
+    .field("updating", (bool)firmwareUpdateInProgress)
+    .field("scheduled", (bool)firmwareUpdateScheduled)
+    .field("message", firmwareUpdateStatus)
+    .endObject();
+  sendJsonBuffer(pb);
 }
 
 // POST /api/firmware/update-from-url — Schedule GitHub download (primary flow)
@@ -1646,6 +2211,9 @@ void initWebServer() {
   const char* headerKeys[] = {"X-API-Key"};
   server.collectHeaders(headerKeys, 1);
 
+  // Must be the first handler — see RequestCounter
+  server.addHandler(new RequestCounter());
+
   // Main page: serve role-appropriate page
   // v2.5.0: Prefer LittleFS files, fall back to PROGMEM if missing
   // Finish gate gets the full dashboard (garage, history, physics)
@@ -1720,14 +2288,24 @@ void initWebServer() {
   server.on("/api/wifi-status", HTTP_GET, handleApiWifiStatus);
   server.on("/api/version", HTTP_GET, handleApiVersion);
   server.on("/api/diagnostics", HTTP_GET, handleApiDiagnostics);
+  server.on("/api/diagnostics/reset", HTTP_POST, handleApiDiagnosticsReset);
+  server.on("/api/diagnostics/heap", HTTP_GET, handleApiHeap);
+  server.on("/api/diagnostics/heap/reset", HTTP_POST, handleApiHeapReset);
+  server.on("/api/diagnostics/heap/soak", HTTP_POST, handleApiHeapSoak);
+  server.on("/api/diagnostics/heap/soak", HTTP_DELETE, handleApiHeapSoak);
+  server.on("/metrics", HTTP_GET, handleMetrics);
   server.on("/api/peers", HTTP_GET, handleApiPeers);
   server.on("/api/peers/forget", HTTP_POST, handleApiPeersForget);
   server.on("/api/peers/share-wifi", HTTP_POST, handleApiShareWifi);
   server.on("/api/peers/command", HTTP_POST, handleApiPeerCommand);
   server.on("/api/garage", HTTP_GET, handleApiGarage);
-  server.on("/api/garage", HTTP_POST, handleApiGarage);
+  server.on("/api/garage", HTTP_POST, handleApiGaragePost, handleApiGarageUpload);
   server.on("/api/history", HTTP_GET, handleApiHistory);
-  server.on("/api/history", HTTP_POST, handleApiHistory);
+  server.on("/api/history", HTTP_POST, handleApiHistoryPost, handleApiHistoryUpload);
+  server.on("/api/history", HTTP_DELETE, handleApiHistory);
+  server.on("/api/leaderboard", HTTP_GET, handleApiLeaderboard);
+  server.on("/runs.csv", HTTP_GET, handleRunsCsv);
+  server.on(UriBraces("/api/cars/{}/stats"), HTTP_GET, handleApiCarStats);
 
   // Audio API
   server.on("/api/audio/list", HTTP_GET, handleApiAudioList);
@@ -1809,7 +2387,10 @@ void initWebServer() {
 
   server.on("/api/telemetry/info", HTTP_GET, []() {
     if (!requireAuth()) return;
-    server.send(200, "application/json", getTelemetryInfoJson());
+    char buf[256];
+    PrintBuffer pb(buf, sizeof(buf));
+    writeTelemetryInfoJson(pb);
+    sendJsonBuffer(pb);
   });
 
   // Static CSS/JS assets from LittleFS with cache headers
@@ -1829,12 +2410,15 @@ void initWebServer() {
     serveFile("/history.html", "text/html");
   });
 
-  // Catch-all: try to serve from LittleFS
+  // Catch-all: try to serve from LittleFS. Counted here rather than by
+  // RequestCounter — only files that exist get a route of their own.
   server.onNotFound([]() {
     String path = server.uri();
     if (LittleFS.exists(path)) {
+      metricsCountRequest(path.c_str());
       serveFile(path, getContentType(path));
     } else {
+      metricsCountNotFound();
       server.send(404, "text/plain", "Not found");
     }
   });